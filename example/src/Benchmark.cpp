@@ -0,0 +1,444 @@
+#include "HyperHistogram.h"
+#include "HyperBinningAlgorithms.h"
+
+#include "TRandom3.h"
+#include "TH1D.h"
+#include "TSystem.h"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <chrono>
+#include <sys/resource.h>
+
+typedef std::chrono::steady_clock Clock;
+
+
+///Generates synthetic datasets, either uniform in the unit
+///HyperCuboid, or a mixture of Gaussians inside it.
+class DatasetGenerator{
+
+  int        _dim;
+  bool       _gaussian;
+  TRandom3   _random;
+
+  std::vector<HyperPoint> _means;
+  std::vector<double>     _widths;
+
+  public:
+
+  DatasetGenerator(int dim, bool gaussian, int seed, int nComponents = 4) :
+    _dim(dim),
+    _gaussian(gaussian),
+    _random(seed)
+  {
+    for (int c = 0; c < nComponents; c++){
+      HyperPoint mean(dim);
+      for (int i = 0; i < dim; i++) mean.at(i) = _random.Uniform(0.2, 0.8);
+      _means .push_back(mean);
+      _widths.push_back(_random.Uniform(0.05, 0.15));
+    }
+  }
+
+  ///Make a point inside the unit HyperCuboid
+  HyperPoint generate(){
+
+    HyperPoint point(_dim);
+
+    if (_gaussian == false){
+      for (int i = 0; i < _dim; i++) point.at(i) = _random.Rndm();
+      return point;
+    }
+
+    int component = _random.Integer(_means.size());
+
+    for (int i = 0; i < _dim; i++){
+      double val = -1.0;
+      while (val <= 0.0 || val > 1.0) val = _random.Gaus(_means.at(component).at(i), _widths.at(component));
+      point.at(i) = val;
+    }
+
+    return point;
+  }
+
+  ///Replace the points in the set with nPoints new ones
+  void generate(HyperPointSet& points, int nPoints){
+    points.clear();
+    points.reserve(nPoints);
+    for (int i = 0; i < nPoints; i++) points.push_back( generate() );
+  }
+
+};
+
+
+///Collects the benchmark results, and writes them as JSON
+///
+class BenchmarkResults{
+
+  std::vector<std::string> _results;
+
+  public:
+
+  ///Peak resident set size of the process so far (in MB)
+  static double getPeakRSS(){
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss/1024.0;
+  }
+
+  ///Record the time taken to process nItems items (points, bins, ...)
+  void add(TString dataset, int dim, Long64_t nPoints, int nBins, TString test, double seconds, Long64_t nItems){
+
+    double throughput = seconds > 0.0 ? nItems/seconds : 0.0;
+
+    std::ostringstream result;
+    result << "    {\"dataset\": \"" << dataset << "\", \"dim\": " << dim << ", \"nPoints\": " << nPoints;
+    result << ", \"nBins\": " << nBins << ", \"test\": \"" << test << "\", \"seconds\": " << seconds;
+    result << ", \"items\": " << nItems << ", \"itemsPerSecond\": " << throughput;
+    result << ", \"peakRSSMB\": " << getPeakRSS() << "}";
+
+    _results.push_back(result.str());
+
+    INFO_LOG << dataset << " dim=" << dim << " nPoints=" << nPoints << " nBins=" << nBins << " " << test;
+    INFO_LOG << ": " << seconds << " s (" << throughput << " items/s)" << std::endl;
+
+  }
+
+  ///Write all the results to a JSON file
+  void write(TString filename) const{
+
+    std::ofstream file(filename.Data());
+
+    if (file.is_open() == false){
+      ERROR_LOG << "Cannot open " << filename << " to write the benchmark results" << std::endl;
+      return;
+    }
+
+    file << "{" << std::endl;
+    file << "  \"benchmark\": \"HyperPlot\"," << std::endl;
+    file << "  \"results\": [" << std::endl;
+    for (unsigned i = 0; i < _results.size(); i++){
+      file << _results.at(i) << (i + 1 == _results.size() ? "" : ",") << std::endl;
+    }
+    file << "  ]" << std::endl;
+    file << "}" << std::endl;
+
+    INFO_LOG << "Written " << _results.size() << " benchmark results to " << filename << std::endl;
+
+  }
+
+};
+
+
+///Seconds since start
+///
+double SecondsSince(Clock::time_point start){
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+///Does the comma seperated list of tests contain this one
+///
+bool RunTest(TString tests, TString test){
+  if (tests == "all") return true;
+  return ("," + tests + ",").Contains("," + test + ",");
+}
+
+///Time getBinNum (one point at a time, and for a whole HyperPointSet)
+///and HyperHistogram::fill for nPoints points. The points are made
+///in chunks, which aren't included in the timing.
+void BenchmarkLookupAndFill(BenchmarkResults& results, TString tests, TString dataset, HyperHistogram& hist,
+                            DatasetGenerator& generator, Long64_t nPoints, int chunkSize){
+
+  int dim   = hist.getDimension();
+  int nBins = hist.getNBins();
+
+  const BinningBase& binning = hist.getBinning();
+
+  double singleSeconds  = 0.0;
+  double batchedSeconds = 0.0;
+  double fillSeconds    = 0.0;
+
+  HyperPointSet points(dim);
+
+  for (Long64_t done = 0; done < nPoints; done += chunkSize){
+
+    int nChunk = std::min(Long64_t(chunkSize), nPoints - done);
+    generator.generate(points, nChunk);
+
+    if (RunTest(tests, "lookup")){
+      Clock::time_point start = Clock::now();
+      Long64_t sum = 0;
+      for (int i = 0; i < nChunk; i++) sum += binning.getBinNum(points.at(i));
+      singleSeconds += SecondsSince(start);
+      VERBOSE_LOG << "Sum of bin numbers " << sum << std::endl;
+
+      start = Clock::now();
+      std::vector<int> binNums = binning.getBinNum(points);
+      batchedSeconds += SecondsSince(start);
+    }
+
+    if (RunTest(tests, "fill")){
+      Clock::time_point start = Clock::now();
+      hist.fill(points);
+      fillSeconds += SecondsSince(start);
+    }
+
+  }
+
+  if (RunTest(tests, "lookup")){
+    results.add(dataset, dim, nPoints, nBins, "getBinNum"       , singleSeconds , nPoints);
+    results.add(dataset, dim, nPoints, nBins, "getBinNumBatched", batchedSeconds, nPoints);
+  }
+  if (RunTest(tests, "fill")){
+    results.add(dataset, dim, nPoints, nBins, "fill", fillSeconds, nPoints);
+  }
+
+}
+
+///Time each of the binning algorithms (apart from FUNC_PHASE,
+///which needs a function rather than data)
+void BenchmarkAlgorithms(BenchmarkResults& results, TString dataset, const HyperPointSet& points,
+                         const HyperPointSet& shadowPoints, double minBinContent){
+
+  int dim = points.getDimension();
+  HyperCuboid limits(dim, 0.0, 1.0);
+
+  HyperBinningAlgorithms::Alg algs[8] = {
+    HyperBinningAlgorithms::SMART,
+    HyperBinningAlgorithms::MINT,
+    HyperBinningAlgorithms::MINT_SMART,
+    HyperBinningAlgorithms::MINT_RANDOM,
+    HyperBinningAlgorithms::SMART_RANDOM,
+    HyperBinningAlgorithms::LIKELIHOOD,
+    HyperBinningAlgorithms::SMART_LIKELIHOOD,
+    HyperBinningAlgorithms::SMART_MULTI
+  };
+
+  TString names[8] = {"SMART", "MINT", "MINT_SMART", "MINT_RANDOM", "SMART_RANDOM", "LIKELIHOOD", "SMART_LIKELIHOOD", "SMART_MULTI"};
+
+  for (int a = 0; a < 8; a++){
+
+    Clock::time_point start = Clock::now();
+
+    HyperHistogram hist(limits, points, algs[a],
+      AlgOption::MinBinContent      (minBinContent),
+      AlgOption::MinShadowBinContent(minBinContent),
+      AlgOption::UseShadowData      (shadowPoints),
+      AlgOption::RandomSeed         (1)
+    );
+
+    double seconds = SecondsSince(start);
+
+    results.add(dataset, dim, points.size(), hist.getNBins(), "build_" + names[a], seconds, points.size());
+  }
+
+}
+
+///Time saving and loading a HyperHistogram, then loading it as
+///memory and disk resident, and looking up bin numbers in each
+void BenchmarkIO(BenchmarkResults& results, TString dataset, HyperHistogram& hist, const HyperPointSet& points,
+                 Long64_t nPoints, TString outputdir){
+
+  int dim   = hist.getDimension();
+  int nBins = hist.getNBins();
+
+  TString filename        = outputdir + "benchmark_" + dataset + ".root";
+  TString compactFilename = outputdir + "benchmark_" + dataset + "_compact.root";
+
+  Clock::time_point start = Clock::now();
+  hist.save(filename);
+  results.add(dataset, dim, nPoints, nBins, "save", SecondsSince(start), nBins);
+
+  start = Clock::now();
+  hist.saveCompact(compactFilename);
+  results.add(dataset, dim, nPoints, nBins, "saveCompact", SecondsSince(start), nBins);
+
+  TString files  [3] = {filename     , compactFilename, filename    };
+  TString options[3] = {"MEMRES READ", "MEMRES READ"  , "DISK READ" };
+  TString names  [3] = {"MemRes"     , "MemResCompact", "DiskRes"   };
+
+  for (int f = 0; f < 3; f++){
+
+    start = Clock::now();
+    HyperHistogram loaded(files[f], options[f]);
+    results.add(dataset, dim, nPoints, nBins, "load" + names[f], SecondsSince(start), nBins);
+
+    start = Clock::now();
+    std::vector<int> binNums = loaded.getBinning().getBinNum(points);
+    results.add(dataset, dim, nPoints, nBins, "getBinNumBatched" + names[f], SecondsSince(start), points.size());
+  }
+
+}
+
+///Time projections, slices and drawing a 2D slice
+///
+void BenchmarkPlotting(BenchmarkResults& results, TString tests, TString dataset, const HyperHistogram& hist,
+                       Long64_t nPoints, TString outputdir){
+
+  int dim   = hist.getDimension();
+  int nBins = hist.getNBins();
+
+  HyperPoint slicePoint(dim, 0.5);
+
+  if (RunTest(tests, "project")){
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < dim; i++){
+      TString name = "projection"; name += i;
+      TH1D projection = hist.project(i, 100, name);
+    }
+    results.add(dataset, dim, nPoints, nBins, "project", SecondsSince(start), Long64_t(nBins)*dim);
+  }
+
+  if (RunTest(tests, "slice") && dim > 2){
+    std::vector<int> sliceDims;
+    for (int i = 2; i < dim; i++) sliceDims.push_back(i);
+
+    Clock::time_point start = Clock::now();
+    HyperHistogram sliced = hist.slice(sliceDims, slicePoint);
+    results.add(dataset, dim, nPoints, nBins, "slice", SecondsSince(start), nBins);
+  }
+
+  if (RunTest(tests, "plot")){
+    Clock::time_point start = Clock::now();
+    hist.draw2DSlice(outputdir + "benchmark_" + dataset + "_slice", 0, 1, slicePoint);
+    results.add(dataset, dim, nPoints, nBins, "draw2DSlice", SecondsSince(start), nBins);
+  }
+
+}
+
+void PrintHelp(){
+
+  INFO_LOG << "------------ HELP ------------" << std::endl;
+
+  INFO_LOG << "Times bin lookups, filling, the binning algorithms, saving/loading, " << std::endl;
+  INFO_LOG << "projections, slices and plotting on synthetic datasets, and writes the " << std::endl;
+  INFO_LOG << "results (time, throughput and peak RSS) to a JSON file." << std::endl;
+
+  INFO_LOG << std::endl;
+  std::cout << "--min-dim, --max-dim" << std::endl << std::endl;
+  INFO_LOG << "Range of dimensions to use (2 to 8 by default)" << std::endl;
+
+  INFO_LOG << std::endl;
+  std::cout << "--min-points, --max-points" << std::endl << std::endl;
+  INFO_LOG << "Range of dataset sizes, in steps of x10 (10^4 to 10^6 by default)" << std::endl;
+
+  INFO_LOG << std::endl;
+  std::cout << "--build-points" << std::endl << std::endl;
+  INFO_LOG << "Maximum number of points used to build binnings (10^5 by default)" << std::endl;
+
+  INFO_LOG << std::endl;
+  std::cout << "--min-bin-content" << std::endl << std::endl;
+  INFO_LOG << "Minimum bin content given to the binning algorithms (25 by default)" << std::endl;
+
+  INFO_LOG << std::endl;
+  std::cout << "--dataset" << std::endl << std::endl;
+  INFO_LOG << "gaussian, uniform or all (the default)" << std::endl;
+
+  INFO_LOG << std::endl;
+  std::cout << "--tests" << std::endl << std::endl;
+  INFO_LOG << "Comma seperated list from lookup, fill, build, io, project, slice, plot" << std::endl;
+  INFO_LOG << "(all by default)" << std::endl;
+
+  INFO_LOG << std::endl;
+  std::cout << "--output" << std::endl << std::endl;
+  INFO_LOG << "JSON file for the results (benchmark.json by default)" << std::endl;
+
+  INFO_LOG << std::endl << std::endl;
+
+}
+
+
+int main(int argc, char** argv) {
+
+  Plotter::s_imageformat = ".pdf";
+
+  bool help = 0;
+
+  int      minDim        = 2;
+  int      maxDim        = 8;
+  Long64_t minPoints     = 10000;
+  Long64_t maxPoints     = 1000000;
+  int      buildPoints   = 100000;
+  double   minBinContent = 25.0;
+  int      seed          = 1;
+  TString  datasets      = "all";
+  TString  tests         = "all";
+  TString  output        = "benchmark.json";
+
+  for(int i = 1; i<argc; i=i+2){
+
+    if       (std::string(argv[i])=="--help"            ) { help          =  1  ; i--; }
+    else if  (std::string(argv[i])=="--min-dim"         ) { minDim        =  atoi(argv[i+1]); }
+    else if  (std::string(argv[i])=="--max-dim"         ) { maxDim        =  atoi(argv[i+1]); }
+    else if  (std::string(argv[i])=="--min-points"      ) { minPoints     =  atof(argv[i+1]); }
+    else if  (std::string(argv[i])=="--max-points"      ) { maxPoints     =  atof(argv[i+1]); }
+    else if  (std::string(argv[i])=="--build-points"    ) { buildPoints   =  atof(argv[i+1]); }
+    else if  (std::string(argv[i])=="--min-bin-content" ) { minBinContent =  atof(argv[i+1]); }
+    else if  (std::string(argv[i])=="--seed"            ) { seed          =  atoi(argv[i+1]); }
+    else if  (std::string(argv[i])=="--dataset"         ) { datasets      =  argv[i+1]; }
+    else if  (std::string(argv[i])=="--tests"           ) { tests         =  argv[i+1]; }
+    else if  (std::string(argv[i])=="--output"          ) { output        =  argv[i+1]; }
+
+    else {
+      std::cout << "Entered invalid argument " << argv[i] << std::endl;
+      return 0;
+    }
+  }
+
+  if (help) {
+    PrintHelp();
+    return 0;
+  }
+
+  TString outputdir = "Benchmark/";
+  gSystem->Exec("mkdir -p " + outputdir);
+
+  BenchmarkResults results;
+
+  std::vector<TString> datasetNames;
+  if (datasets == "all" || datasets == "gaussian") datasetNames.push_back("gaussian");
+  if (datasets == "all" || datasets == "uniform" ) datasetNames.push_back("uniform" );
+
+  for (unsigned d = 0; d < datasetNames.size(); d++){
+  for (int dim = minDim; dim <= maxDim; dim++){
+  for (Long64_t nPoints = minPoints; nPoints <= maxPoints && nPoints > 0; nPoints *= 10){
+
+    TString dataset = datasetNames.at(d);
+    DatasetGenerator generator(dim, dataset == "gaussian", seed);
+
+    //the binnings are built from (at most) buildPoints points
+    HyperPointSet buildSet (dim);
+    HyperPointSet shadowSet(dim);
+    generator.generate(buildSet , std::min(Long64_t(buildPoints), nPoints));
+    generator.generate(shadowSet, buildSet.size());
+
+    if (RunTest(tests, "build")){
+      BenchmarkAlgorithms(results, dataset, buildSet, shadowSet, minBinContent);
+    }
+
+    HyperHistogram hist(HyperCuboid(dim, 0.0, 1.0), buildSet, HyperBinningAlgorithms::MINT,
+      AlgOption::MinBinContent(minBinContent)
+    );
+
+    if (RunTest(tests, "lookup") || RunTest(tests, "fill")){
+      BenchmarkLookupAndFill(results, tests, dataset, hist, generator, nPoints, 1000000);
+    }
+
+    if (RunTest(tests, "io")){
+      BenchmarkIO(results, dataset, hist, buildSet, nPoints, outputdir);
+    }
+
+    BenchmarkPlotting(results, tests, dataset, hist, nPoints, outputdir);
+
+  }
+  }
+  }
+
+  results.write(output);
+
+  //This will print out how many errors have occured in HyperPlot.
+  ERROR_COUNT
+
+  return 0;
+
+}
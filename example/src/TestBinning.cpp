@@ -10,6 +10,8 @@
 
 #include <iostream>
 #include <vector>
+#include <deque>
+#include <chrono>
 
 
 ///This class returns a phase at every point in
@@ -457,6 +459,143 @@ void FunctionBinningExample(int dim, int functionNum, int nbinpairs){
 }
 
 
+///Make a HyperBinningMemRes with nBins bins by repeatedly splitting
+///the unit HyperCuboid in half (cycling through the dimensions), in
+///the same way as the binning algorithms build the bin hierarchy.
+HyperBinningMemRes MakeSplitBinning(int dim, int nBins){
+
+  std::vector<HyperCuboid>        cuboids (1, HyperCuboid(dim, 0.0, 1.0));
+  std::vector< std::vector<int> > links   (1);
+  std::vector<int>                depths  (1, 0);
+  std::deque<int>                 toSplit (1, 0);
+
+  int nLeaves = 1;
+
+  while (nLeaves < nBins){
+    int vol = toSplit.front();
+    toSplit.pop_front();
+
+    HyperVolume halves = cuboids.at(vol).split(depths.at(vol) % dim, 0.5);
+
+    for (int i = 0; i < 2; i++){
+      links.at(vol).push_back(cuboids.size());
+      toSplit.push_back(cuboids.size());
+      depths .push_back(depths.at(vol) + 1);
+      cuboids.push_back(halves.at(i));
+      links  .push_back(std::vector<int>());
+    }
+
+    nLeaves++;
+  }
+
+  HyperBinningMemRes binning;
+  binning.reserveCapacity(cuboids.size());
+
+  for (unsigned i = 0; i < cuboids.size(); i++){
+    binning.addHyperVolume(HyperVolume(cuboids.at(i)), links.at(i));
+  }
+  binning.addPrimaryVolumeNumber(0);
+
+  return binning;
+
+}
+
+///Time how long it takes to load HyperHistograms with 10^4 to 
+///maxBins bins, saved in both the usual and the compact format.
+void LoadBenchmark(int dim, int maxBins){
+
+  typedef std::chrono::steady_clock Clock;
+
+  TString outputdir = "LoadBenchmark/";
+  gSystem->Exec("mkdir " + outputdir);
+
+  INFO_LOG << "nBins, format, file size (MB), load time (s)" << std::endl;
+
+  for (int nBins = 10000; nBins <= maxBins && nBins > 0; nBins *= 10){
+
+    TString filename        = outputdir + "hist_"; filename += nBins; filename += ".root";
+    TString compactFilename = outputdir + "hist_"; compactFilename += nBins; compactFilename += "_compact.root";
+
+    {
+      HyperHistogram hist( MakeSplitBinning(dim, nBins) );
+      for (int i = 0; i < hist.getNBins(); i++) hist.setBinContent(i, gRandom->Poisson(100.0));
+      hist.save       (filename       );
+      hist.saveCompact(compactFilename);
+    }
+
+    TString files  [2] = {filename, compactFilename};
+    TString formats[2] = {"full", "compact"};
+
+    for (int f = 0; f < 2; f++){
+      Clock::time_point start = Clock::now();
+      HyperHistogram hist(files[f]);
+      double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+      FileStat_t stat;
+      gSystem->GetPathInfo(files[f], stat);
+
+      INFO_LOG << nBins << ", " << formats[f] << ", " << stat.fSize/(1024.0*1024.0) << ", " << seconds << std::endl;
+    }
+
+  }
+
+}
+
+///Check that integrating over a region gives the same integral and
+///error with the hierarchy aggregates (a HyperBinning) as bin by bin
+///(a UniformBinning with the same bins). Returns the number of regions
+///where they disagree.
+int IntegralCheck(int dim, int nRegions = 100){
+
+  int nLocalBins = 4;
+  int nBins      = 1;
+  for (int d = 0; d < dim; d++) nBins *= nLocalBins;
+
+  //splitting in half, cycling through the dimensions, gives the same bins
+  HyperCuboid    limits(dim, 0.0, 1.0);
+  HyperHistogram hierarchy( MakeSplitBinning(dim, nBins) );
+  HyperHistogram uniform  ( UniformBinning(limits, nLocalBins) );
+
+  for (int i = 0; i < 100*nBins; i++){
+    HyperPoint point(dim);
+    for (int d = 0; d < dim; d++) point.at(d) = gRandom->Rndm();
+    double weight = gRandom->Exp(1.0);
+    hierarchy.fill(point, weight);
+    uniform  .fill(point, weight);
+  }
+
+  int nBad = 0;
+
+  for (int r = 0; r < nRegions; r++){
+    HyperPoint low (dim);
+    HyperPoint high(dim);
+    for (int d = 0; d < dim; d++){
+      double a = gRandom->Rndm();
+      double b = gRandom->Rndm();
+      low .at(d) = a < b ? a : b;
+      high.at(d) = a < b ? b : a;
+    }
+    HyperCuboid region(low, high);
+
+    double hierarchySumW2 = 0.0;
+    double uniformSumW2   = 0.0;
+    double hierarchyInt   = hierarchy.integral(region, hierarchySumW2);
+    double uniformInt     = uniform  .integral(region, uniformSumW2  );
+
+    double tolerance = 1e-9*(1.0 + fabs(uniformInt));
+    if (fabs(hierarchyInt - uniformInt) > tolerance || fabs(hierarchySumW2 - uniformSumW2) > tolerance){
+      ERROR_LOG << "IntegralCheck - region " << r << " gives " << hierarchyInt << " +- " << sqrt(hierarchySumW2)
+                << " with the aggregates, but " << uniformInt << " +- " << sqrt(uniformSumW2) << " bin by bin" << std::endl;
+      nBad++;
+    }
+  }
+
+  INFO_LOG << "IntegralCheck - " << nRegions - nBad << " of " << nRegions << " regions agree" << std::endl;
+
+  return nBad;
+
+}
+
 void PrintHelp(){
 
   INFO_LOG << "------------ HELP ------------" << std::endl;
@@ -496,6 +635,20 @@ void PrintHelp(){
   std::cout << "--bin-pairs" << std::endl << std::endl;
   INFO_LOG << "Choose how many bin pairs you would like for the --func-binning example " << std::endl;
 
+  INFO_LOG << std::endl;
+  std::cout << "--load-benchmark" << std::endl << std::endl;
+  INFO_LOG << "Time how long it takes to load HyperHistograms with 10^4 bins up to " << std::endl;
+  INFO_LOG << "the number given by --max-bins (10^6 by default). Uses --dim dimensions. " << std::endl;
+
+  INFO_LOG << std::endl;
+  std::cout << "--integral-check" << std::endl << std::endl;
+  INFO_LOG << "Check that HyperHistogram::integral gives the same result (and error) " << std::endl;
+  INFO_LOG << "using the bin hierarchy as it does bin by bin. Uses --dim dimensions. " << std::endl;
+
+  INFO_LOG << std::endl;
+  std::cout << "--max-bins" << std::endl << std::endl;
+  INFO_LOG << "The largest HyperHistogram to use in the --load-benchmark " << std::endl;
+
   INFO_LOG << std::endl << std::endl;
 
 }
@@ -513,10 +666,13 @@ int main(int argc, char** argv) {
   bool dataBinningExample     = 0;
   bool functionBinningExample = 0;
   bool verbose                = 0;
+  bool loadBenchmark          = 0;
+  bool integralCheck          = 0;
 
   int nbinpairs    = 3; 
   int functionNum  = 2; 
   int dim          = 2; 
+  int maxBins      = 1000000; 
 
   for(int i = 1; i<argc; i=i+2){
   
@@ -525,6 +681,9 @@ int main(int argc, char** argv) {
     else if  (std::string(argv[i])=="--data-binning"   ) { dataBinningExample     =  1  ; i--; }
     else if  (std::string(argv[i])=="--help"           ) { help                   =  1  ; i--; }
     else if  (std::string(argv[i])=="--verbose"        ) { verbose                =  1  ; i--; }
+    else if  (std::string(argv[i])=="--load-benchmark" ) { loadBenchmark          =  1  ; i--; }
+    else if  (std::string(argv[i])=="--integral-check" ) { integralCheck          =  1  ; i--; }
+    else if  (std::string(argv[i])=="--max-bins"       ) { maxBins            =  atoi(argv[i+1]); }
     else if  (std::string(argv[i])=="--bin-pairs"      ) { nbinpairs          =  atoi(argv[i+1]); }
     else if  (std::string(argv[i])=="--func-num"       ) { functionNum        =  atoi(argv[i+1]); }
     else if  (std::string(argv[i])=="--dim"            ) { dim                =  atoi(argv[i+1]); }
@@ -541,7 +700,7 @@ int main(int argc, char** argv) {
   }
   
   if (verbose){
-    MessageSerivce::getMessageService()._outputOptions[MessageSerivce::ErrorType::VERBOSE] = true;
+    MessageSerivce::setOutputOption(MessageSerivce::VERBOSE, true);
   }
 
   if (dataBinningExample){
@@ -552,6 +711,14 @@ int main(int argc, char** argv) {
     FunctionBinningExample( dim, functionNum, nbinpairs );
   }
 
+  if (loadBenchmark){
+    LoadBenchmark( dim, maxBins );
+  }
+
+  if (integralCheck){
+    IntegralCheck( dim );
+  }
+
   //This will print out how many errors have occured in HyperPlot. 
   ERROR_COUNT
   
@@ -15,6 +15,8 @@
 #include "MessageService.h"
 #include "HyperPoint.h"
 #include "HyperVolume.h"
+#include "HyperPointSet.h"
+#include "HyperPointSetColumns.h"
 #include "HyperName.h"
 
 
@@ -89,6 +91,9 @@ class BinningBase {
   virtual void reserveCapacity(int nElements); 
   
   virtual std::vector<int> getBinNum(const HyperPointSet& coords) const;
+  virtual std::vector<int> getBinNum(const HyperPointSetColumns& coords) const;
+
+  virtual ULong64_t getFingerprint() const;
 
 
 };
@@ -0,0 +1,97 @@
+/**
+ * <B>HyperPlot</B>,
+ * Author: Sam Harnew, sam.harnew@gmail.com ,
+ * Date: Dec 2015
+ *
+ * Reads whole columns (branches) of a TTree straight into arrays
+ * that have already been allocated. Each branch is read on its own,
+ * so only its baskets are decompressed, and the TTreeCache makes ROOT
+ * fetch them in a few large reads rather than one small read per
+ * entry.
+ *
+ * The columns are shared between several threads. Each thread
+ * opens its own copy of the file, so the branches are decompressed
+ * in parallel. This is used to load HyperBinningMemRes and
+ * HistogramBase, where reading one entry at a time with
+ * TTree::GetEntry is very slow for large files.
+ *
+ * ~~~ {.cpp}
+ * BulkTreeReader reader("hist.root", "HistogramBase");
+ * std::vector<double> contents(reader.getNumEntries());
+ * reader.addColumn("binContent", &contents.at(0));
+ * reader.read();
+ * ~~~
+ *
+ **/
+
+
+#ifndef BULKTREEREADER_HH
+#define BULKTREEREADER_HH
+
+// HyperPlot includes
+#include "MessageService.h"
+
+// Root includes
+#include "TFile.h"
+#include "TTree.h"
+#include "TBranch.h"
+#include "TString.h"
+
+// std includes
+#include <vector>
+
+
+class BulkTreeReader {
+
+  /** A branch to be read, and where to put it */
+  struct Column {
+    TString name;     /**< Name of the branch */
+    double* doubles;  /**< Destination if the branch holds doubles (or 0) */
+    int*    ints;     /**< Destination if the branch holds ints (or 0) */
+    Char_t* chars;    /**< Destination if the branch holds chars (or 0) */
+    int     stride;   /**< Entry i is written to destination[i*stride] */
+  };
+
+  TString  _filename;           /**< The file being read */
+  TString  _treeName;           /**< The tree being read */
+  int      _numThreads;         /**< Number of threads used to read */
+  Long64_t _numEntries;         /**< Number of entries in the tree (-1 if it couldn't be opened) */
+
+  std::vector<Column> _columns; /**< Columns that will be read by read() */
+
+  TFile* openFile(TTree*& tree) const;
+
+  bool readColumns(std::vector<int> columns) const;
+  bool readVectorRange(TString branchName, const Long64_t* entries, int nEntries,
+                       std::vector<int>* values, std::vector<int>* sizes) const;
+
+  public:
+
+  static int s_numThreads;
+  /**< Number of threads to use when none is given to the constructor. If
+  this is zero, the number of cores is used. */
+
+  static Long64_t s_cacheSize;  /**< Size (in bytes) of the TTreeCache used by each thread */
+
+  BulkTreeReader(TString filename, TString treeName, int numThreads = 0);
+
+  bool isOpen() const{return _numEntries >= 0;}                       /**< Was the tree found? */
+  Long64_t getNumEntries() const{return _numEntries < 0 ? 0 : _numEntries;} /**< Number of entries in the tree */
+  int getNumThreads() const{return _numThreads;}                      /**< Number of threads used to read */
+
+  void addColumn(TString branchName, double* destination, int stride = 1);
+  void addColumn(TString branchName, int*    destination, int stride = 1);
+  void addColumn(TString branchName, Char_t* destination, int stride = 1);
+  void clearColumns();
+
+  bool read();
+
+  bool readVectorColumn(TString branchName, const std::vector<Long64_t>& entries,
+                        std::vector<int>& values, std::vector<int>& offsets) const;
+
+  ~BulkTreeReader();
+
+};
+
+
+#endif
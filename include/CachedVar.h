@@ -5,6 +5,22 @@
  *
  * Used for variables we want to cache. Provides a flag that tells us
  * when the cached variable needs updating
+ *
+ * The flag is atomic, so several threads can check it at once. A
+ * cached variable should be updated with double checked locking
+ * i.e.
+ *
+ * ~~~ {.cpp}
+ * if ( _var.isUpdateNeeded() == true ){
+ *   std::lock_guard<CacheMutex> lock(_mutex);
+ *   if ( _var.isUpdateNeeded() == true ) updateVar(); //ends with _var.updated()
+ * }
+ * return _var.get();
+ * ~~~
+ *
+ * so once the variable is up to date, reading it only costs one
+ * atomic load. The value must be set before calling updated(), and
+ * must not be changed while other threads might be reading it.
  **/
 
  
@@ -18,6 +34,8 @@
 
 
 // std includes
+#include <atomic>
+#include <mutex>
 
 
 template <class T> 
@@ -25,18 +43,25 @@ class CachedVar {
   
   private:
 
-  bool       _needsUpdate;
-  T          _cachedVar;
+  std::atomic<bool> _needsUpdate;
+  T                 _cachedVar;
   
   public:
 
   CachedVar(const T& var = T());
+  CachedVar(const CachedVar& other);
+
+  CachedVar& operator=(const CachedVar& other){
+    _cachedVar = other._cachedVar;
+    _needsUpdate.store( other.isUpdateNeeded(), std::memory_order_release );
+    return *this;
+  }
   
   void changed(){
-    _needsUpdate = true;
+    _needsUpdate.store(true, std::memory_order_release);
   }
   void updated(){
-    _needsUpdate = false;
+    _needsUpdate.store(false, std::memory_order_release);
   }
   
   T& get(){return _cachedVar;}
@@ -47,12 +72,12 @@ class CachedVar {
     return *this;
   }
 
-  operator const T&() {
+  operator const T&() const{
     return _cachedVar;
   }
 
-  bool isUpdateNeeded(){
-    return _needsUpdate;
+  bool isUpdateNeeded() const{
+    return _needsUpdate.load(std::memory_order_acquire);
   }
 
   ~CachedVar(){
@@ -69,6 +94,33 @@ template <class T> CachedVar<T>::CachedVar (const T& var) :
     
 } 
 
+template <class T> CachedVar<T>::CachedVar (const CachedVar<T>& other) :
+  _needsUpdate(other.isUpdateNeeded()),
+  _cachedVar(other._cachedVar)
+{ 
+    
+} 
+
+
+/** The mutex used to update a group of CachedVar. It is 
+recursive, since updating one cached variable often needs 
+another, and copying it gives a new (unlocked) mutex so that
+classes holding one can still be copied. */
+class CacheMutex {
+
+  std::recursive_mutex _mutex;
+
+  public:
+
+  CacheMutex(){}
+  CacheMutex(const CacheMutex&){}
+  CacheMutex& operator=(const CacheMutex&){return *this;}
+
+  void lock  (){_mutex.lock  ();}
+  void unlock(){_mutex.unlock();}
+
+};
+
 
 #endif
 
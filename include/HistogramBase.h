@@ -15,6 +15,7 @@
 #include "RootPlotter1D.h"
 #include "RootPlotter2D.h"
 #include "MessageService.h"
+#include "BulkTreeReader.h"
 
 // Root includes
 #include "TTree.h"
@@ -40,6 +41,13 @@ class HistogramBase {
   double _minDensity;  /**< Minimum bin density (bin content / bin volume)  (for plotting) */
   double _maxDensity;  /**< Maximum bin density (bin content / bin volume)  (for plotting) */
 
+  unsigned long _contentsVersion; 
+  /**< Incremented every time the bin contents (or errors) change, so anything
+  derived from them (e.g. HyperHistogram's hierarchy aggregates) knows when
+  it's out of date */
+
+  void contentsChanged(){_contentsVersion++;}  /**< Record that the bin contents have changed */
+
   public:
 
   HistogramBase(int nBins);
@@ -63,6 +71,9 @@ class HistogramBase {
   int getNBins() const{return _nBins;}
   /**< Get the number of bins in the histogram */
 
+  unsigned long getContentsVersion() const{return _contentsVersion;}
+  /**< Changes whenever the bin contents or errors change */
+
   void divide(const HistogramBase& other);
   void multiply(const HistogramBase& other);
   void add(const HistogramBase& other);
@@ -99,6 +110,7 @@ class HistogramBase {
   void saveBase(TString filename);
 
   void loadBase(TString filename);
+  void addBase (TString filename);
   
   void normalise(double area = 1.0);
   
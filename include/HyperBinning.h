@@ -67,6 +67,10 @@ The
 #include "BinningBase.h"
 #include "LoadingBar.h"
 #include "CachedVar.h"
+#include "HyperVolumeIndex.h"
+#include "HyperBinningAdjacency.h"
+#include "BulkTreeReader.h"
+#include "TreeEntryReader.h"
 
 
 // Root includes
@@ -154,15 +158,67 @@ class HyperBinning : public BinningBase {
     ~~~
   */
 
+  mutable CachedVar<HyperVolumeIndex> _volumeIndex;
+  /**< bounding volume hierarchy over the primary volumes (or over every volume
+  if there are no primary volumes) so getBinNum doesn't have to test each one in
+  turn. It is built the first time it is needed, and only if there are more than
+  s_minVolumesToIndex volumes to search. */
+
+  mutable CachedVar<HyperBinningAdjacency> _adjacency;
+  /**< which bins share a face. It is built the first time it is needed, and is
+  saved with the cache (see saveCache) if it has been built. */
+
+  mutable CachedVar<ULong64_t> _fingerprint;
+  /**< hash of every HyperVolume and the links between them (see getFingerprint).
+  It is found the first time it is needed, and saved with the cache (see saveCache). */
+
+  static const int s_minVolumesToIndex = 16;
+  /**< below this many primary volumes, a simple loop is quicker than the index */
+
+  mutable CacheMutex _cacheMutex;
+  /**< held while any of the cached variables above are updated, so that several
+  threads can use a shared binning. Once they are up to date, no locking is needed. */
+
+  mutable TString _cacheFilename;
+  /**< file that the cached bin numbering was saved to (see saveCache). If this
+  isn't empty, the bin numbering is read from the file (a single entry at a time
+  at first) rather than found by looping over every HyperVolume. */
+
+  mutable TreeEntryReader _savedBinNumbers;
+  /**< reads the bin number of a single HyperVolume from the file the cache was
+  loaded from ("HyperBinningVolumeBins"), so a few lookups don't need the whole
+  bin numbering to be read. */
+
+  mutable TreeEntryReader _savedVolumeNumbers;
+  /**< reads the HyperVolume number of a single bin from the file the cache was
+  loaded from ("HyperBinningBinNumbers"). */
+
+  int _savedNumBins;
+  /**< number of bins saved with the cache, or -1 if it wasn't loaded */
+
+  static const int s_maxSavedBinReads = 4096;
+  /**< after this many single entries have been read, the whole bin numbering is read */
+
   protected:
 
 
+  int findTopLevelVolume(const HyperPoint& coords) const;
+  const HyperVolumeIndex& getVolumeIndex() const;
+
   int followBinLinks(const HyperPoint& coords, int binNumber) const; 
 
   void updateCash() const; 
   void updateBinNumbering() const; 
-  void updateAverageBinWidth() const;
-  void updateMinMax() const;
+  void updateDerivedCaches() const;
+  void updateVolumeIndex() const;
+  void updateFingerprint() const;
+  bool isCacheUpToDate() const;
+
+  void saveCache(bool writeTrees = false, bool saveBinNumbering = true) const;
+  void loadCache(TString filename);
+  bool loadBinNumbering() const;
+  bool readSavedBinNumbering(TreeEntryReader& reader, int entry, int& value) const;
+  void updateFullBinNumbering() const;
 
   int getHyperBinningDimFromTree(TTree* tree);
 
@@ -170,6 +226,8 @@ class HyperBinning : public BinningBase {
   void saveHyperVolumeToTree(TTree* tree, double* lowCorner, double* highCorner, const HyperVolume& hyperVolume) const;
   void savePrimaryVolumeNumbers() const;
 
+  int getSplitDimension(int volumeNumber, double& splitValue) const;
+
   public:
   
   HyperBinning();
@@ -190,6 +248,8 @@ class HyperBinning : public BinningBase {
 
   virtual std::vector<int> getLinkedHyperVolumes( int volumeNumber ) const = 0;
   virtual HyperVolume getHyperVolume(int volumeNumber) const = 0; /**< get one of the HyperVolumes */
+  virtual int getNumLinkedHyperVolumes( int volumeNumber ) const;
+  virtual bool isInHyperVolume(int volumeNumber, const HyperPoint& coords) const;
   virtual void addPrimaryVolumeNumber(int volumeNumber) = 0;
   virtual bool addHyperVolume(const HyperVolume& hyperVolume, std::vector<int> linkedVolumes = std::vector<int>(0, 0)) = 0;
   virtual int getNumHyperVolumes() const = 0;  
@@ -211,6 +271,9 @@ class HyperBinning : public BinningBase {
   virtual void save(TString filename) const;
   virtual void save() const; 
 
+  void saveCompact(TString filename) const;
+  void saveCompact() const;
+
   virtual void mergeBinnings( const BinningBase& other );
 
   virtual int getNumBins() const;
@@ -226,6 +289,11 @@ class HyperBinning : public BinningBase {
   virtual HyperPoint  getAverageBinWidth() const;
   virtual HyperCuboid getLimits()          const;
 
+  const HyperBinningAdjacency& getAdjacency() const;
+
+  virtual ULong64_t getFingerprint() const;
+  static ULong64_t readFingerprint(TString filename);
+
 
 
 };
@@ -0,0 +1,131 @@
+/**
+ * <B>HyperPlot</B>,
+ * Author: Sam Harnew, sam.harnew@gmail.com ,
+ * Date: Dec 2015
+ *
+ * The face adjacency graph of a binning i.e. which bins share a
+ * face with which. It's used by HyperBinningPainter2D to draw the
+ * edges between bins with different contents. Nothing else uses it
+ * yet, but it's what anything that looks at the neighbours of a bin
+ * (smoothing, merging bins, ...) would need.
+ *
+ * The graph is stored in CSR form - the neighbours of bin i are
+ * elements getFirstNeighbour(i) to getFirstNeighbour(i+1) - 1 of
+ * the neighbour arrays. For each neighbour, the dimension of the
+ * shared face is stored, and whether it's on the low (-1) or high
+ * (+1) side of the bin.
+ *
+ * It's built by sorting the faces of all the bins in each dimension,
+ * so those that lie on the same plane are found together. The faces
+ * on the low side of each plane are put in a bounding volume hierarchy
+ * (split in every dimension of the plane, not just one), and each face
+ * on the high side only visits the nodes it overlaps. The faces on one
+ * side of a plane don't overlap each other, so this takes about
+ * O(n log n) plus the number of neighbours in any dimension.
+ *
+ **/
+
+
+#ifndef HYPERBINNINGADJACENCY_HH
+#define HYPERBINNINGADJACENCY_HH
+
+// HyperPlot includes
+#include "MessageService.h"
+#include "HyperPoint.h"
+#include "HyperCuboid.h"
+#include "BinningBase.h"
+#include "BulkTreeReader.h"
+
+// Root includes
+#include "TTree.h"
+#include "TString.h"
+
+// std includes
+#include <vector>
+
+
+class HyperBinningAdjacency {
+
+  int _dimension;                    /**< Dimensionality of the binning */
+  int _numBins;                      /**< Number of bins in the binning */
+
+  std::vector<int>  _offsets;        /**< Neighbours of bin i are elements _offsets[i] to _offsets[i+1] - 1 */
+  std::vector<int>  _neighbours;     /**< Bin number of each neighbour */
+  std::vector<int>  _faceDims;       /**< Dimension of the face shared with each neighbour */
+  std::vector<int>  _faceSides;      /**< Is each neighbour on the low (-1) or high (+1) side */
+
+  std::vector<double> _tolerances;   /**< Absolute tolerance in each dimension (only used while building) */
+
+  std::vector<int>    _faceOrder;    /**< Low side faces on one plane, reordered so each node holds a contiguous range (only used while building) */
+  std::vector<double> _nodeLow;      /**< Low corner of the box around each node, [node*dim + d] (only used while building) */
+  std::vector<double> _nodeHigh;     /**< High corner of the box around each node, [node*dim + d] (only used while building) */
+  std::vector<int>    _nodeFirst;    /**< First element of _faceOrder in each node (only used while building) */
+  std::vector<int>    _nodeCount;    /**< Number of elements of _faceOrder in each node (only used while building) */
+  std::vector<int>    _nodeLeft;     /**< Left child of each node, -1 for a leaf (only used while building) */
+  std::vector<int>    _nodeRight;    /**< Right child of each node, -1 for a leaf (only used while building) */
+
+  static const int s_leafSize = 8;   /**< Maximum number of faces in a leaf node */
+
+  /** A face of one of the HyperCuboids in the binning */
+  struct Face {
+    double position;  /**< Position of the face in the dimension it's perpendicular to */
+    int    cuboid;    /**< The HyperCuboid the face belongs to */
+  };
+
+  struct FaceLess{
+    bool operator()(const Face& a, const Face& b) const{return a.position < b.position;}
+  };
+
+  /** Orders HyperCuboids by their centre in one dimension */
+  struct CentreLess{
+    const std::vector<double>& low;
+    const std::vector<double>& high;
+    int dimension;
+    int d;
+    bool operator()(int a, int b) const{
+      return low[a*dimension + d] + high[a*dimension + d] < low[b*dimension + d] + high[b*dimension + d];
+    }
+  };
+
+  void matchFaces(int dim, const std::vector<Face>& highFaces, const std::vector<Face>& lowFaces,
+                  const std::vector<double>& low, const std::vector<double>& high, const std::vector<int>& binOfCuboid,
+                  std::vector< std::vector<int> >& edges);
+
+  int  buildFaceNode(int first, int count, int faceDim, const std::vector<double>& low, const std::vector<double>& high);
+  bool overlapsNode (int node, int cuboid, int faceDim, const std::vector<double>& low, const std::vector<double>& high) const;
+
+  bool overlap(int a, int b, int skipDim, const std::vector<double>& low, const std::vector<double>& high) const;
+
+  void setEdges(std::vector< std::vector<int> >& edges);
+
+  public:
+
+  static double s_tolerance;
+  /**< Faces closer than this (relative to the size of the binning) are on
+  the same plane, and faces must overlap by more than this to be neighbours */
+
+  HyperBinningAdjacency();
+
+  void build(const BinningBase& binning);
+  void clear();
+
+  int getNumBins      () const{return _numBins;}              /**< Number of bins in the graph */
+  int getNumEdges     () const{return _neighbours.size();}    /**< Number of (directed) edges in the graph */
+  int getNumNeighbours(int bin) const{return _offsets[bin + 1] - _offsets[bin];} /**< Number of bins sharing a face with this one */
+  int getFirstNeighbour(int bin) const{return _offsets[bin];} /**< Position of the first neighbour of this bin in the CSR arrays */
+
+  int getNeighbour    (int edge) const{return _neighbours[edge];} /**< Bin number of a neighbour */
+  int getFaceDimension(int edge) const{return _faceDims  [edge];} /**< Dimension of the face shared with a neighbour */
+  int getFaceSide     (int edge) const{return _faceSides [edge];} /**< -1 if the neighbour is on the low side, +1 if on the high side */
+
+  std::vector<int> getNeighbours(int bin) const;
+
+  TTree* save() const;
+  bool   load(TString filename, int nBins, int dimension);
+
+  ~HyperBinningAdjacency();
+
+};
+
+
+#endif
@@ -0,0 +1,109 @@
+/**
+ * <B>HyperPlot</B>,
+ * Author: Sam Harnew, sam.harnew@gmail.com ,
+ * Date: Dec 2015
+ *
+ * The contents of a HyperHistogram summed up the HyperBinning
+ * hierarchy, so that every HyperVolume (not just the bins) has a
+ * content and sumW2. This means coarse views and integrals over a
+ * region can stop at the first HyperVolume that's small enough, or
+ * completely inside the region, rather than visiting every bin.
+ *
+ * The hierarchy (which HyperVolumes are linked to which) and the
+ * limits of each HyperVolume are copied when it's built, so using
+ * it never has to go back to the binning (which might be on disk).
+ * It's built in one bottom-up pass, and can be kept up to date when
+ * the histogram is filled (see fill).
+ *
+ **/
+
+
+#ifndef HYPERBINNINGAGGREGATES_HH
+#define HYPERBINNINGAGGREGATES_HH
+
+// HyperPlot includes
+#include "MessageService.h"
+#include "HyperPoint.h"
+#include "HyperCuboid.h"
+#include "HyperVolume.h"
+#include "HistogramBase.h"
+#include "BinningBase.h"
+
+// Root includes
+
+// std includes
+#include <vector>
+
+class HyperBinning;
+
+class HyperBinningAggregates {
+
+  int _dimension;                       /**< Dimensionality of the binning */
+
+  std::vector<int> _roots;              /**< HyperVolumes that aren't linked from any other */
+  std::vector<int> _parents;            /**< The HyperVolume each one is linked from (-1 for roots) */
+  std::vector<int> _childOffsets;       /**< Children of volume i are elements _childOffsets[i] to _childOffsets[i+1] - 1 of _children */
+  std::vector<int> _children;           /**< The HyperVolumes linked from each HyperVolume */
+  std::vector<int> _binNumbers;         /**< Bin number of each HyperVolume (-1 if it isn't a bin) */
+  std::vector<int> _volumeOfBin;        /**< HyperVolume number of each bin */
+
+  std::vector<double> _low;             /**< Low corner of the limits of each HyperVolume (flat, _dimension per volume) */
+  std::vector<double> _high;            /**< High corner of the limits of each HyperVolume (flat, _dimension per volume) */
+
+  std::vector<double> _contents;        /**< Sum of the bin contents in each HyperVolume */
+  std::vector<double> _sumW2;           /**< Sum of the bin sumW2 in each HyperVolume */
+  std::vector<double> _volumes;         /**< Sum of the bin volumes in each HyperVolume */
+  std::vector<int>    _numBins;         /**< Number of bins in each HyperVolume */
+
+  unsigned long _contentsVersion;       /**< HistogramBase::getContentsVersion() of the contents summed */
+  bool          _built;                 /**< Has build been called? */
+
+  std::vector<int> getTopDownOrder() const;
+
+  public:
+
+  HyperBinningAggregates();
+
+  void build(const HyperBinning& binning, const HistogramBase& histogram);
+  void clear();
+
+  void fill(int bin, double weight);
+
+  bool isUpToDate(const HistogramBase& histogram) const;
+  void setContentsVersion(unsigned long version){_contentsVersion = version;} /**< Record which contents have been summed */
+
+  int getDimension () const{return _dimension;}         /**< Dimensionality of the binning */
+  int getNumVolumes() const{return _parents.size();}    /**< Number of HyperVolumes in the hierarchy */
+
+  const std::vector<int>& getRoots() const{return _roots;} /**< HyperVolumes at the top of the hierarchy */
+
+  int getParent     (int volumeNumber) const{return _parents[volumeNumber];} /**< The HyperVolume linking to this one (-1 if none) */
+  int getNumChildren(int volumeNumber) const{return _childOffsets[volumeNumber + 1] - _childOffsets[volumeNumber];} /**< Number of HyperVolumes linked from this one */
+  int getChild      (int volumeNumber, int i) const{return _children[_childOffsets[volumeNumber] + i];} /**< The i'th HyperVolume linked from this one */
+  int getBinNumber  (int volumeNumber) const{return _binNumbers[volumeNumber];} /**< Bin number of the HyperVolume (-1 if it isn't a bin) */
+
+  double getLowEdge (int volumeNumber, int dim) const{return _low [volumeNumber*_dimension + dim];} /**< Low edge of the HyperVolume limits */
+  double getHighEdge(int volumeNumber, int dim) const{return _high[volumeNumber*_dimension + dim];} /**< High edge of the HyperVolume limits */
+  HyperCuboid getLimits(int volumeNumber) const;
+
+  double getContent(int volumeNumber) const{return _contents[volumeNumber];} /**< Sum of the bin contents in the HyperVolume */
+  double getSumW2  (int volumeNumber) const{return _sumW2   [volumeNumber];} /**< Sum of the bin sumW2 in the HyperVolume */
+  double getVolume (int volumeNumber) const{return _volumes [volumeNumber];} /**< Sum of the bin volumes in the HyperVolume */
+  int    getNumBins(int volumeNumber) const{return _numBins [volumeNumber];} /**< Number of bins in the HyperVolume */
+
+  double getDensity       (int volumeNumber) const;
+  double getAverageContent(int volumeNumber) const;
+
+  bool isInside  (int volumeNumber, const HyperCuboid& region) const;
+  bool isOutside (int volumeNumber, const HyperCuboid& region) const;
+
+  double integral(const HyperCuboid& region, const BinningBase& binning, double& sumW2) const;
+
+  static double getFractionInside(const HyperVolume& hyperVolume, const HyperCuboid& region);
+
+  ~HyperBinningAggregates();
+
+};
+
+
+#endif
@@ -45,7 +45,11 @@ In this simple example, it took 7 operations, whereas checking each Bin would ha
 5. Clearly as the number of bins increases, it becomes computationally much less 
 expensive to follow this hierarchy approach.
 
-The 
+Once loaded in READ mode, several threads can read from the same HyperBinningDiskRes
+(e.g. to find the bin numbers of different HyperPoints). Each thread is given its own 
+copy of the file and its own cache of HyperVolumes, while the top levels of the bin
+hierarchy are pinned in memory and shared. Call prepareConcurrentReads() before 
+starting the threads.
 
 */
 
@@ -77,27 +81,96 @@ The
 // std includes
 #include <algorithm>
 #include <sstream>
+#include <unordered_map>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <atomic>
 
 class HyperBinningDiskRes : public HyperBinning {
 
   private:
+
+  /** Everything needed to read HyperVolumes from the tree, and a cache of
+      the HyperVolumes (and their links) that have been read. TTrees can't
+      be shared between threads, so the thread that loaded the binning uses
+      _mainReader, and every other thread that reads from the binning is given
+      its own Reader (with its own TFile) the first time it does so. If that
+      isn't possible (e.g. the binning was opened to be written to), an error
+      is logged and the thread shares _mainReader, with every read from it
+      serialised by _mainReaderMutex.
+
+      Each HyperVolume that is read is put in a 'slot'. When all of the slots
+      are used, one is reused following the CLOCK algorithm - the slots are 
+      visited in turn, and the first one that hasn't been used since the last 
+      visit is replaced. */
+  struct Reader {
+    TFile*            file;          /**< File opened for this reader (0 for the main reader) */
+    TTree*            tree;          /**< Tree the HyperVolumes are read from */
+    HyperCuboid       cuboid;        /**< Branch addresses for the corners */
+    std::vector<int>* linkedBins;    /**< Branch address for the links */
+    int               volumeNumber;  /**< Branch address for the volume number */
+    int               currentEntry;  /**< Entry that is in the branch addresses */
+
+    std::vector<double>             slotCorners;    /**< Low then high corner of the HyperCuboid in each slot, [slot*2*dim + i] */
+    std::vector< std::vector<int> > slotLinks;      /**< Linked volumes of the HyperVolume in each slot */
+    std::vector<int>                slotVolume;     /**< Volume number in each slot */
+    std::vector<bool>               slotReferenced; /**< Has the slot been used since the clock hand last passed it */
+    std::unordered_map<int, int>    slotOfVolume;   /**< Slot of each volume in the cache */
+    int                             clockHand;      /**< Last slot visited by the clock */
+
+    std::atomic<Long64_t> hits;      /**< Number of times a volume was found in the cache (or pinned) - atomic so other threads can read it */
+    std::atomic<Long64_t> misses;    /**< Number of times a volume had to be read from the tree */
+
+    Reader(int dim = 0);
+    ~Reader();
+  };
   
   mutable TFile* _file;
   bool   _writeable;
 
   mutable TTree* _tree;
-  mutable HyperCuboid _cuboid;
-  mutable std::vector<int>* _linkedBins;
-  mutable int _volumeNumber;
-  mutable int _currentEntry;
+  mutable Reader _mainReader;        /**< Reader used by the thread that loaded the binning (and for writing) */
 
   mutable TTree* _treePrimVol;
   mutable int _primVolNum;
+  std::vector<int> _primaryVolumeNumbers; /**< Primary volume numbers, read into memory when the binning is loaded */
+
+  int _cacheCapacity;                /**< Maximum number of (unpinned) slots in each Reader */
+  int _pinnedLevels;                 /**< Number of levels of the bin hierarchy that are pinned */
+
+  /* The top levels of the bin hierarchy are 'pinned' in memory when the binning
+     is loaded. These are shared by every Reader, and never change until the
+     binning is loaded again, so they can be read from any thread. */
+  std::vector<double>             _pinnedCorners;      /**< Low then high corner of each pinned HyperVolume */
+  std::vector< std::vector<int> > _pinnedLinks;        /**< Linked volumes of each pinned HyperVolume */
+  std::unordered_map<int, int>    _pinnedSlotOfVolume; /**< Where each pinned volume is stored */
+
+  std::thread::id _ownerThread;      /**< Thread that uses _mainReader */
+  Long64_t        _instanceId;       /**< Unique number for this object, used to find the Reader of each thread */
+  mutable std::mutex _readerMutex;   /**< Protects _threadReaders */
+  mutable std::mutex _mainReaderMutex; /**< Held while reading from (or writing with) _mainReader, in case other threads share it */
+  mutable std::map<std::thread::id, Reader*> _threadReaders; /**< Readers of the other threads */
+
+  static std::atomic<Long64_t> s_numInstances; /**< Used to give each object a unique _instanceId */
 
 
   protected:
 
-  void getEntry(int volumeNumber) const;
+  Reader& getReader() const;
+  Reader* createThreadReader() const;
+  void    deleteThreadReaders();
+  void    setBranchAddresses(TTree* tree, Reader& reader) const;
+
+  void getEntry(Reader& reader, int volumeNumber) const;
+  void getVolume(int volumeNumber, const double*& corners, const std::vector<int>*& links, std::unique_lock<std::mutex>& lock) const;
+
+  int  addSlot     (Reader& reader) const;
+  int  getSlot     (Reader& reader, int volumeNumber) const;
+  int  getFreeSlot (Reader& reader) const;
+  void fillSlot    (Reader& reader, int slot, int volumeNumber) const;
+  void clearSlots  (Reader& reader) const;
+  void pinTopLevels();
 
   void loadHyperBinningTree   ();
   void loadPrimaryVolumeTree  ();
@@ -129,6 +202,8 @@ class HyperBinningDiskRes : public HyperBinning {
   virtual int getNumHyperVolumes() const;  
   virtual HyperVolume getHyperVolume(int volumeNumber) const; /**< get one of the HyperVolumes */
   virtual std::vector<int> getLinkedHyperVolumes( int volumeNumber ) const;
+  virtual int getNumLinkedHyperVolumes( int volumeNumber ) const;
+  virtual bool isInHyperVolume(int volumeNumber, const HyperPoint& coords) const;
 
   virtual int getNumPrimaryVolumes  () const;  
   virtual int getPrimaryVolumeNumber(int i) const;  
@@ -142,6 +217,28 @@ class HyperBinningDiskRes : public HyperBinning {
 
   virtual BinningBase* clone() const;
 
+  void prepareConcurrentReads() const;
+
+  void setCacheCapacity(int nVolumes);
+  void setPinnedLevels (int nLevels );
+  void clearCache();
+
+  int getCacheCapacity   () const{return _cacheCapacity;}       /**< Maximum number of volumes in the cache of each thread (excluding pinned ones) */
+  int getPinnedLevels    () const{return _pinnedLevels; }       /**< Number of levels of the bin hierarchy that are pinned */
+  int getNumPinnedVolumes() const{return _pinnedLinks.size();}  /**< Number of volumes pinned in memory */
+  int getNumReaders      () const;
+  int getNumCachedVolumes() const;  /**< Only call while no other thread is reading */
+  double getCacheMemory  () const;  /**< Only call while no other thread is reading */
+
+  Long64_t getCacheHits  () const;
+  Long64_t getCacheMisses() const;
+  double   getCacheHitRate() const;
+  void     resetCacheStatistics();
+  void     printCacheStatistics() const;
+
+  static int s_defaultCacheCapacity;  /**< Cache capacity given to new HyperBinningDiskRes */
+  static int s_defaultPinnedLevels;   /**< Pinned levels given to new HyperBinningDiskRes */
+
 
 };
 
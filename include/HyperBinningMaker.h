@@ -85,6 +85,20 @@ class HyperBinningMaker {
   i.e. if the bin is < twice the minimum egde length, can safely say that it cannot be resplit in that dimension.
   Note that if all dimensions are VolumeStatus::DONE, then _status should also be VolumeStatus::DONE!! */
 
+  std::vector<int>                _frontier;
+  /**< the HyperVolumes that may still have the status VolumeStatus::CONTINUE, in volume order.
+  Volumes that have been split (or marked DONE) are only removed when getFrontier() is called, 
+  so each pass over the binning only visits the volumes that can still be split */
+
+  bool _frontierSorted;
+  /**< false if a volume has been set back to VolumeStatus::CONTINUE, so _frontier may be out of order */
+
+  int _numBins;
+  /**< number of HyperVolumes without linked bins - kept up to date by addBin and split */
+
+  int _numContinueBins;
+  /**< number of HyperVolumes with the status VolumeStatus::CONTINUE - kept up to date by setGlobalVolumeStatus */
+
   std::vector<int>                _binningDimensions;     
   /**< what dimensions are we allowed to bin in */
   
@@ -184,7 +198,7 @@ class HyperBinningMaker {
   /*----------------------------------------------------------------*/
 
 
-  int& getGlobalVolumeStatus(int volumeNumber){return _status.at(volumeNumber);}
+  void setGlobalVolumeStatus(int volumeNumber, int status);
   int& getDimensionSpecificVolumeStatus(int volumeNumber, int dimension){return _dimSpecificStatus.at(volumeNumber).at(dimension);}
 
   const int& getGlobalVolumeStatus(int volumeNumber) const {return _status.at(volumeNumber);}
@@ -194,6 +208,8 @@ class HyperBinningMaker {
   int getNumBins        () const;
   int getNumHyperVolumes() const;
 
+  const std::vector<int>& getFrontier();
+
 
   /*----------------------------------------------------------------*/
   
@@ -0,0 +1,156 @@
+/**
+ * <B>HyperPlot</B>,
+ * Author: Sam Harnew, sam.harnew@gmail.com ,
+ * Date: Dec 2015
+ *
+ * Out-of-core version of the MINT and SMART binning algorithms
+ * (see HyperBinningMakerMint and HyperBinningMakerSmart), for
+ * datasets that are too large to be held in memory.
+ *
+ * The HyperBinningMaker keeps a HyperPointSet for every HyperVolume,
+ * so the whole dataset has to fit in memory. Here, the points that
+ * belong to each HyperVolume that can still be split are instead
+ * spilt to a scratch file. The binning is built one level at a
+ * time - in each pass every scratch file in the 'frontier' is read
+ * sequentially, once to decide where to split and once to
+ * partition the points into the scratch files of the two new
+ * HyperVolumes. Scratch files that are small enough are read into
+ * memory once instead (see setMemoryBudget). HyperVolumes that are
+ * finished are streamed straight into a HyperBinningDiskRes, so only
+ * the frontier and the bin contents are ever held in memory.
+ *
+ * The resulting binning is identical to the one produced by the
+ * in memory algorithms (shadow datasets, snap to grid and function
+ * criteria are not supported). The bin contents are saved in the
+ * same file, so it can be opened directly using
+ *
+ * ~~~ {.cpp}
+ * HyperBinningMakerOutOfCore maker(limits, HyperBinningAlgorithms::SMART);
+ * maker.setMinimumBinContent(100);
+ * maker.makeBinning("bigDataset.root", "binning.root");
+ *
+ * HyperHistogram hist("binning.root", "DISK");
+ * ~~~
+ *
+ **/
+
+
+#ifndef HYPERBINNINGMAKEROUTOFCORE_HH
+#define HYPERBINNINGMAKEROUTOFCORE_HH
+
+// HyperPlot includes
+#include "MessageService.h"
+#include "HyperCuboid.h"
+#include "HyperBinningDiskRes.h"
+#include "HyperBinningAlgorithms.h"
+#include "HyperPointSetChunkSource.h"
+#include "HistogramBase.h"
+
+// Root includes
+#include "TString.h"
+
+// std includes
+#include <vector>
+#include <deque>
+#include <fstream>
+
+
+class HyperBinningMakerOutOfCore {
+
+  /**  Is the volume split as many times as possible, or can I continue to split it  */
+  enum VolumeStatus { DONE, CONTINUE };
+
+  HyperCuboid _binningRange;               /**< The limits of the binning */
+  HyperBinningAlgorithms::Alg _alg;        /**< Which algorithm to use (MINT or SMART) */
+  int _startingDim;                        /**< The first dimension to split */
+
+  std::vector<int> _binningDimensions;     /**< The dimensions that are allowed to be split */
+  bool _useEventWeights;                   /**< Use weights when counting events for the split criteria */
+  double _minimumBinContent;               /**< Minimum bin content allowed */
+  HyperPoint _minimumEdgeLength;           /**< Minimum bin width in each dimension */
+
+  double  _memoryBudget;                   /**< Memory (in bytes) that can be used for buffering points */
+  TString _scratchDir;                     /**< Directory that the scratch files are written to */
+  TString _scratchPrefix;                  /**< Prefix for the scratch files (unique to this process and instance) */
+
+  int _dimension;                          /**< Dimensionality of the points */
+  int _numWeights;                         /**< Number of weights stored with each point */
+  int _recordSize;                         /**< Number of doubles stored per point in the scratch files */
+
+  int _firstVolume;                        /**< Volume number of the first element of the deques below */
+  std::deque<HyperCuboid>        _hyperCuboids; /**< HyperCuboids not yet written to the target binning */
+  std::deque< std::vector<int> > _linkedBins;   /**< Linked volumes not yet written to the target binning */
+  std::deque<int>                _status;       /**< VolumeStatus (CONTINUE or DONE) of each volume */
+  std::deque<double>             _sumW;         /**< Events in each volume, as used by the split criteria */
+  std::deque<double>             _content;      /**< Sum of weights in each volume */
+  std::deque<double>             _contentSumW2; /**< Sum of weights squared in each volume */
+  std::deque<Long64_t>           _numPoints;    /**< Number of points in the scratch file of each volume */
+
+  std::vector<int> _frontier;              /**< Volumes (in order) that have the CONTINUE status */
+  int _numHyperVolumes;                    /**< Total number of volumes created */
+  int _numBins;                            /**< Total number of bins (volumes without links) */
+
+  HyperBinningDiskRes* _target;            /**< The binning being written */
+  std::vector<double> _binContents;        /**< Content of each bin written to the target */
+  std::vector<double> _binSumW2;           /**< Sum of weights squared of each bin written to the target */
+
+  double _bytesRead;                       /**< Bytes read from the scratch files */
+  double _bytesWritten;                    /**< Bytes written to the scratch files */
+
+  TString getScratchFilename(int volumeNumber) const;
+  int getBufferSize() const;
+  int getIndex(int volumeNumber) const{return volumeNumber - _firstVolume;} /**< index of a volume in the deques */
+
+  bool isValidBinningDimension(int dimension) const;
+  int  getInitialStatus(const HyperCuboid& cuboid, double sumW) const;
+
+  int  addVolume(const HyperCuboid& cuboid, double sumW, double content, double sumW2, Long64_t nPoints, int status);
+
+  void writeInitialScratchFile(HyperPointSetChunkSource& source);
+  bool readScratchFile(int volumeNumber, std::vector<double>& points);
+  Long64_t readScratchBuffer(std::ifstream& in, std::vector<double>& buffer);
+
+  double getWeight     (const double* point) const;
+  double getSplitWeight(const double* point) const;
+
+  void fillSplitHistogram(const double* points, Long64_t nPoints, int dimension,
+    const std::vector<double>& splitCoords, std::vector<double>& sumW,
+    std::vector<double>& content, std::vector<double>& sumW2, std::vector<Long64_t>& numPoints) const;
+
+  void partitionPoints(const double* points, Long64_t nPoints, int dimension, double splitCoord,
+    std::vector<double>& buffer1, std::vector<double>& buffer2, std::ofstream* out1, std::ofstream* out2);
+
+  void writeBuffer(std::vector<double>& buffer, std::ofstream* out);
+
+  int  split(int volumeNumber, int dimension);
+  int  splitAll(int dimension);
+
+  void writeFinishedVolumes(bool all = false);
+  void writeBinContents(TString targetFilename);
+
+  public:
+
+  HyperBinningMakerOutOfCore(const HyperCuboid& binningRange, HyperBinningAlgorithms::Alg alg = HyperBinningAlgorithms::MINT);
+
+  void setStartingDimension(int dim){_startingDim = dim;}                    /**< Set the first dimension to split */
+  void setBinningDimensions(std::vector<int> dims){_binningDimensions = dims;} /**< Set the dimensions that are allowed to be split */
+  void useEventWeights(bool val = true){_useEventWeights = val;}            /**< Use weights when counting events for the split criteria */
+  void setMinimumBinContent(double val){_minimumBinContent = val;}           /**< Set the minimum bin content */
+  void setMinimumEdgeLength(double val);
+  void setMinimumEdgeLength(HyperPoint val);
+  void setMemoryBudget(double megabytes);
+  void setScratchDirectory(TString dir){_scratchDir = dir;}                  /**< Set the directory used for the scratch files */
+
+  bool makeBinning(HyperPointSetChunkSource& source, TString targetFilename);
+  bool makeBinning(TString dataFilename, TString targetFilename);
+
+  int getNumBins() const{return _numBins;}                  /**< Number of bins in the binning */
+  int getNumHyperVolumes() const{return _numHyperVolumes;}  /**< Number of HyperVolumes in the binning */
+
+  ~HyperBinningMakerOutOfCore();
+
+};
+
+
+#endif
+
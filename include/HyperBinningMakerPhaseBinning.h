@@ -6,6 +6,7 @@
 #include "HyperBinningMaker.h"
 #include "LoadingBar.h"
 #include "CyclicPhaseBins.h"
+#include "HyperFunctionCache.h"
 
 // Root includes
 #include "TMath.h"
@@ -48,9 +49,18 @@ class HyperBinningMakerPhaseBinning : public HyperBinningMaker{
   
   int _numberOfSystematicSplits;
   int _numberOfGradientSplits;
+
+  HyperFunctionCache _funcCache;
+  /**< Remembers every function value, since the same corners, face centers
+  and finite difference steps are needed by neighbouring HyperVolumes */
   
   private:
 
+  double getFuncVal(const HyperPoint& point);
+  /**< Get the function value at a point (using the cache) */
+  std::vector<double> getFuncVals(const HyperPointSet& points);
+  /**< Get the function value at a set of points (using the cache) */
+
   int splitByCoord(int volumeNumber, int dimension, HyperPoint& coord);
   /**< Split a HyperVolume in a given dimension at a given coord */
 
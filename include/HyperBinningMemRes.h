@@ -81,12 +81,23 @@ class HyperBinningMemRes : public HyperBinning {
 
   protected:
 
-  std::vector< HyperVolume      > _hyperVolumes;
+  std::vector< double > _corners;
   /**< 
-    std::vector containing all of the HyperVolumes. Usually, not all of these are bins,
+    The corners of every HyperCuboid, stored in one contiguous array. Each HyperCuboid 
+    takes 2*dim doubles - the low corner followed by the high corner. Storing the 
+    HyperVolumes like this (rather than as a std::vector<HyperVolume>) avoids several 
+    heap allocations per HyperVolume, so large binnings take little more memory
+    than the corners themselves. Usually, not all of the HyperVolumes are bins,
     but part of the bin hierarchy that is discussed in the class description.
   */
-  
+
+  std::vector< int > _cuboidOffsets;
+  /**< 
+    The HyperCuboids of HyperVolume i are numbers _cuboidOffsets[i] to 
+    _cuboidOffsets[i+1] - 1 in _corners. There is one more element than
+    there are HyperVolumes.
+  */
+
   std::vector< int > _primaryVolumeNumbers;
   /**<
     Usually all bins will be accessed through one primary volume i.e. volume 0 in
@@ -113,12 +124,12 @@ class HyperBinningMemRes : public HyperBinning {
 
   */
 
-  std::vector< std::vector<int> > _linkedHyperVolumes; 
+  std::vector< int > _linkedHyperVolumes; 
   /**< 
-    Every HyperVolume has a _linkedHyperVolumes - if this is empty, this
-    means the HyperVolume is a true Bin. If not it is part of the binning hierarchy.
-    In the below, HyperVolume 0 would be linked to HyperVolume [1,2], although 
-    HyperVolume 4 would be linked to nothing.
+    The linked HyperVolumes of every HyperVolume, one after the other. If a
+    HyperVolume has no links, this means the HyperVolume is a true Bin. If not it is
+    part of the binning hierarchy. In the below, HyperVolume 0 would be linked to 
+    HyperVolume [1,2], although HyperVolume 4 would be linked to nothing.
 
     ~~~ {.cpp}
     
@@ -140,9 +151,19 @@ class HyperBinningMemRes : public HyperBinning {
 
   */
 
+  std::vector< int > _linkOffsets;
+  /**< 
+    The links of HyperVolume i are elements _linkOffsets[i] to _linkOffsets[i+1] - 1
+    of _linkedHyperVolumes. There is one more element than there are HyperVolumes.
+  */
+
+  void addCuboidCorners(const double* lowCorner, const double* highCorner);
+  void addLinks(const std::vector<int>& linkedVolumes);
+
   void setBranchAddresses   (TTree* tree, int* binNumber, double* lowCorner, double* highCorner, std::vector<int>** linkedBins) const;
   
   void loadPrimaryVolumeNumbers(TFile* file);
+  void loadCompact(TFile* file, TString filename);
   
   public:
   
@@ -165,6 +186,8 @@ class HyperBinningMemRes : public HyperBinning {
   virtual int getNumHyperVolumes() const;  
   virtual HyperVolume getHyperVolume(int volumeNumber) const; /**< get one of the HyperVolumes */
   virtual std::vector<int> getLinkedHyperVolumes( int volumeNumber ) const;
+  virtual int getNumLinkedHyperVolumes( int volumeNumber ) const;
+  virtual bool isInHyperVolume(int volumeNumber, const HyperPoint& coords) const;
 
   virtual int getNumPrimaryVolumes  (     ) const;  
   virtual int getPrimaryVolumeNumber(int i) const;  
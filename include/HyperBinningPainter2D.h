@@ -23,6 +23,7 @@
 #include "TH2D.h"
 
 // std includes
+#include <vector>
 
 
 
@@ -46,6 +47,7 @@ class HyperBinningPainter2D : public HyperBinningPainter {
   void addHyperPoints(TH2D* histogram);
 
   void drawFilledBins(RootPlotter2D* plotter, bool hashNeg = false);
+  void drawFilledBinsLOD(RootPlotter2D* plotter, const HyperBinningAggregates& aggregates, bool hashNeg = false);
   void drawFilledBin(RootPlotter2D* plotter, int bin, bool hashNeg = false);
   void drawFilledBin(RootPlotter2D* plotter, HyperCuboid* bin, double binContents);
   void drawFilledBin(RootPlotter2D* plotter, HyperCuboid* bin, int fillColor, int fillStyle);
@@ -57,6 +59,7 @@ class HyperBinningPainter2D : public HyperBinningPainter {
 
 
   void drawBinEdges2(RootPlotter2D* plotter);
+  void drawBinEdges2(RootPlotter2D* plotter, const HyperBinningAdjacency& adjacency);
   void drawBinEdge2(RootPlotter2D* plotter, int bin, double minWidX, double minWidY);
   void drawBinEdge2(RootPlotter2D* plotter, HyperCuboid* bin, double minWidX, double minWidY);
   void drawBinEdge2(RootPlotter2D* plotter, HyperCuboid* bin, int edge, double minWidX, double minWidY);
@@ -68,9 +71,21 @@ class HyperBinningPainter2D : public HyperBinningPainter {
   void drawBinCont(RootPlotter2D* plotter);
   void drawBinCont(RootPlotter2D* plotter, int bin);
 
+  void getContentRange(double& min, double& max, bool hashNeg);
+
+  void drawRaster(TString path, TString option);
+  void rasterise(TH2D* raster, std::vector<int>& pixelBins);
+  void rasteriseEdges(TH2D* raster, const std::vector<int>& pixelBins, bool contentEdges, double blank);
+
 
   public:
 
+  static int s_maxVectorBins;
+  /**< Above this many bins, draw() rasterises the histogram rather than
+  drawing a TBox for every bin (unless the "Vector" option is given) */
+  static int s_rasterWidth;  /**< Number of pixels in x used when rasterising */
+  static int s_rasterHeight; /**< Number of pixels in y used when rasterising */
+
   HyperBinningPainter2D(BinningBase* binning, HyperPointSet* hyperPoints = 0);
   HyperBinningPainter2D(HyperHistogram* histogram);
 
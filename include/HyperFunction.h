@@ -6,6 +6,14 @@
  * HyperFunction takes a HyperPoint and returns
  * a double. This can be used to reweight HyperPointSets etc.
  *
+ * Everything in HyperPlot that evaluates a HyperFunction at many
+ * points does so through getVals, which passes blocks of points to
+ * getValBlock. By default this just calls getVal for each point,
+ * but functions that can be evaluated faster a block at a time
+ * (e.g. vectorised amplitude models) can override it. If getVal and
+ * getValBlock are safe to call from several threads at once, use
+ * setNumThreads to evaluate the blocks in parallel.
+ *
  **/
 
  
@@ -17,11 +25,13 @@
 #include "HyperPointSet.h"
 #include "HyperCuboid.h"
 #include "RootPlotter2D.h"
+#include "RenderPool.h"
 
 // Root includes
 #include "TH2D.h"
 
 // std includes
+#include <vector>
 
 
 class HyperFunction{  
@@ -30,12 +40,26 @@ class HyperFunction{
   
   HyperCuboid _limits;
 
+  int _numThreads; /**< Number of threads used by getVals */
+
   public:
 
   HyperFunction(); /**< Constructor */
   HyperFunction(const HyperCuboid& limits); /**< Constructor */
 
   virtual double getVal(const HyperPoint& point) const = 0; /**< Virtual function that defines a HyperFunction (Map from HyperPoint -> double) */
+
+  virtual void getValBlock(const HyperPointSet& points, int first, int nPoints, double* vals) const;
+
+  std::vector<double> getVals(const HyperPointSet& points) const;
+  void getVals(const HyperPointSet& points, double* vals) const;
+
+  virtual bool isDiskResident() const{return false;}
+  /**< Does evaluating the function read from an open file? If so, it can't
+  be shared with forked processes (see RenderPool) */
+
+  void setNumThreads(int nThreads);
+  int  getNumThreads() const{return _numThreads;} /**< Number of threads used by getVals */
   
   void reweightDataset(HyperPointSet& points);
   
@@ -0,0 +1,88 @@
+/**
+ * <B>HyperPlot</B>,
+ * Author: Sam Harnew, sam.harnew@gmail.com ,
+ * Date: Dec 2015
+ *
+ * Wraps a HyperFunction that is expensive to evaluate (e.g. an
+ * amplitude model), and remembers every value it has returned.
+ * Points are identified by their coordinates rounded to a fine
+ * grid (by default a 10^-9 fraction of the range in each dimension),
+ * so the same corner or face centre reached from two neighbouring
+ * HyperVolumes is only evaluated once, even if the coordinates
+ * differ in the last few bits. The number of calls and cache hits
+ * are recorded so the hit rate can be checked.
+ *
+ * When a block of points is requested (see HyperFunction::getVals),
+ * the points that aren't in the cache are passed to the cached
+ * function's getVals together. The cache itself isn't thread safe,
+ * so leave its own number of threads at one - use setNumThreads on
+ * the cached function instead.
+ *
+ **/
+
+ 
+#ifndef HYPERFUNCTIONCACHE_HH
+#define HYPERFUNCTIONCACHE_HH
+
+// HyperPlot includes
+#include "MessageService.h"
+#include "HyperFunction.h"
+#include "HyperPointSet.h"
+#include "HyperCuboid.h"
+
+// Root includes
+
+// std includes
+#include <map>
+#include <vector>
+
+
+class HyperFunctionCache : public HyperFunction {  
+
+  const HyperFunction* _func;   /**< The function being cached */
+
+  HyperPoint _origin;           /**< Origin of the grid used to identify points */
+  HyperPoint _resolution;       /**< Grid spacing in each dimension */
+
+  Long64_t _maxEntries;         /**< Once the cache holds this many values it is emptied */
+
+  mutable std::map< std::vector<Long64_t>, double > _cache; /**< Function values, keyed on the grid coordinates */
+  mutable std::vector<Long64_t> _key;                       /**< Key buffer, to avoid an allocation per call */
+  mutable Long64_t _numCalls;   /**< Number of values requested */
+  mutable Long64_t _numHits;    /**< Number of values found in the cache */
+
+  void fillKey(const HyperPoint& point) const;
+  double evaluate(const HyperPoint& point) const;
+
+  public:
+
+  HyperFunctionCache(const HyperFunction* func, const HyperCuboid& range, double relativeResolution = 1e-9);
+
+  void setFunction(const HyperFunction* func);
+  const HyperFunction* getFunction() const{return _func;} /**< Get the function being cached */
+
+  void setMaxEntries(Long64_t maxEntries){_maxEntries = maxEntries;} /**< Limit the number of values stored */
+
+  virtual double getVal(const HyperPoint& point) const;
+  virtual void getValBlock(const HyperPointSet& points, int first, int nPoints, double* vals) const;
+
+  virtual bool isDiskResident() const{return _func != 0 && _func->isDiskResident();} /**< Does the cached function read from a file? */
+
+  void clear();
+  void resetStatistics();
+
+  Long64_t getNumCalls      () const{return _numCalls;}             /**< Number of values requested */
+  Long64_t getNumHits       () const{return _numHits;}              /**< Number of values found in the cache */
+  Long64_t getNumEvaluations() const{return _numCalls - _numHits;}  /**< Number of times the function was evaluated */
+  double   getHitRate       () const;
+  int      size             () const{return _cache.size();}         /**< Number of values stored */
+
+  void printStatistics() const;
+
+  virtual ~HyperFunctionCache();
+
+};
+
+
+
+#endif
@@ -0,0 +1,108 @@
+/**
+ * <B>HyperPlot</B>,
+ * Author: Sam Harnew, sam.harnew@gmail.com ,
+ * Date: Dec 2015
+ *
+ * Generates events distributed like a HyperFunction, using far fewer
+ * function evaluations than plain accept-reject over the whole domain.
+ *
+ * First, the function is evaluated at random points across its domain
+ * (see HyperFunction::setFuncLimits), and an adaptive HyperBinning of
+ * these weighted points is made with the usual HyperBinningMaker
+ * machinery - the bins end up small where the function is large. The
+ * largest value seen in each bin (times s_safetyFactor) is used as a
+ * piecewise constant envelope. Events are generated from the envelope
+ * (see HyperHistogramGenerator) and accepted with probability
+ * function / envelope.
+ *
+ * If the function is ever found above the envelope, that bin of the
+ * envelope is raised. Events accepted in that bin before it was raised
+ * are slightly too few, so if getNumViolations() isn't small, use a
+ * larger s_safetyFactor or more build points.
+ *
+ * Candidates are generated in rounds by several threads, each with
+ * its own TRandom3 and its own share of each round. The envelope is
+ * only raised between rounds, so the events only depend on the seed
+ * and the number of threads. By default the number of threads is
+ * HyperFunction::getNumThreads() (one unless it's been changed), since
+ * getValBlock must be safe to call from several threads at once to
+ * use more.
+ *
+ **/
+
+
+#ifndef HYPERFUNCTIONGENERATOR_HH
+#define HYPERFUNCTIONGENERATOR_HH
+
+// HyperPlot includes
+#include "MessageService.h"
+#include "HyperFunction.h"
+#include "HyperHistogram.h"
+#include "HyperHistogramGenerator.h"
+#include "HyperPointSetColumns.h"
+
+// Root includes
+#include "TRandom3.h"
+
+// std includes
+#include <vector>
+
+
+class HyperFunctionGenerator {
+
+  const HyperFunction& _func;       /**< The function events are generated from */
+
+  UInt_t _seed;                     /**< Seed used to build the envelope and generate events */
+  int    _numThreads;               /**< Number of threads used to evaluate the function */
+  int    _numGenerateCalls;         /**< Number of times generate has been called (each uses new seeds) */
+
+  BinningBase* _binning;            /**< The bins of the envelope */
+  std::vector<double> _envelope;    /**< The envelope (a bound on the function) in each bin */
+  std::vector<double> _binVolumes;  /**< Volume of each bin */
+
+  HyperHistogramGenerator* _envelopeGenerator; /**< Generates candidates from the envelope */
+
+  Long64_t _numBuildEvaluations;    /**< Function evaluations used to build the envelope */
+  Long64_t _numEvaluations;         /**< Function evaluations used to generate events */
+  Long64_t _numAccepted;            /**< Number of candidates accepted */
+  Long64_t _numViolations;          /**< Number of times a bin of the envelope was raised */
+
+  void buildEnvelope(int nBuildPoints);
+  void updateEnvelopeGenerator();
+
+  std::vector<double> evaluate(const HyperPointSet& points) const;
+
+  HyperFunctionGenerator(const HyperFunctionGenerator& other);            /**< Not copyable */
+  HyperFunctionGenerator& operator=(const HyperFunctionGenerator& other); /**< Not copyable */
+
+  public:
+
+  static double s_safetyFactor;
+  /**< The envelope is this much bigger than the largest function value seen in each bin */
+  static double s_minEnvelopeFraction;
+  /**< No bin of the envelope is lower than this fraction of the largest bin, so
+  regions where no function value was seen can still be generated */
+  static double s_buildPointsPerBin;
+  /**< Roughly how many of the build points end up in each bin of the envelope */
+
+  HyperFunctionGenerator(const HyperFunction& func, int nBuildPoints = 100000, UInt_t seed = 1, int nThreads = -1);
+
+  void generate(HyperPointSetColumns& points);
+  HyperPointSetColumns generate(int nEvents);
+
+  int getNumBins() const{return _envelope.size();} /**< Number of bins in the envelope */
+  const BinningBase& getBinning() const{return *_binning;} /**< The bins of the envelope */
+
+  Long64_t getNumBuildEvaluations() const{return _numBuildEvaluations;} /**< Function evaluations used to build the envelope */
+  Long64_t getNumEvaluations     () const{return _numEvaluations;     } /**< Function evaluations used to generate events */
+  Long64_t getNumAccepted        () const{return _numAccepted;        } /**< Number of events generated */
+  Long64_t getNumViolations      () const{return _numViolations;      } /**< Number of times the envelope was raised */
+
+  double getEfficiency() const;
+
+  ~HyperFunctionGenerator();
+
+};
+
+
+#endif
@@ -0,0 +1,89 @@
+/**
+ * <B>HyperPlot</B>,
+ * Author: Sam Harnew, sam.harnew@gmail.com ,
+ * Date: Dec 2015
+ *
+ * Integrates a HyperFunction over HyperCuboids and HyperVolumes
+ * (e.g. the bins of a HyperHistogram, see
+ * HyperHistogram::setContentsFromFuncIntegral).
+ *
+ * Randomised quasi-Monte-Carlo is used - the points are a Halton
+ * sequence, shifted (modulo the cuboid) by s_numShifts different
+ * random offsets. Each shift gives an independent estimate of the
+ * integral, and the spread of these gives the error. The number of
+ * points is doubled until the error is below the target precision
+ * (relative to the integral), or the maximum number of points is
+ * reached. For a HyperVolume, the maximum is shared between its
+ * HyperCuboids in proportion to their volume.
+ *
+ * The points for each round are passed to HyperFunction::getValBlock
+ * together. When integrating many volumes, they are shared between
+ * HyperFunction::getNumThreads() threads, so only use more than one
+ * if the function is thread safe. The random shifts for each volume
+ * only depend on the seed and the position of the volume, so the
+ * results don't depend on the number of threads.
+ *
+ **/
+
+
+#ifndef HYPERFUNCTIONINTEGRATOR_HH
+#define HYPERFUNCTIONINTEGRATOR_HH
+
+// HyperPlot includes
+#include "MessageService.h"
+#include "HyperFunction.h"
+#include "HyperCuboid.h"
+#include "HyperVolume.h"
+#include "HyperPointSet.h"
+
+// Root includes
+#include "TRandom.h"
+#include "TRandom3.h"
+
+// std includes
+#include <vector>
+#include <atomic>
+
+
+class HyperFunctionIntegrator {
+
+  const HyperFunction& _func;    /**< The function being integrated */
+
+  double _precision;             /**< Target error, relative to the integral */
+  int    _maxPoints;             /**< Largest number of points used for each integral */
+  UInt_t _seed;                  /**< Seed for the random shifts */
+
+  mutable std::atomic<Long64_t> _numEvaluations; /**< Number of function evaluations so far */
+  mutable std::atomic<int>      _numImprecise;   /**< Number of HyperCuboids where the target precision wasn't reached */
+
+  static double radicalInverse(unsigned index, int base);
+
+  double integrate(const HyperCuboid& cuboid, double& error, TRandom* random, int maxPoints) const;
+
+  HyperFunctionIntegrator(const HyperFunctionIntegrator& other);            /**< Not copyable */
+  HyperFunctionIntegrator& operator=(const HyperFunctionIntegrator& other); /**< Not copyable */
+
+  public:
+
+  static int s_numShifts;
+  /**< Number of randomly shifted copies of the Halton sequence (the error
+  is found from the spread of their estimates) */
+  static int s_minPoints;
+  /**< Number of points in each shifted sequence to begin with */
+
+  HyperFunctionIntegrator(const HyperFunction& func, double precision = 1e-3, int maxPoints = 65536, UInt_t seed = 1);
+
+  double integrate(const HyperCuboid& cuboid, double& error, TRandom* random) const;
+  double integrate(const HyperVolume& volume, double& error, TRandom* random) const;
+
+  void integrate(const std::vector<HyperVolume>& volumes, std::vector<double>& integrals, std::vector<double>& errors) const;
+
+  Long64_t getNumEvaluations() const{return _numEvaluations;} /**< Number of function evaluations so far */
+  int      getNumImprecise  () const{return _numImprecise;  } /**< Number of HyperCuboids where the target precision wasn't reached */
+
+  ~HyperFunctionIntegrator();
+
+};
+
+
+#endif
@@ -40,7 +40,10 @@ Binning Algorithm Options:
 #include "BinningBase.h"
 #include "HyperBinning.h"
 #include "HyperBinningDiskRes.h"
+#include "HyperBinningAggregates.h"
+#include "RenderPool.h"
 #include "HyperBinningAlgorithms.h"
+#include "HyperPointSetChunkSource.h"
 
 // Root includes
 #include "TRandom.h"
@@ -55,6 +58,14 @@ class HyperHistogram : public HistogramBase, public HyperFunction {
   protected:
 
   BinningBase* _binning; /**< The HyperVolumeBinning used for the HyperHistogram */
+
+  mutable HyperBinningAggregates _aggregates; 
+  /**< The bin contents summed up the HyperBinning hierarchy (see getAggregates) */
+  mutable CacheMutex _aggregatesMutex;
+  /**< Held while the aggregates are rebuilt */
+
+  void fillWithAggregates(int binNumber, double weight);
+  void projectAggregates(TH1D* histogram, const HyperBinningAggregates& aggregates, int dimension) const;
   
   HyperHistogram();
   
@@ -98,10 +109,25 @@ class HyperHistogram : public HistogramBase, public HyperFunction {
   int  fill(const HyperPoint& coords, double weight);
   int  fill(const HyperPoint& coords);
   void fill(const HyperPointSet& points);
+  void fill(HyperPointSetChunkSource& source, int chunkSize = 100000, bool overlapIO = true);
+  void fillFromFile(TString filename, int chunkSize = 100000, bool overlapIO = true);
 
   virtual void merge( const HistogramBase& other );
 
+  using HistogramBase::integral;
+  using HistogramBase::integralError;
+
+  double integral     (const HyperCuboid& region) const;
+  double integral     (const HyperCuboid& region, double& sumW2) const;
+  double integralError(const HyperCuboid& region) const;
+
+  const HyperBinningAggregates* getAggregates() const;
+
   void merge( TString filenameother );
+  void merge( const std::vector<TString>& filenames );
+
+  bool hasSameBinning(const HyperHistogram& other) const;
+  void mergeContents (const HyperHistogram& other);
 
   
   int estimateCapacity(std::vector<TString> filename, TString binningType);
@@ -135,6 +161,8 @@ class HyperHistogram : public HistogramBase, public HyperFunction {
 
 
   const BinningBase& getBinning() const { return (*_binning); }  /**< get the HyperVolumeBinning */
+
+  virtual bool isDiskResident() const{ return _binning->isDiskResident(); } /**< Is the binning read from a file? */
   
   virtual double getVal(const HyperPoint& point) const;
   std::vector<double> getVal(const HyperPointSet& points) const; 
@@ -143,6 +171,7 @@ class HyperHistogram : public HistogramBase, public HyperFunction {
   virtual double getBinVolume(int bin) const;
 
   void save(TString filename);
+  void saveCompact(TString filename);
 
   TString getBinningType(TString filename);
 
@@ -151,6 +180,7 @@ class HyperHistogram : public HistogramBase, public HyperFunction {
 
 
   void setContentsFromFunc(const HyperFunction& func);
+  void setContentsFromFuncIntegral(const HyperFunction& func, double precision = 1e-3, int maxPointsPerBin = 65536, UInt_t seed = 1);
   
   void printFull() const;
   
@@ -0,0 +1,81 @@
+/**
+ * <B>HyperPlot</B>,
+ * Author: Sam Harnew, sam.harnew@gmail.com ,
+ * Date: Dec 2015
+ *
+ * Generates events distributed like the contents of a HyperHistogram.
+ *
+ * A Walker/Vose alias table is built over the bin contents when
+ * the generator is made, so picking the bin for each event takes
+ * the same time however many bins there are. Each event is then
+ * placed uniformly within its bin - if the bin is made of several
+ * HyperCuboids, one is picked with a probability proportional to
+ * its volume.
+ *
+ * The corners of every bin are copied when the generator is made,
+ * so generating never goes back to the binning (which might be on
+ * disk), and several threads can generate at once, each with its
+ * own TRandom (see generateParallel).
+ *
+ **/
+
+
+#ifndef HYPERHISTOGRAMGENERATOR_HH
+#define HYPERHISTOGRAMGENERATOR_HH
+
+// HyperPlot includes
+#include "MessageService.h"
+#include "HyperPoint.h"
+#include "HyperPointSet.h"
+#include "HyperPointSetColumns.h"
+#include "HyperHistogram.h"
+
+// Root includes
+#include "TRandom.h"
+#include "TRandom3.h"
+
+// std includes
+#include <vector>
+
+
+class HyperHistogramGenerator {
+
+  int _dimension;                    /**< Dimensionality of the histogram */
+  int _numBins;                      /**< Number of bins in the histogram */
+
+  std::vector<double> _aliasProb;    /**< Probability of keeping bin i rather than taking its alias */
+  std::vector<int>    _alias;        /**< The bin taken instead of bin i the rest of the time */
+
+  std::vector<int>    _cuboidOffsets;/**< HyperCuboids of bin i are _cuboidOffsets[i] to _cuboidOffsets[i+1] - 1 */
+  std::vector<double> _cuboidCdf;    /**< Fraction of its bin's volume in each HyperCuboid and the ones before it */
+  std::vector<double> _low;          /**< Low corner of each HyperCuboid (flat, _dimension per cuboid) */
+  std::vector<double> _width;        /**< Width of each HyperCuboid (flat, _dimension per cuboid) */
+
+  void buildAliasTable(const std::vector<double>& probs);
+  void copyBins(const BinningBase& binning);
+
+  public:
+
+  HyperHistogramGenerator(const HyperHistogram& histogram);
+  HyperHistogramGenerator(const BinningBase& binning, const HistogramBase& contents);
+
+  void setBinContents(const std::vector<double>& contents);
+
+  int getDimension() const{return _dimension;} /**< Dimensionality of the generated events */
+  int getNumBins  () const{return _numBins;  } /**< Number of bins that events are generated in */
+
+  int  generateBin  (TRandom* random) const;
+  void generatePoint(int bin, TRandom* random, double* coords) const;
+
+  void generate(HyperPointSetColumns& points, int first, int nEvents, TRandom* random) const;
+  void generate(HyperPointSet& points, int nEvents, TRandom* random = gRandom) const;
+  HyperPointSetColumns generate(int nEvents, TRandom* random = gRandom) const;
+
+  void generateParallel(HyperPointSetColumns& points, int nThreads = 0, UInt_t seed = 1) const;
+
+  ~HyperHistogramGenerator();
+
+};
+
+
+#endif
@@ -0,0 +1,101 @@
+/**
+ * <B>HyperPlot</B>,
+ * Author: Sam Harnew, sam.harnew@gmail.com ,
+ * Date: Dec 2015
+ *
+ * A histogram with several sets of bin contents over one binning -
+ * one for each weight carried by the HyperPoints (e.g. the nominal
+ * weight and its systematic variations).
+ *
+ * Filling finds the bin of each event once, and then adds all of its
+ * weights. The contents (and sum of weights^2) are stored bin by bin,
+ * so the weights of one event go into neighbouring memory.
+ *
+ * Each set of contents can be copied into a normal HyperHistogram
+ * (see getVariation) for plotting, dividing etc, and copied back with
+ * setVariation. These are copies rather than views - a HyperHistogram
+ * owns its contents, and a view of every k'th element would mean
+ * changing HistogramBase - so changes to a variation only reach this
+ * histogram through setVariation. The file written by save can also be loaded as a
+ * normal HyperHistogram, which gets the contents for weight 0.
+ *
+ * ~~~ {.cpp}
+ * HyperHistogramMultiWeight hist(binning, 3);
+ * hist.fill(points); //uses weights 0, 1 and 2 of each point
+ *
+ * HyperHistogram nominal = hist.getVariation(0);
+ * HyperHistogram up      = hist.getVariation(1);
+ * up.divide(nominal);
+ * ~~~
+ *
+ **/
+
+
+#ifndef HYPERHISTOGRAMMULTIWEIGHT_HH
+#define HYPERHISTOGRAMMULTIWEIGHT_HH
+
+// HyperPlot includes
+#include "MessageService.h"
+#include "HyperHistogram.h"
+#include "HistogramBase.h"
+#include "BinningBase.h"
+#include "HyperPointSet.h"
+#include "HyperPointSetColumns.h"
+#include "HyperPointSetChunkSource.h"
+
+// Root includes
+
+// std includes
+#include <vector>
+
+
+class HyperHistogramMultiWeight {
+
+  BinningBase* _binning;            /**< The binning shared by every set of contents */
+
+  int _nBins;                       /**< Number of bins (bin _nBins is underflow/overflow) */
+  int _numWeights;                  /**< Number of sets of contents (one per weight) */
+
+  std::vector<double> _binContents; /**< Bin contents - weight w of bin b is at b*_numWeights + w */
+  std::vector<double> _sumW2;       /**< Sum of weights^2, stored like _binContents */
+
+  int checkBinNumber(int bin) const;
+
+  HyperHistogramMultiWeight(const HyperHistogramMultiWeight& other);            /**< Not copyable */
+  HyperHistogramMultiWeight& operator=(const HyperHistogramMultiWeight& other); /**< Not copyable */
+
+  public:
+
+  HyperHistogramMultiWeight(const BinningBase& binning, int numWeights);
+  HyperHistogramMultiWeight(TString filename);
+
+  const BinningBase& getBinning() const{return *_binning;} /**< Get the binning */
+
+  int getNBins     () const{return _nBins;     } /**< Number of bins */
+  int getNumWeights() const{return _numWeights;} /**< Number of sets of contents */
+
+  void fillBin(int bin, const double* weights);
+
+  int  fill(const HyperPoint& coords);
+  void fill(const HyperPointSet& points);
+  void fill(const HyperPointSetColumns& points);
+  void fill(HyperPointSetChunkSource& source, int chunkSize = 100000);
+  void fillFromFile(TString filename, int chunkSize = 100000);
+
+  double getBinContent(int bin, int weight) const;
+  double getBinError  (int bin, int weight) const;
+
+  void clear();
+
+  HyperHistogram getVariation(int weight) const;
+  void setVariation(int weight, const HistogramBase& hist);
+
+  void save(TString filename) const;
+  void load(TString filename);
+
+  ~HyperHistogramMultiWeight();
+
+};
+
+
+#endif
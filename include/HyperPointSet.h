@@ -45,6 +45,8 @@ class HyperPointSet {
   HyperPoint& at(int i)                  ;
   unsigned int size() const              ;
   void push_back(const HyperPoint& point);
+  void reserve(unsigned int npoints)     ;
+  void clear()                           ;
 
   void addHyperPointSet(const HyperPointSet& other);
   void removeDuplicates();
@@ -67,6 +69,7 @@ class HyperPointSet {
   HyperPoint harmonicMean()  const;
   
   void save(TString path);
+  void saveColumnar(TString path) const;
   void load(TString path);
 
   void print(std::ostream& os = std::cout) const;
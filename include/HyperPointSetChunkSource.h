@@ -0,0 +1,47 @@
+/**
+ * <B>HyperPlot</B>,
+ * Author: Sam Harnew, sam.harnew@gmail.com ,
+ * Date: Dec 2015
+ *
+ * Abstract source of HyperPoints that are delivered in chunks,
+ * so that datasets much larger than the available memory can be
+ * streamed through e.g. HyperHistogram::fill. HyperPointSetReader
+ * provides chunks from a HyperPointSet file - inherit from this
+ * class to stream points from anywhere else (a generator, some
+ * other file format, etc.)
+ *
+ **/
+
+
+#ifndef HYPERPOINTSETCHUNKSOURCE_HH
+#define HYPERPOINTSETCHUNKSOURCE_HH
+
+// HyperPlot includes
+#include "HyperPointSetColumns.h"
+
+// Root includes
+
+// std includes
+
+
+class HyperPointSetChunkSource {
+
+  public:
+
+  virtual int getDimension () const = 0; /**< Dimensionality of the points provided */
+  virtual int getNumWeights() const = 0; /**< Number of weights provided with each point */
+
+  virtual Long64_t getNumEntries() const{return -1;}
+  /**< Total number of points that will be provided, or -1 if unknown */
+
+  virtual int readChunk(HyperPointSetColumns& chunk, int chunkSize) = 0;
+  /**< Replace the contents of chunk with (at most) the next chunkSize points.
+  Return the number of points provided - zero means there are no points left */
+
+  virtual ~HyperPointSetChunkSource(){;} /**< Destructor */
+
+};
+
+
+#endif
+
@@ -0,0 +1,82 @@
+/**
+ * <B>HyperPlot</B>,
+ * Author: Sam Harnew, sam.harnew@gmail.com ,
+ * Date: Dec 2015
+ *
+ * A set of points stored column by column (one contiguous
+ * std::vector<double> per dimension and per weight) rather
+ * than as a std::vector of HyperPoints. This is the in-memory
+ * counterpart of the columnar HyperPointSet file format, and is
+ * what chunks are read into by the HyperPointSetReader.
+ *
+ **/
+
+
+#ifndef HYPERPOINTSETCOLUMNS_HH
+#define HYPERPOINTSETCOLUMNS_HH
+
+// HyperPlot includes
+#include "MessageService.h"
+#include "HyperPoint.h"
+#include "HyperPointSet.h"
+
+// Root includes
+#include "TFile.h"
+#include "TTree.h"
+
+// std includes
+#include <vector>
+
+
+class HyperPointSetColumns {
+
+  int _dimension;   /**< The dimensionality of the points */
+  int _numWeights;  /**< The number of weights stored for each point */
+  int _size;        /**< The number of points currently stored */
+
+  std::vector< std::vector<double> > _values;  /**< One column for each dimension, _values[dim][point] */
+  std::vector< std::vector<double> > _weights; /**< One column for each weight, _weights[w][point] */
+
+  public:
+
+  HyperPointSetColumns(int dimension, int numWeights = 0);
+  HyperPointSetColumns(const HyperPointSet& points);
+
+  const int& getDimension () const{return _dimension; } /**< Get the dimensionality of the points */
+  const int& getNumWeights() const{return _numWeights;} /**< Get the number of weights stored for each point */
+  int size() const{return _size;}                       /**< Get the number of points currently stored */
+
+  void reserve(int npoints);
+  void resize (int npoints);
+  void clear();
+
+  double& value (int point, int dim)      {return _values .at(dim).at(point);} /**< Get coordinate dim of point */
+  double  value (int point, int dim) const{return _values .at(dim).at(point);} /**< Get coordinate dim of point */
+  double& weight(int point, int w)        {return _weights.at(w  ).at(point);} /**< Get weight w of point */
+  double  weight(int point, int w = 0) const;
+
+  const std::vector<double>& getColumn      (int dim) const{return _values .at(dim);} /**< Get all the coordinates in dimension dim */
+  const std::vector<double>& getWeightColumn(int w  ) const{return _weights.at(w  );} /**< Get weight w for all points */
+  std::vector<double>& getColumn      (int dim){return _values .at(dim);} /**< Get all the coordinates in dimension dim */
+  std::vector<double>& getWeightColumn(int w  ){return _weights.at(w  );} /**< Get weight w for all points */
+
+  void push_back(const HyperPoint& point);
+
+  HyperPoint getHyperPoint(int i) const;
+  void getHyperPoint(int i, HyperPoint& point) const;
+  void appendTo(HyperPointSet& points) const;
+
+  void save(TString path) const;
+  void save() const;
+
+  static TString getTreeName(){return "HyperPointSetColumnar";} /**< Name of the TTree used for the columnar file format */
+  static TString getValueBranchName (int dim);
+  static TString getWeightBranchName(int w  );
+
+  virtual ~HyperPointSetColumns();
+
+};
+
+
+#endif
+
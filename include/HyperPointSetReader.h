@@ -0,0 +1,86 @@
+/**
+ * <B>HyperPlot</B>,
+ * Author: Sam Harnew, sam.harnew@gmail.com ,
+ * Date: Dec 2015
+ *
+ * Reads a HyperPointSet file in chunks of a fixed size, so that
+ * files much larger than the available memory can be processed.
+ * Both the columnar file format (one branch per dimension and
+ * weight, see HyperPointSetColumns) and the original format
+ * (std::vector<double> branches, see HyperPointSet::save) can
+ * be read. Each chunk is read into a HyperPointSetColumns that
+ * is reused between chunks, so no allocation happens once the
+ * first chunk has been read. This is the HyperPointSetChunkSource
+ * used to stream HyperPointSet files.
+ *
+ **/
+
+
+#ifndef HYPERPOINTSETREADER_HH
+#define HYPERPOINTSETREADER_HH
+
+// HyperPlot includes
+#include "MessageService.h"
+#include "HyperPointSet.h"
+#include "HyperPointSetColumns.h"
+#include "HyperPointSetChunkSource.h"
+
+// Root includes
+#include "TFile.h"
+#include "TTree.h"
+#include "TBranch.h"
+
+// std includes
+#include <vector>
+
+
+class HyperPointSetReader : public HyperPointSetChunkSource {
+
+  TFile* _file;          /**< The file being read */
+  TTree* _tree;          /**< The tree being read (either columnar or original format) */
+  bool   _columnar;      /**< Is the tree in the columnar format? */
+
+  int _dimension;        /**< Dimensionality of the points in the file */
+  int _numWeights;       /**< Number of weights stored for each point */
+
+  Long64_t _numEntries;   /**< Number of points in the file */
+  Long64_t _currentEntry; /**< The next entry to be read */
+
+  std::vector<TBranch*> _valueBranches;  /**< Columnar format: one branch per dimension */
+  std::vector<TBranch*> _weightBranches; /**< Columnar format: one branch per weight */
+  std::vector<double>   _valueBuffer;    /**< Columnar format: branch addresses for the values */
+  std::vector<double>   _weightBuffer;   /**< Columnar format: branch addresses for the weights */
+
+  std::vector<double>* _values;  /**< Original format: branch address for the values */
+  std::vector<double>* _weights; /**< Original format: branch address for the weights */
+  bool _ignoredWeights;          /**< Original format: has a point had more weights than the chunk could hold */
+
+  void openColumnar();
+  void openVector();
+
+  int readChunkColumnar(HyperPointSetColumns& chunk, int nEntries);
+  int readChunkVector  (HyperPointSetColumns& chunk, int nEntries);
+
+  public:
+
+  HyperPointSetReader(TString path);
+
+  bool isOpen() const{return _tree != 0;}                     /**< Was the file opened successfully? */
+  bool isColumnar() const{return _columnar;}                  /**< Is the file in the columnar format? */
+  virtual int getDimension () const{return _dimension; }      /**< Dimensionality of the points in the file */
+  virtual int getNumWeights() const{return _numWeights;}      /**< Number of weights stored for each point */
+  virtual Long64_t getNumEntries() const{return _numEntries;} /**< Number of points in the file */
+  Long64_t getCurrentEntry() const{return _currentEntry;}     /**< The next entry to be read */
+  bool finished() const{return _currentEntry >= _numEntries;} /**< Have all the points been read? */
+
+  virtual int readChunk(HyperPointSetColumns& chunk, int chunkSize);
+  int readPoints(HyperPointSet& points, int nPoints);
+  void rewind();
+
+  virtual ~HyperPointSetReader();
+
+};
+
+
+#endif
+
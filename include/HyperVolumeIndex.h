@@ -0,0 +1,80 @@
+/**
+ * <B>HyperPlot</B>,
+ * Author: Sam Harnew, sam.harnew@gmail.com ,
+ * Date: Dec 2015
+ *
+ * A bounding volume hierarchy over a list of HyperVolumes, used by
+ * HyperBinning to find which primary volume (or, for binnings
+ * without primary volumes, which volume) a HyperPoint falls into
+ * without testing every one of them. This matters for binnings
+ * merged from many files, which have one primary volume per file.
+ *
+ * The volumes are stored in the order they are added, and findVolume
+ * returns the first one (in that order) that contains the HyperPoint,
+ * so the result is the same as looping over the volumes in order.
+ * The HyperCuboids of each volume are copied into the index, so no
+ * HyperVolume needs to be fetched from the binning during a lookup.
+ *
+ **/
+
+
+#ifndef HYPERVOLUMEINDEX_HH
+#define HYPERVOLUMEINDEX_HH
+
+// HyperPlot includes
+#include "MessageService.h"
+#include "HyperPoint.h"
+#include "HyperVolume.h"
+
+// Root includes
+
+// std includes
+#include <vector>
+
+
+class HyperVolumeIndex {
+
+  int _dimension;                       /**< Dimensionality of the volumes */
+
+  std::vector<int>    _volumeNumbers;   /**< Volume number of each entry (in the order added) */
+  std::vector<int>    _cuboidStart;     /**< First HyperCuboid of each entry (there is one extra element at the end) */
+  std::vector<double> _cuboidLow;       /**< Low corners of all the HyperCuboids, [cuboid*dim + d] */
+  std::vector<double> _cuboidHigh;      /**< High corners of all the HyperCuboids, [cuboid*dim + d] */
+  std::vector<double> _entryLow;        /**< Low corner of the box around each entry, [entry*dim + d] */
+  std::vector<double> _entryHigh;       /**< High corner of the box around each entry, [entry*dim + d] */
+
+  std::vector<int>    _order;           /**< Entries, reordered so each leaf node holds a contiguous range */
+  std::vector<double> _nodeLow;         /**< Low corner of the box around each node, [node*dim + d] */
+  std::vector<double> _nodeHigh;        /**< High corner of the box around each node, [node*dim + d] */
+  std::vector<int>    _nodeFirst;       /**< First element of _order in each node */
+  std::vector<int>    _nodeCount;       /**< Number of elements of _order in each node */
+  std::vector<int>    _nodeLeft;        /**< Left child of each node (-1 for a leaf) */
+  std::vector<int>    _nodeRight;       /**< Right child of each node (-1 for a leaf) */
+  std::vector<int>    _nodeMinEntry;    /**< Lowest entry number in each node */
+
+  static const int s_leafSize = 8;      /**< Maximum number of entries in a leaf node */
+
+  int  buildNode(int first, int count);
+  bool inEntry(int entry, const HyperPoint& coords) const;
+  bool inBox(const double* low, const double* high, const HyperPoint& coords) const;
+
+  public:
+
+  HyperVolumeIndex(int dimension = 0);
+
+  void clear(int dimension);
+  void addVolume(int volumeNumber, const HyperVolume& volume);
+  void build();
+
+  int size() const{return _volumeNumbers.size();} /**< Number of volumes in the index */
+  int getNumNodes() const{return _nodeFirst.size();} /**< Number of nodes in the hierarchy */
+
+  int findVolume(const HyperPoint& coords) const;
+
+  ~HyperVolumeIndex();
+
+};
+
+
+
+#endif
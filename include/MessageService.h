@@ -9,122 +9,176 @@
  * definitions.
  *
  *  WELCOME_LOG  - A welcome message in the constructor of each class
- *  ERROR_LOG    - Use to print error messages to the screen 
+ *  ERROR_LOG    - Use to print error messages to the screen
  *  INFO_LOG     - Use to print useful information to the screen
  *  VERBOSE_LOG  - Use for verbose information
  *  GOODBYE_LOG  - A goodbye message in the destructor of each class
  *
  *  ERROR_COUNT  - Print out how many error messages have been shown.
  *                 This is useful to call at the end of the main function
- * 
+ *
+ * If a message type is turned off, the macros only check one flag,
+ * and nothing after the << is evaluated. Message types can also be
+ * removed at compile time by defining HYPERPLOT_LOG_LEVEL
+ * (e.g. make LOG_LEVEL=1):
+ *
+ *  -1 - no messages
+ *   0 - ERROR
+ *   1 - ERROR and INFO
+ *   2 - ERROR, INFO and VERBOSE
+ *   3 - everything (the default)
+ *
+ * Each thread builds its messages in its own MessageStream, and
+ * only hands complete lines to the MessageSerivce, so messages from
+ * different threads are never mixed up. By default each line is
+ * written straight away, but they can be buffered (setBufferSize)
+ * or written by a separate thread (setAsynchronous).
  *
  **/
- 
+
 #ifndef MESSAGE_SERVICE_HH
 #define MESSAGE_SERVICE_HH
 
 #include <iostream>
 #include <sstream>
-#include <map>
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
 
 #include "TString.h"
 
+#ifndef HYPERPLOT_LOG_LEVEL
+#define HYPERPLOT_LOG_LEVEL 3
+#endif
+
+class MessageStream;
 
 class MessageSerivce{
-  
-  private:
-  
-  ///static variable that holds the singleton object
-  static MessageSerivce* s_messageService;
-  
-  MessageSerivce();
-  
+
   public:
-  
+
   ///Define the possible error types
   enum ErrorType{WELCOME, ERROR, INFO, VERBOSE, GOODBYE};
 
-  ///the output stream - by default this is std:cout
-  std::ostream& _stream;
+  private:
 
-  ///this map decides what message types should be printed 
+  ///this decides what message types should be printed
   ///to the output stream (verbose, welcome and goodbye
   ///are off by default)
-  std::map<ErrorType, bool>    _outputOptions;
+  static std::atomic<bool> s_outputOptions[5];
 
-  ///this is the string that proceeds each of the 
-  ///message types
-  std::map<ErrorType, TString> _outputHeaders;
-  
-  ///bool was the last command sent to the steam
-  ///a std::cout ?
-  bool _endlCalled;
+  MessageSerivce();
+
+  ///Lines that haven't been written to the stream yet
+  ///
+  std::string _buffer;
+
+  ///Write the buffer once it's this big (0 means every
+  ///line is written straight away)
+  size_t _bufferSize;
 
-  ///For the current message type, should I be printing
-  ///to the stream (means you don't have to use the map
-  ///many times in a row i.e. faster)
-  bool _printOrNot;
+  ///Protects _buffer
+  ///
+  std::mutex _bufferMutex;
+
+  ///Held while writing to the stream, so lines are written
+  ///in the order they were added to the buffer
+  std::mutex _streamMutex;
 
-  ///The current message type of the MessageSerivce 
+  ///Thread that writes the buffer when running asynchronously
   ///
-  ErrorType _errorType;
-  
+  std::thread* _writerThread;
+  std::condition_variable _writerCondition;
+  bool _stopWriter;
+
+  void writeBuffer();
+  void writerLoop();
+
+  static void finalise();
+
+  public:
+
+  ///the output stream - by default this is std:cout
+  std::ostream& _stream;
+
+  ///this is the string that proceeds each of the
+  ///message types
+  TString _outputHeaders[5];
+
   ///Count the number of errors that happened.
   ///
-  long int _errorCount;
+  std::atomic<long> _errorCount;
 
-  static MessageSerivce& getMessageService(ErrorType errorType);
   static MessageSerivce& getMessageService();
+  static MessageStream&  getMessageStream(ErrorType errorType);
 
-  void printErrorCount();
-  
-  ///This makes is possible the do messageSerivce << 
+  ///The importance of each message type (lower is more important)
   ///
-  template <class T>MessageSerivce  &operator<< (const T &v) 
-  { 
-  
-    if (_printOrNot) {
-      if (_endlCalled){
-        _stream << _outputHeaders[_errorType];
-        if (_errorType == ERROR) _errorCount++;
-        _endlCalled = 0;
-      }
-      _stream << v;
-    }
-    return *this;
+  static constexpr int getLevel(ErrorType errorType){
+    return errorType == ERROR ? 0 : (errorType == INFO ? 1 : (errorType == VERBOSE ? 2 : 3));
+  }
+
+  ///Should messages of this type be printed? If the type is
+  ///removed at compile time this is always false, otherwise it's
+  ///a single (relaxed) atomic load.
+  static bool isEnabled(ErrorType errorType){
+    return getLevel(errorType) <= HYPERPLOT_LOG_LEVEL && s_outputOptions[errorType].load(std::memory_order_relaxed);
   }
-  
-  //This allows you to make a custom endl (MessageSerivce::endl).
-  //Don't think I need it, but interesting
 
-  // function that takes a custom stream, and returns it
-  //typedef MessageSerivce& (*MessageSerivceManipulator)(MessageSerivce&);
-  
+  static void setOutputOption(ErrorType errorType, bool print);
+
+  void write(const std::string& lines, bool flushNow);
+  void flush();
+
+  void setBufferSize  (size_t nBytes);
+  void setAsynchronous(bool asynchronous);
+  bool isAsynchronous() const{return _writerThread != 0;} /**< Are messages written by a separate thread? */
+
+  void printErrorCount();
+
+  ~MessageSerivce();
+
+};
+
+
+/** Builds up the messages of one thread, and passes each
+complete line to the MessageSerivce. There is one per thread,
+which is found by MessageSerivce::getMessageStream. */
+class MessageStream{
+
+  private:
+
+  ///the line being built
+  ///
+  std::ostringstream _line;
 
-  // take in a function with the custom signature
-  // MessageSerivce& operator<<(MessageSerivceManipulator manip)
-  // {
-  //   call the function, and return it's value
-  //   return manip(*this);
-  //  }
+  ///The current message type of the MessageStream
+  ///
+  MessageSerivce::ErrorType _errorType;
 
-  // define the custom endl for this stream.
-  // note how it matches the `MessageSerivceManipulator`
-  // function signature
-  //  static MessageSerivce& endl(MessageSerivce& stream)
-  //  {
-  // print a new line
-  //   std::cout << std::endl;
+  ///bool was the last command sent to the steam
+  ///a std::endl ?
+  bool _endlCalled;
 
-  // do other stuff with the stream
-  // std::cout, for example, will flush the stream
-  //   stream << "Called MessageSerivce::endl!" << std::endl;
+  void startLine();
+  void endLine();
 
-  //   return stream;
-  //  }
+  public:
 
-  //The following makes endl work
+  MessageStream();
 
+  void setErrorType(MessageSerivce::ErrorType errorType);
+
+  ///This makes is possible the do messageStream <<
+  ///
+  template <class T>MessageStream  &operator<< (const T &v)
+  {
+    if (_endlCalled) startLine();
+    _line << v;
+    return *this;
+  }
 
   /// this is the type of std::cout
   ///
@@ -136,30 +190,39 @@ class MessageSerivce{
 
   /// define an operator<< to take in std::endl
   ///
-  MessageSerivce& operator<<(StandardEndLine manip)
-  { 
-    //SAM -> I'm assuming that when this gets called it's 
+  MessageStream& operator<<(StandardEndLine manip)
+  {
+    //SAM -> I'm assuming that when this gets called it's
     //always endl - I imagine this isn't always the case.
-    if (_printOrNot){
-      _endlCalled = true;
-
-    // call the function, but we cannot return it's value
-      _stream << "\033[0m";
-      manip(_stream);
-      
-    }
+    (void)manip;
+    if (_endlCalled) startLine();
+    endLine();
     return *this;
   }
 
-  ~MessageSerivce(); 
+  ~MessageStream();
 
 };
 
-#define WELCOME_LOG MessageSerivce::getMessageService(MessageSerivce::WELCOME)
-#define ERROR_LOG   MessageSerivce::getMessageService(MessageSerivce::ERROR  )
-#define INFO_LOG    MessageSerivce::getMessageService(MessageSerivce::INFO   )
-#define VERBOSE_LOG MessageSerivce::getMessageService(MessageSerivce::VERBOSE)
-#define GOODBYE_LOG MessageSerivce::getMessageService(MessageSerivce::GOODBYE)
+/** Turns a whole `stream << a << b` expression into void, so
+HYPERPLOT_LOG can use the conditional operator. operator& binds
+less tightly than operator<<, so it's applied last. */
+class MessageVoidify {
+  public:
+  MessageVoidify(){}
+  void operator&(MessageStream&){}
+};
+
+//nothing after the << is evaluated when the message type is turned
+//off, and the whole message is a single expression, so it can be the
+//unbraced body of an if (without a dangling else)
+#define HYPERPLOT_LOG(errorType) !MessageSerivce::isEnabled(errorType) ? (void)0 : MessageVoidify() & MessageSerivce::getMessageStream(errorType)
+
+#define WELCOME_LOG HYPERPLOT_LOG(MessageSerivce::WELCOME)
+#define ERROR_LOG   HYPERPLOT_LOG(MessageSerivce::ERROR  )
+#define INFO_LOG    HYPERPLOT_LOG(MessageSerivce::INFO   )
+#define VERBOSE_LOG HYPERPLOT_LOG(MessageSerivce::VERBOSE)
+#define GOODBYE_LOG HYPERPLOT_LOG(MessageSerivce::GOODBYE)
 
 #define ERROR_COUNT MessageSerivce::getMessageService().printErrorCount();
 
@@ -0,0 +1,92 @@
+/**
+ * <B>HyperPlot</B>,
+ * Author: Sam Harnew, sam.harnew@gmail.com ,
+ * Date: Dec 2015
+ *
+ * Draws a set of plots in several worker processes. ROOT graphics
+ * isn't thread safe, so rather than threads, the pool forks one
+ * process per worker - each has its own copy of the ROOT graphics
+ * state. Anything made before run() is called (e.g. the slice
+ * histograms) is shared with the workers through the fork
+ * (copy-on-write), so nothing has to be copied or written to file.
+ *
+ * The workers take the next job from a counter in shared memory,
+ * so the plots are spread evenly even if some take longer than
+ * others. Each job is marked done in shared memory, so the parent
+ * knows which plots were made once the workers have finished.
+ *
+ * ~~~ {.cpp}
+ * class DrawJob : public RenderJob{
+ *   void render(int i){ hists.at(i).draw(paths.at(i)); }
+ * };
+ *
+ * DrawJob job;
+ * RenderPool pool;
+ * pool.run(nPlots, job);
+ * ~~~
+ *
+ * Forking is opt-in (see s_numWorkers), and only happens when ROOT
+ * is in batch mode - in an interactive session the workers would
+ * share the parent's X11 connection. Jobs that read from an open
+ * file (e.g. a disk resident binning) can't be forked either, as the
+ * workers would share the file offset, so RenderJob::canFork lets a
+ * job say so. Otherwise, or if fork isn't available, the jobs are
+ * run one after another in the calling process.
+ *
+ **/
+
+
+#ifndef RENDERPOOL_HH
+#define RENDERPOOL_HH
+
+// HyperPlot includes
+#include "MessageService.h"
+
+// Root includes
+
+// std includes
+#include <vector>
+
+
+/** A set of plots to be drawn by a RenderPool */
+class RenderJob {
+
+  public:
+
+  virtual void render(int i) = 0; /**< Draw the i'th plot */
+
+  virtual bool canFork() const{return true;}
+  /**< Can the plots be drawn in forked workers? Return false if drawing
+  reads from files opened before the fork (the workers would share them) */
+
+  virtual ~RenderJob(){}
+
+};
+
+
+class RenderPool {
+
+  int _numWorkers; /**< Number of worker processes to fork */
+
+  int runSerial  (int nJobs, RenderJob& job);
+  int runParallel(int nJobs, RenderJob& job);
+
+  public:
+
+  static int s_numWorkers;
+  /**< Number of workers used by a RenderPool if none are given
+  (0 means one per core). This is 1 by default, so everything is drawn
+  in the calling process unless parallel drawing is asked for */
+
+  RenderPool(int numWorkers = -1);
+
+  int getNumWorkers() const{return _numWorkers;} /**< Number of worker processes used */
+
+  int run(int nJobs, RenderJob& job);
+
+  ~RenderPool();
+
+};
+
+
+#endif
@@ -0,0 +1,73 @@
+/**
+ * <B>HyperPlot</B>,
+ * Author: Sam Harnew, sam.harnew@gmail.com ,
+ * Date: Dec 2015
+ *
+ * Reads single entries of an int branch of a TTree, keeping the
+ * file open between reads. The file is only opened when the first
+ * entry is read, so it costs nothing if it's never used. Only the
+ * basket that holds the entry is decompressed.
+ *
+ * This is used by HyperBinning to look up a few bin numbers from
+ * a saved binning without reading the whole column, which is what
+ * BulkTreeReader is for.
+ *
+ * It isn't thread safe - the owner must stop several threads reading
+ * at once. Copies don't share the open file; they open their own.
+ *
+ * ~~~ {.cpp}
+ * TreeEntryReader reader("hist.root", "HyperBinningVolumeBins", "binNumber");
+ * int binNumber = -1;
+ * reader.read(volumeNumber, binNumber);
+ * ~~~
+ *
+ **/
+
+
+#ifndef TREEENTRYREADER_HH
+#define TREEENTRYREADER_HH
+
+// HyperPlot includes
+#include "MessageService.h"
+
+// Root includes
+#include "TFile.h"
+#include "TTree.h"
+#include "TBranch.h"
+#include "TString.h"
+
+
+class TreeEntryReader {
+
+  TString  _filename;     /**< The file being read (empty if there isn't one) */
+  TString  _treeName;     /**< The tree being read */
+  TString  _branchName;   /**< The branch being read */
+
+  TFile*   _file;         /**< The open file, or 0 if it hasn't been opened yet */
+  TBranch* _branch;       /**< The branch being read, or 0 if it hasn't been opened yet */
+  int      _value;        /**< Where the branch writes each entry */
+  Long64_t _numEntries;   /**< Number of entries in the tree */
+  int      _numReads;     /**< Number of entries read so far */
+  bool     _failed;       /**< The file or branch couldn't be opened, so don't try again */
+
+  bool openFile();
+
+  public:
+
+  TreeEntryReader();
+  TreeEntryReader(TString filename, TString treeName, TString branchName);
+  TreeEntryReader(const TreeEntryReader& other);
+  TreeEntryReader& operator=(const TreeEntryReader& other);
+
+  bool isSet() const{return _filename != "" && _failed == false;} /**< Is there a branch that can be read? */
+  int getNumReads() const{return _numReads;}                         /**< Number of entries read so far */
+
+  bool read(Long64_t entry, int& value);
+  void close();
+
+  ~TreeEntryReader();
+
+};
+
+
+#endif
@@ -72,6 +72,45 @@ std::vector<int> BinningBase::getBinNum(const HyperPointSet& coords) const{
   return binNums;
 } 
 
+///Find the bin of every point in a HyperPointSetColumns. Each point is
+///copied in turn into the same HyperPoint, so no HyperPointSet is made -
+///except for disk resident binnings, where looking up all the points
+///together (see getBinNum(const HyperPointSet&)) saves many more reads
+///than the copy costs.
+std::vector<int> BinningBase::getBinNum(const HyperPointSetColumns& coords) const{
+
+  if (isDiskResident()){
+    HyperPointSet points(coords.getDimension());
+    points.reserve(coords.size());
+    coords.appendTo(points);
+    return getBinNum(points);
+  }
+
+  int nPoints = coords.size();
+  int dim     = coords.getDimension();
+
+  std::vector<const double*> columns(dim, 0);
+  for (int d = 0; d < dim && nPoints != 0; d++) columns.at(d) = &coords.getColumn(d).at(0);
+
+  std::vector<int> binNums;
+  binNums.reserve(nPoints);
+
+  HyperPoint point(dim);
+
+  for (int i = 0; i < nPoints; i++){
+    for (int d = 0; d < dim; d++) point.at(d) = columns[d][i];
+    binNums.push_back( getBinNum(point) );
+  }
+  return binNums;
+}
+
+///A hash of the bins, so two binnings can quickly be checked to be
+///identical (see HyperHistogram::merge). Zero means the binning
+///type can't make one, and it will never match another binning.
+ULong64_t BinningBase::getFingerprint() const{
+  return 0;
+}
+
 
 BinningBase::~BinningBase(){
 
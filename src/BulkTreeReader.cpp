@@ -0,0 +1,316 @@
+#include "BulkTreeReader.h"
+
+// Root includes
+#include "TROOT.h"
+
+// std includes
+#include <future>
+#include <thread>
+
+int      BulkTreeReader::s_numThreads = 0;
+Long64_t BulkTreeReader::s_cacheSize  = 64*1024*1024;
+
+///Constructor that takes the file and the name of the tree
+///to read. If numThreads is zero, s_numThreads is used.
+BulkTreeReader::BulkTreeReader(TString filename, TString treeName, int numThreads) :
+  _filename  (filename),
+  _treeName  (treeName),
+  _numThreads(numThreads),
+  _numEntries(-1)
+{
+  WELCOME_LOG << "Hello from the BulkTreeReader() Constructor";
+
+  if (_numThreads <= 0) _numThreads = s_numThreads;
+  if (_numThreads <= 0) _numThreads = std::thread::hardware_concurrency();
+  if (_numThreads <= 0) _numThreads = 1;
+
+  TTree* tree = 0;
+  TFile* file = openFile(tree);
+
+  if (file == 0) return;
+
+  _numEntries = tree->GetEntries();
+
+  file->Close();
+  delete file;
+
+}
+
+///Open a new copy of the file, and find the tree. Returns 0
+///(and closes the file) if either can't be opened.
+TFile* BulkTreeReader::openFile(TTree*& tree) const{
+
+  TFile* file = new TFile(_filename, "READ");
+
+  if (file == 0 || file->IsZombie()){
+    ERROR_LOG << "BulkTreeReader - cannot open file at " << _filename << std::endl;
+    delete file;
+    return 0;
+  }
+
+  tree = dynamic_cast<TTree*>( file->Get(_treeName) );
+
+  if (tree == 0){
+    ERROR_LOG << "BulkTreeReader - cannot find the tree " << _treeName << " in " << _filename << std::endl;
+    file->Close();
+    delete file;
+    return 0;
+  }
+
+  return file;
+
+}
+
+///Add a branch of doubles to be read by read(). Entry i is
+///written to destination[i*stride], so the destination must
+///have space for (getNumEntries() - 1)*stride + 1 doubles.
+void BulkTreeReader::addColumn(TString branchName, double* destination, int stride){
+  Column column;
+  column.name    = branchName;
+  column.doubles = destination;
+  column.ints    = 0;
+  column.chars   = 0;
+  column.stride  = stride;
+  _columns.push_back(column);
+}
+
+///Add a branch of ints to be read by read(). Entry i is
+///written to destination[i*stride].
+void BulkTreeReader::addColumn(TString branchName, int* destination, int stride){
+  Column column;
+  column.name    = branchName;
+  column.doubles = 0;
+  column.ints    = destination;
+  column.chars   = 0;
+  column.stride  = stride;
+  _columns.push_back(column);
+}
+
+///Add a branch of chars (leaf type B) to be read by read().
+///Entry i is written to destination[i*stride].
+void BulkTreeReader::addColumn(TString branchName, Char_t* destination, int stride){
+  Column column;
+  column.name    = branchName;
+  column.doubles = 0;
+  column.ints    = 0;
+  column.chars   = destination;
+  column.stride  = stride;
+  _columns.push_back(column);
+}
+
+///Remove all the columns added with addColumn
+///
+void BulkTreeReader::clearColumns(){
+  _columns.clear();
+}
+
+///Read some of the columns, using a new copy of the file.
+///Every entry of one branch is read before moving on to the next.
+bool BulkTreeReader::readColumns(std::vector<int> columns) const{
+
+  TTree* tree = 0;
+  TFile* file = openFile(tree);
+
+  if (file == 0) return false;
+
+  tree->SetCacheSize(s_cacheSize);
+  for (unsigned i = 0; i < columns.size(); i++){
+    tree->AddBranchToCache(_columns.at(columns.at(i)).name, true);
+  }
+
+  bool success = true;
+
+  for (unsigned i = 0; i < columns.size(); i++){
+
+    const Column& column = _columns.at(columns.at(i));
+
+    TBranch* branch = tree->GetBranch(column.name);
+
+    if (branch == 0){
+      ERROR_LOG << "BulkTreeReader::read - cannot find the branch " << column.name << std::endl;
+      success = false;
+      continue;
+    }
+
+    if (column.doubles != 0){
+      double value = 0.0;
+      branch->SetAddress(&value);
+      for (Long64_t ent = 0; ent < _numEntries; ent++){
+        branch->GetEntry(ent);
+        column.doubles[ent*column.stride] = value;
+      }
+    }
+    else if (column.chars != 0){
+      Char_t value = 0;
+      branch->SetAddress(&value);
+      for (Long64_t ent = 0; ent < _numEntries; ent++){
+        branch->GetEntry(ent);
+        column.chars[ent*column.stride] = value;
+      }
+    }
+    else{
+      int value = 0;
+      branch->SetAddress(&value);
+      for (Long64_t ent = 0; ent < _numEntries; ent++){
+        branch->GetEntry(ent);
+        column.ints[ent*column.stride] = value;
+      }
+    }
+
+    branch->SetAddress(0);
+  }
+
+  file->Close();
+  delete file;
+
+  return success;
+
+}
+
+///Read every column added with addColumn. The columns are shared
+///between the threads so that each has a similar number to read.
+bool BulkTreeReader::read(){
+
+  if (isOpen() == false) return false;
+  if (_numEntries == 0 || _columns.size() == 0) return true;
+
+  int nThreads = _numThreads;
+  if (nThreads > int(_columns.size())) nThreads = _columns.size();
+
+  std::vector< std::vector<int> > columnsPerThread(nThreads);
+  for (unsigned i = 0; i < _columns.size(); i++){
+    columnsPerThread.at(i % nThreads).push_back(i);
+  }
+
+  if (nThreads == 1) return readColumns(columnsPerThread.at(0));
+
+  //Every thread has its own TFile, but ROOT still needs to
+  //protect its global state
+  ROOT::EnableThreadSafety();
+
+  std::vector< std::future<bool> > results;
+  for (int t = 0; t < nThreads; t++){
+    results.push_back( std::async(std::launch::async, &BulkTreeReader::readColumns, this, columnsPerThread.at(t)) );
+  }
+
+  bool success = true;
+  for (int t = 0; t < nThreads; t++){
+    if (results.at(t).get() == false) success = false;
+  }
+
+  return success;
+
+}
+
+///Read a std::vector<int> branch for some of the entries (in
+///increasing order) using a new copy of the file. The values of
+///each entry are appended to values, and their number to sizes.
+bool BulkTreeReader::readVectorRange(TString branchName, const Long64_t* entries, int nEntries,
+                                     std::vector<int>* values, std::vector<int>* sizes) const{
+
+  TTree* tree = 0;
+  TFile* file = openFile(tree);
+
+  if (file == 0) return false;
+
+  TBranch* branch = tree->GetBranch(branchName);
+
+  if (branch == 0){
+    ERROR_LOG << "BulkTreeReader::readVectorColumn - cannot find the branch " << branchName << std::endl;
+    file->Close();
+    delete file;
+    return false;
+  }
+
+  tree->SetCacheSize(s_cacheSize);
+  tree->AddBranchToCache(branchName, true);
+
+  std::vector<int>* value = new std::vector<int>();
+  branch->SetAddress(&value);
+
+  sizes->reserve(nEntries);
+
+  for (int i = 0; i < nEntries; i++){
+    branch->GetEntry(entries[i]);
+    values->insert(values->end(), value->begin(), value->end());
+    sizes ->push_back(value->size());
+  }
+
+  branch->SetAddress(0);
+  delete value;
+
+  file->Close();
+  delete file;
+
+  return true;
+
+}
+
+///Read a std::vector<int> branch for some of the entries (which
+///must be in increasing order). The vectors are stored one after
+///the other in values, and those of entries[i] are elements
+///offsets[i] to offsets[i+1] - 1. The entries are split into one
+///contiguous range per thread.
+bool BulkTreeReader::readVectorColumn(TString branchName, const std::vector<Long64_t>& entries,
+                                      std::vector<int>& values, std::vector<int>& offsets) const{
+
+  values .clear();
+  offsets.assign(1, 0);
+
+  if (isOpen() == false) return false;
+
+  int nEntries = entries.size();
+  if (nEntries == 0) return true;
+
+  //don't bother with threads that would only read a few entries
+  int nThreads = _numThreads;
+  if (nThreads > nEntries/1000 + 1) nThreads = nEntries/1000 + 1;
+
+  std::vector< std::vector<int> > valuesPerThread(nThreads);
+  std::vector< std::vector<int> > sizesPerThread (nThreads);
+
+  bool success = true;
+
+  if (nThreads == 1){
+    success = readVectorRange(branchName, &entries.at(0), nEntries, &valuesPerThread.at(0), &sizesPerThread.at(0));
+  }
+  else{
+    ROOT::EnableThreadSafety();
+
+    std::vector< std::future<bool> > results;
+    for (int t = 0; t < nThreads; t++){
+      int first = (Long64_t(nEntries)*t      )/nThreads;
+      int last  = (Long64_t(nEntries)*(t + 1))/nThreads;
+      results.push_back( std::async(std::launch::async, &BulkTreeReader::readVectorRange, this, branchName,
+                                    &entries.at(0) + first, last - first, &valuesPerThread.at(t), &sizesPerThread.at(t)) );
+    }
+    for (int t = 0; t < nThreads; t++){
+      if (results.at(t).get() == false) success = false;
+    }
+  }
+
+  if (success == false) return false;
+
+  int nValues = 0;
+  for (int t = 0; t < nThreads; t++) nValues += valuesPerThread.at(t).size();
+
+  values .reserve(nValues);
+  offsets.reserve(nEntries + 1);
+
+  for (int t = 0; t < nThreads; t++){
+    values.insert(values.end(), valuesPerThread.at(t).begin(), valuesPerThread.at(t).end());
+    for (unsigned i = 0; i < sizesPerThread.at(t).size(); i++){
+      offsets.push_back( offsets.back() + sizesPerThread.at(t).at(i) );
+    }
+  }
+
+  return true;
+
+}
+
+///Destructor
+///
+BulkTreeReader::~BulkTreeReader(){
+  GOODBYE_LOG << "Goodbye from the BulkTreeReader() Destructor";
+}
+
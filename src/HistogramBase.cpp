@@ -12,7 +12,8 @@ HistogramBase::HistogramBase(int nBins) :
   _min(-999.9),
   _max(-999.9),
   _minDensity(-999.9),
-  _maxDensity(-999.9)
+  _maxDensity(-999.9),
+  _contentsVersion(0)
 {
   WELCOME_LOG << "Good day from the HistogramBase() Constructor"; 
 }
@@ -20,12 +21,14 @@ HistogramBase::HistogramBase(int nBins) :
 ///Update the number of bins and set all contents to zero
 ///
 void HistogramBase::resetBinContents(int nBins){
+  contentsChanged();
   _nBins = nBins;
   _binContents = std::vector<double>(nBins+1,0.0);
   _sumW2       = std::vector<double>(nBins+1,0.0);
 }
 
 void HistogramBase::clear(){
+  contentsChanged();
   for (unsigned i = 0; i < _binContents.size(); i++){
     _binContents.at(i) = 0.0;
     _sumW2      .at(i) = 0.0;
@@ -44,6 +47,7 @@ void HistogramBase::reserveCapacity(int nElements){
 ///Merge one HistogramBase with another
 ///
 void HistogramBase::merge( const HistogramBase& other ){
+  contentsChanged();
   
   double overflowCont = _binContents.at(_nBins);
   overflowCont += other._binContents.at(other._nBins);
@@ -111,35 +115,73 @@ void HistogramBase::saveBase(TString filename){
 }
 
 /// Load the contents, sumw2, and bin numbers from a TTree
-/// in the ROOT file specified (opened using READ)
+/// in the ROOT file specified (opened using READ). The 
+/// branches are read in bulk (see BulkTreeReader).
 void HistogramBase::loadBase(TString filename){
+  contentsChanged();
 
-  TFile file(filename, "READ");
-  TTree* tree = (TTree*)file.Get("HistogramBase");
+  BulkTreeReader reader(filename, "HistogramBase");
 
-  int    binNumber  = -1;
-  double binContent = 0.0;
-  double sumW2      = 0.0;
-  
-  int nEntries = tree->GetEntries();
+  if (reader.isOpen() == false){
+    ERROR_LOG << "HistogramBase::loadBase - could not load the bin contents from " << filename << std::endl;
+    return;
+  }
+
+  int nEntries = reader.getNumEntries();
 
-  tree->SetBranchAddress("binNumber" , &binNumber );
-  tree->SetBranchAddress("binContent", &binContent);
-  tree->SetBranchAddress("sumW2"     , &sumW2     );
-  
   this->resetBinContents(nEntries - 1);
 
+  if (nEntries == 0) return;
 
-  for(int ent = 0; ent < nEntries; ent++){
-    tree->GetEntry(ent);
-    
-    VERBOSE_LOG << "Bin = " << binNumber << "       Content = " << binContent << "        SumW2 = " << sumW2;
+  //The bins are saved in order, so read the contents 
+  //straight into place and check the bin numbers afterwards
+
+  std::vector<int> binNumbers(nEntries, -1);
+
+  reader.addColumn("binNumber" , &binNumbers  .at(0));
+  reader.addColumn("binContent", &_binContents.at(0));
+  reader.addColumn("sumW2"     , &_sumW2      .at(0));
 
-    _binContents.at((int)binNumber) = binContent;
-    _sumW2      .at((int)binNumber) = sumW2;
+  if (reader.read() == false){
+    ERROR_LOG << "HistogramBase::loadBase - could not load the bin contents from " << filename << std::endl;
+    return;
   }
-  
-  file.Close();
+
+  bool inOrder = true;
+  for (int ent = 0; ent < nEntries; ent++){
+    if (binNumbers[ent] != ent) { inOrder = false; break; }
+  }
+
+  if (inOrder) return;
+
+  std::vector<double> binContents(_binContents);
+  std::vector<double> sumW2      (_sumW2      );
+
+  for (int ent = 0; ent < nEntries; ent++){
+    if (binNumbers.at(ent) < 0 || binNumbers.at(ent) >= nEntries){
+      ERROR_LOG << "HistogramBase::loadBase - bin number " << binNumbers.at(ent) << " is out of range" << std::endl;
+      continue;
+    }
+    _binContents.at(binNumbers.at(ent)) = binContents.at(ent);
+    _sumW2      .at(binNumbers.at(ent)) = sumW2      .at(ent);
+  }
+
+}
+
+/// Add the contents and sumw2 saved in the ROOT file specified
+/// (see saveBase) to this histogram's. They must have the same 
+/// number of bins.
+void HistogramBase::addBase(TString filename){
+
+  HistogramBase other(0);
+  other.loadBase(filename);
+
+  if (other._nBins != _nBins){
+    ERROR_LOG << "HistogramBase::addBase - " << filename << " has " << other._nBins << " bins, not " << _nBins << ". Doing nothing." << std::endl;
+    return;
+  }
+
+  add(other);
 
 }
 
@@ -153,6 +195,7 @@ HistogramBase::~HistogramBase(){
 ///Note that the bin numbers run from 0 to nBins-1 inclusive
 /// so that nBins is overflow/underflow
 void HistogramBase::fillBase(int binNum, double weight){
+  contentsChanged();
   binNum = checkBinNumber(binNum);
   _binContents[binNum] += weight;
   _sumW2[binNum]       += weight*weight;
@@ -219,6 +262,7 @@ double HistogramBase::getMaxDensity() const{
 ///Divide this hitogram by another.
 ///Histograms must have the same number of bins
 void HistogramBase::divide(const HistogramBase& other){
+  contentsChanged();
  
   if (other._binContents.size() != _binContents.size()){
     ERROR_LOG << "Trying to divide histograms with different numbers of bins. Doing nothing.";
@@ -252,6 +296,7 @@ void HistogramBase::divide(const HistogramBase& other){
 ///Multiply this hitogram by another.
 ///Histograms must have the same number of bins
 void HistogramBase::multiply(const HistogramBase& other){
+  contentsChanged();
 
   if (other._binContents.size() != _binContents.size()){
     ERROR_LOG << "Trying to divide histograms with different numbers of bins. Doing nothing.";
@@ -284,6 +329,7 @@ void HistogramBase::multiply(const HistogramBase& other){
 ///Add this hitogram to another.
 ///Histograms must have the same number of bins
 void HistogramBase::add(const HistogramBase& other){
+  contentsChanged();
 
   if (other._binContents.size() != _binContents.size()){
     ERROR_LOG << "Trying to divide histograms with different numbers of bins. Doing nothing.";
@@ -314,6 +360,7 @@ void HistogramBase::add(const HistogramBase& other){
 ///Subtract other histogram from this one.
 ///Histograms must have the same number of bins
 void HistogramBase::minus(const HistogramBase& other){
+  contentsChanged();
 
   if (other._binContents.size() != _binContents.size()){
     ERROR_LOG << "Trying to divide histograms with different numbers of bins. Doing nothing.";
@@ -344,6 +391,7 @@ void HistogramBase::minus(const HistogramBase& other){
 ///Find pulls between this histogram and another.
 ///Histograms must have the same number of bins
 void HistogramBase::pulls(const HistogramBase& other){
+  contentsChanged();
 
   if (other._binContents.size() != _binContents.size()){
     ERROR_LOG << "Trying to divide histograms with different numbers of bins. Doing nothing.";
@@ -374,6 +422,7 @@ void HistogramBase::pulls(const HistogramBase& other){
 ///Find pulls between two histograms.
 ///Histograms must have the same number of bins
 void HistogramBase::pulls(const HistogramBase& other1, const HistogramBase& other2){
+  contentsChanged();
 
   if (other1._binContents.size() != _binContents.size() || other2._binContents.size() != _binContents.size()){
     ERROR_LOG << "Trying to divide histograms with different numbers of bins. Doing nothing.";
@@ -402,6 +451,7 @@ void HistogramBase::pulls(const HistogramBase& other1, const HistogramBase& othe
 
 
 void HistogramBase::asymmetry(const HistogramBase& other){
+  contentsChanged();
 
   if (other._binContents.size() != _binContents.size()){
     ERROR_LOG << "Trying to divide histograms with different numbers of bins. Doing nothing.";
@@ -433,6 +483,7 @@ void HistogramBase::asymmetry(const HistogramBase& other){
 }
 
 void HistogramBase::asymmetry(const HistogramBase& other1, const HistogramBase& other2){
+  contentsChanged();
 
   if (other1._binContents.size() != _binContents.size() || other2._binContents.size() != _binContents.size()){
     ERROR_LOG << "Trying to divide histograms with different numbers of bins. Doing nothing.";
@@ -470,6 +521,7 @@ void HistogramBase::asymmetry(const HistogramBase& other1, const HistogramBase&
 ///If value is < 0.0 then content is set to 0.0.
 ///errors remain the same before and after randomisation.
 void HistogramBase::randomiseWithinErrors(int seed){
+  contentsChanged();
 
   TRandom3 random(seed);
 
@@ -587,6 +639,7 @@ double HistogramBase::integralError() const{
 ///Normalise sum of bin contents to specified area.
 ///Errors are also scaled.
 void HistogramBase::normalise(double area){
+  contentsChanged();
 
   double divisor  = integral()/area;
   double divisor2 = divisor*divisor;
@@ -601,6 +654,7 @@ void HistogramBase::normalise(double area){
 ///Set the content of a bin (leaves error unchanged)
 ///
 void HistogramBase::setBinContent(int bin, double val){
+  contentsChanged();
   bin = checkBinNumber(bin);
   _binContents[bin] = val;
 }
@@ -608,6 +662,7 @@ void HistogramBase::setBinContent(int bin, double val){
 ///Set the error of a bin
 ///
 void HistogramBase::setBinError  (int bin, double val){
+  contentsChanged();
   bin = checkBinNumber(bin);
   _sumW2[bin] = val*val;
 }
@@ -645,6 +700,7 @@ double HistogramBase::getFrequencyDensity(int bin) const{
 ///Replace all the bin contents with frequency density.
 ///
 void HistogramBase::makeFrequencyDensity(){
+  contentsChanged();
   
   for(int i = 0; i < _nBins; i++){
     double binVolume = this->getBinVolume(i);
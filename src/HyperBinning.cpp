@@ -1,11 +1,16 @@
 #include "HyperBinning.h"
 
+// std includes
+#include <cstring>
+#include <set>
+
 
 ///The only constructor
 HyperBinning::HyperBinning() :
 //  _changed(true),
   _averageBinWidth(getDimension()),
-  _minmax( HyperCuboid(HyperPoint(getDimension()), HyperPoint(getDimension())) )
+  _minmax( HyperCuboid(HyperPoint(getDimension()), HyperPoint(getDimension())) ),
+  _savedNumBins(-1)
 {
   setBinningType("HyperBinning");
   WELCOME_LOG << "Hello from the HyperBinning() Constructor";
@@ -69,36 +74,27 @@ int HyperBinning::getBinNum(const HyperPoint& coords) const{
   
   if ( nPrimVols == 0){
 
-    //loop over all the bins until one is found that contains the event. If a bin
+    //find the first bin that contains the event. If a bin
     // is found that contains the event, check if it has any linked bins. Linked bins
     // aren't real bins... just used to speed up sorting later.
 
-    int volumeNumber = -1;
-  
-    for (int i = 0; i < getNumHyperVolumes(); i++){
-      bool inVol = getHyperVolume(i).inVolume(coords);
-      if (inVol == 1) { volumeNumber = i; break; }
-    }
+    int volumeNumber = findTopLevelVolume(coords);
      
     if (volumeNumber == -1) return -1;
   
-    if ( getLinkedHyperVolumes(volumeNumber).size() > 0 ) volumeNumber = followBinLinks(coords, volumeNumber);
+    if ( getNumLinkedHyperVolumes(volumeNumber) > 0 ) volumeNumber = followBinLinks(coords, volumeNumber);
   
     return getBinNum(volumeNumber);
   }
 
 
-  int primaryVolumeNumber = -1;
+  int primaryVolumeNumber = findTopLevelVolume(coords);
 
-  for (int i = 0; i < nPrimVols; i++){
-    int thisVolNum = getPrimaryVolumeNumber(i);
-    bool inVol = getHyperVolume(thisVolNum).inVolume(coords);
-    if (inVol == 1) { primaryVolumeNumber = thisVolNum; break; }
-  }
+  if (primaryVolumeNumber == -1) return -1;
   
   int volumeNumber = -1;
 
-  if ( getLinkedHyperVolumes(primaryVolumeNumber).size() > 0 ) {
+  if ( getNumLinkedHyperVolumes(primaryVolumeNumber) > 0 ) {
     volumeNumber = followBinLinks(coords, primaryVolumeNumber);
   }
   else{
@@ -309,20 +305,35 @@ std::vector<int> HyperBinning::getBinNumAlt(const HyperPointSet& coords) const{
     INFO_LOG << "I'm looping over all " << nPrimVols << " primary volumes, and seeing what events fall into each" << std::endl;
   }
 
-  for (int voli = 0; voli < nPrimVols; voli++){
+  //If there are many primary volumes (e.g. after merging lots of
+  //binnings) use the index to go straight to the right one
+
+  if ( getVolumeIndex().size() != 0 ){
 
-    int volNum = getPrimaryVolumeNumber(voli);
-    HyperVolume vol = getHyperVolume(volNum);
-    
-    //See if any of the coords fall into this primary vol
     for (int i = 0; i < nCoords; i++){
-  
-      if ( vol.inVolume( coords.at(i) ) == true ){
-        binsInVol.at(volNum).push_back(i);
-      }
-  
-    }    
-  
+      int volNum = findTopLevelVolume( coords.at(i) );
+      if (volNum != -1) binsInVol.at(volNum).push_back(i);
+    }
+
+  }
+  else{
+
+    for (int voli = 0; voli < nPrimVols; voli++){
+
+      int volNum = getPrimaryVolumeNumber(voli);
+      HyperVolume vol = getHyperVolume(volNum);
+      
+      //See if any of the coords fall into this primary vol
+      for (int i = 0; i < nCoords; i++){
+    
+        if ( vol.inVolume( coords.at(i) ) == true ){
+          binsInVol.at(volNum).push_back(i);
+        }
+    
+      }    
+    
+    }
+
   }
 
   if (printInfo){
@@ -405,7 +416,7 @@ int HyperBinning::followBinLinks(const HyperPoint& coords, int motherVolumeNumbe
   //see if the coords falls into any of the linked volumes (it should if there are no bugs)
   for (unsigned i = 0; i < linkedVolumes.size(); i++){
     int daughBinNum = linkedVolumes.at(i);
-    bool inVol = getHyperVolume(daughBinNum).inVolume(coords);
+    bool inVol = isInHyperVolume(daughBinNum, coords);
     if (inVol == 1) { volumeNumber = daughBinNum; break; }
   }
   
@@ -416,7 +427,7 @@ int HyperBinning::followBinLinks(const HyperPoint& coords, int motherVolumeNumbe
   
   //now have volumeNumber which contains the next bin in the hierarchy.
   // if this is linked to more bins, keep following the trail!
-  if ( getLinkedHyperVolumes(volumeNumber).size() > 0 ) volumeNumber = followBinLinks(coords, volumeNumber);
+  if ( getNumLinkedHyperVolumes(volumeNumber) > 0 ) volumeNumber = followBinLinks(coords, volumeNumber);
   
   //if not, we have made it to the end. Return the volume number!
   return volumeNumber;
@@ -425,12 +436,29 @@ int HyperBinning::followBinLinks(const HyperPoint& coords, int motherVolumeNumbe
 
 
 
+///Get the number of HyperVolumes linked to a HyperVolume. Derived
+///classes can override this to avoid copying the links.
+int HyperBinning::getNumLinkedHyperVolumes( int volumeNumber ) const{
+  return getLinkedHyperVolumes(volumeNumber).size();
+}
+
+///Is a HyperPoint inside one of the HyperVolumes. Derived classes
+///can override this to avoid copying the HyperVolume.
+bool HyperBinning::isInHyperVolume(int volumeNumber, const HyperPoint& coords) const{
+  return getHyperVolume(volumeNumber).inVolume(coords);
+}
+
 ///Get number of bins (this is NOT the number of
 ///HyperVolumes!!! - see the class description for more details)
 int HyperBinning::getNumBins() const{
   
   if ( _hyperVolumeNumFromBinNum.isUpdateNeeded() == true ){
-    updateBinNumbering(); 
+    std::lock_guard<CacheMutex> lock(_cacheMutex);
+    if ( _hyperVolumeNumFromBinNum.isUpdateNeeded() == true ){
+      //the bin numbering can still be read one entry at a time
+      if (_cacheFilename != "" && _savedVolumeNumbers.isSet() && _savedNumBins >= 0) return _savedNumBins;
+      updateBinNumbering(); 
+    }
   }
   
   return _hyperVolumeNumFromBinNum.get().size();
@@ -448,10 +476,17 @@ HyperVolume HyperBinning::getBinHyperVolume(int binNumber) const{
 
 ///Get the bin number assosiated with a given HyperVolume number. 
 ///If this returns -1, it means that the HyperVolume in question
-///is not a bin, but part of the binning hierarchy.
+///is not a bin, but part of the binning hierarchy. If the bin
+///numbering was saved with the binning, it is read one entry at
+///a time until it has been used s_maxSavedBinReads times.
 int HyperBinning::getBinNum(int volumeNumber) const{
   if ( _binNum.isUpdateNeeded() == true ){
-    updateBinNumbering(); 
+    std::lock_guard<CacheMutex> lock(_cacheMutex);
+    if ( _binNum.isUpdateNeeded() == true ){
+      int binNumber = -1;
+      if (readSavedBinNumbering(_savedBinNumbers, volumeNumber, binNumber)) return binNumber;
+      updateBinNumbering(); 
+    }
   }  
   return _binNum.get().at(volumeNumber);
 }
@@ -460,165 +495,565 @@ int HyperBinning::getBinNum(int volumeNumber) const{
 ///
 int HyperBinning::getHyperVolumeNumber(int binNumber) const{
   if ( _hyperVolumeNumFromBinNum.isUpdateNeeded() == true ){
-    updateBinNumbering(); 
+    std::lock_guard<CacheMutex> lock(_cacheMutex);
+    if ( _hyperVolumeNumFromBinNum.isUpdateNeeded() == true ){
+      int volumeNumber = -1;
+      if (readSavedBinNumbering(_savedVolumeNumbers, binNumber, volumeNumber)) return volumeNumber;
+      updateBinNumbering(); 
+    }
   }
   return _hyperVolumeNumFromBinNum.get().at(binNumber);
 }
 
+///Make sure the whole bin numbering is in memory, rather than
+///being read from the saved cache one entry at a time. After this,
+///getBinNum and getHyperVolumeNumber don't need to lock anything.
+void HyperBinning::updateFullBinNumbering() const{
+  if ( _binNum.isUpdateNeeded() == true || _hyperVolumeNumFromBinNum.isUpdateNeeded() == true ){
+    std::lock_guard<CacheMutex> lock(_cacheMutex);
+    if ( _binNum.isUpdateNeeded() == true || _hyperVolumeNumFromBinNum.isUpdateNeeded() == true ) updateBinNumbering(); 
+  }
+}
+
 ///Update the cash which includes the  mutable member variables
 ///_binNum, _hyperVolumeNumFromBinNum, _averageBinWidth,
-/// and _minmax.
+/// and _minmax. This is called when the binning changes, which
+///must not happen while other threads are using it.
 void HyperBinning::updateCash() const{
   
+  std::lock_guard<CacheMutex> lock(_cacheMutex);
+
   _averageBinWidth         .changed();
   _minmax                  .changed();
   _binNum                  .changed();
   _hyperVolumeNumFromBinNum.changed();
+  _volumeIndex             .changed();
+  _adjacency               .changed();
+  _fingerprint             .changed();
+  _cacheFilename = "";
+  _savedBinNumbers    = TreeEntryReader();
+  _savedVolumeNumbers = TreeEntryReader();
 
 }
 
-///Update the member variables _binNum and _hyperVolumeNumFromBinNum.
+///Find the first primary volume that contains the HyperPoint (or if
+///there are no primary volumes, the first volume). Uses the index
+///if there are enough volumes to make it worthwhile.
+int HyperBinning::findTopLevelVolume(const HyperPoint& coords) const{
+
+  const HyperVolumeIndex& index = getVolumeIndex();
+
+  if (index.size() != 0) return index.findVolume(coords);
+
+  int nPrimVols = getNumPrimaryVolumes();
+
+  if (nPrimVols == 0){
+    for (int i = 0; i < getNumHyperVolumes(); i++){
+      if ( isInHyperVolume(i, coords) ) return i;
+    }
+    return -1;
+  }
+
+  for (int i = 0; i < nPrimVols; i++){
+    int thisVolNum = getPrimaryVolumeNumber(i);
+    if ( isInHyperVolume(thisVolNum, coords) ) return thisVolNum;
+  }
+  return -1;
+
+}
+
+///Get the index over the primary volumes, building it if
+///the binning has changed since it was last built
+const HyperVolumeIndex& HyperBinning::getVolumeIndex() const{
+  if ( _volumeIndex.isUpdateNeeded() == true ){
+    std::lock_guard<CacheMutex> lock(_cacheMutex);
+    if ( _volumeIndex.isUpdateNeeded() == true ) updateVolumeIndex();
+  }
+  return _volumeIndex.get();
+}
+
+///Get the face adjacency graph of the bins, building it if
+///the binning has changed since it was last built
+const HyperBinningAdjacency& HyperBinning::getAdjacency() const{
+  if ( _adjacency.isUpdateNeeded() == true ){
+    std::lock_guard<CacheMutex> lock(_cacheMutex);
+    if ( _adjacency.isUpdateNeeded() == true ){
+      _adjacency.get().build(*this);
+      _adjacency.updated();
+    }
+  }
+  return _adjacency.get();
+}
+
+///A hash of the dimension, every HyperVolume (the exact corners of
+///each HyperCuboid) and the links between them. Two binnings with the
+///same fingerprint are, to a very good approximation, identical, so
+///histograms that use them can be merged by adding their contents.
+///It's saved with the binning, so is only found once.
+ULong64_t HyperBinning::getFingerprint() const{
+  if ( _fingerprint.isUpdateNeeded() == true ){
+    std::lock_guard<CacheMutex> lock(_cacheMutex);
+    if ( _fingerprint.isUpdateNeeded() == true ) updateFingerprint();
+  }
+  return _fingerprint.get();
+}
+
+///Find the fingerprint by looping over every HyperVolume. The
+///doubles are hashed bit for bit (after turning -0.0 into 0.0).
+///Will usually be called from getFingerprint()
+void HyperBinning::updateFingerprint() const{
+
+  ULong64_t hash = 14695981039346656037ULL;
+
+  auto combine = [&hash](ULong64_t word){
+    hash ^= word + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    hash *= 1099511628211ULL;
+  };
+
+  auto combineDouble = [&combine](double val){
+    val += 0.0;
+    ULong64_t word = 0;
+    std::memcpy(&word, &val, sizeof(double));
+    combine(word);
+  };
+
+  int dim      = getDimension();
+  int nVolumes = getNumHyperVolumes();
+
+  combine(dim);
+  combine(nVolumes);
+
+  for (int vol = 0; vol < nVolumes; vol++){
+
+    HyperVolume volume = getHyperVolume(vol);
+    combine(volume.size());
+
+    for (int i = 0; i < volume.size(); i++){
+      const HyperCuboid& cuboid = volume.at(i);
+      for (int d = 0; d < dim; d++){
+        combineDouble(cuboid.getLowCorner ().at(d));
+        combineDouble(cuboid.getHighCorner().at(d));
+      }
+    }
+
+    std::vector<int> linked = getLinkedHyperVolumes(vol);
+    combine(linked.size());
+    for (unsigned i = 0; i < linked.size(); i++) combine(linked.at(i));
+  }
+
+  //zero is kept for binnings without a fingerprint
+  if (hash == 0) hash = 1;
+
+  _fingerprint = hash;
+  _fingerprint.updated();
+
+}
+
+///Read the fingerprint saved with the binning in a file, without
+///loading the binning. Returns zero if there isn't one.
+ULong64_t HyperBinning::readFingerprint(TString filename){
+
+  TFile* file = new TFile(filename, "READ");
+
+  if (file == 0 || file->IsZombie()){
+    return 0;
+  }
+
+  TTree* tree = dynamic_cast<TTree*>( file->Get("HyperBinningCache") );
+
+  ULong64_t fingerprint = 0;
+
+  if (tree != 0 && tree->GetEntries() == 1 && tree->GetBranch("fingerprint") != 0){
+    tree->SetBranchAddress("fingerprint", &fingerprint);
+    tree->GetEntry(0);
+  }
+
+  file->Close();
+
+  return fingerprint;
+
+}
+
+///Build the index over the primary volumes (or every volume if there
+///are no primary volumes). If there are only a few, the index is 
+///left empty and they are just looped over.
 ///Will usually be called from updateCash()
+void HyperBinning::updateVolumeIndex() const{
+
+  HyperVolumeIndex& index = _volumeIndex.get();
+  index.clear( getDimension() );
+
+  int nPrimVols = getNumPrimaryVolumes();
+  int nToIndex  = nPrimVols == 0 ? getNumHyperVolumes() : nPrimVols;
+
+  if (nToIndex >= s_minVolumesToIndex){
+
+    for (int i = 0; i < nToIndex; i++){
+      int volNum = nPrimVols == 0 ? i : getPrimaryVolumeNumber(i);
+      index.addVolume( volNum, getHyperVolume(volNum) );
+    }
+
+    index.build();
+
+  }
+
+  _volumeIndex.updated();
+
+}
+
+///Update the member variables _binNum and _hyperVolumeNumFromBinNum.
+///If they were saved with the binning they are read from the file, 
+///otherwise all of the caches are found with updateDerivedCaches().
+///_cacheMutex must be locked.
 void HyperBinning::updateBinNumbering() const{
+
+  if (_cacheFilename != "" && loadBinNumbering() == true) return;
+
+  updateDerivedCaches();
+
+}
+
+///Update _binNum, _hyperVolumeNumFromBinNum, _averageBinWidth and
+///_minmax in a single loop over the HyperVolumes, so that each is 
+///only fetched once (which matters a lot for disk resident binnings).
+///Caches that are already up to date aren't overwritten, since other
+///threads may be reading them. _cacheMutex must be locked.
+void HyperBinning::updateDerivedCaches() const{
   
-  //first fill all the bin numbers with -1
-  int nVolumes = getNumHyperVolumes();
-  _binNum = std::vector<int>(nVolumes, -1);
-  
-  bool printout = getNumHyperVolumes() > 2e6 && isDiskResident() == true;
+  int nVolumes  = getNumHyperVolumes();
+  int nPrimVols = getNumPrimaryVolumes();
+  int dim       = getDimension();
+
+  bool printout = nVolumes > 2e6 && isDiskResident() == true;
   if (printout) {
     INFO_LOG << "Since this is a large (>2x10^6) disk resident HyperBinning, I'm going to give you information on this cache update." << std::endl;    
-    INFO_LOG << "I'm currently updating the bin numbering that lets me quickly associate volumes to bins and vice versa..." << std::endl;
+    INFO_LOG << "I'm currently looping over all volumes to find the bin numbering, limits and average bin width..." << std::endl;
   }
 
+  //if there are primary volumes, only these are used for the limits
+  std::vector<bool> isPrimary(nPrimVols == 0 ? 0 : nVolumes, false);
+  for (int i = 0; i < nPrimVols; i++){
+    isPrimary.at( getPrimaryVolumeNumber(i) ) = true;
+  }
 
-  //if a HyperVolume has any linked HyperVolumes,
-  //then set its bin number to count.
-  int count = 0;
-  for (int i = 0; i < getNumHyperVolumes(); i++){
-    if ( getLinkedHyperVolumes(i).size() == 0 ) {
-      _binNum.get().at(i) = count;
-      count++;
+  bool newBinNumbering = _binNum.isUpdateNeeded() || _hyperVolumeNumFromBinNum.isUpdateNeeded();
+
+  std::vector<int>  binNum;
+  std::vector<int>  volNum;
+  binNum.assign(nVolumes, -1);
+
+  HyperPoint min     (dim);
+  HyperPoint max     (dim);
+  HyperPoint widthSum(dim);
+  bool foundLimits = false;
+
+  for (int i = 0; i < nVolumes; i++){
+
+    //if a HyperVolume has no linked HyperVolumes, it's a bin
+    bool isBin    = getNumLinkedHyperVolumes(i) == 0;
+    bool inLimits = nPrimVols == 0 || isPrimary.at(i);
+
+    if (isBin){
+      binNum.at(i) = volNum.size();
+      volNum.push_back(i);
     }
-  }  
 
-  //now we know how many bins there are, make the 
-  // _hyperVolumeNumFromBinNum vector
-  int nBins = count;
-  _hyperVolumeNumFromBinNum = std::vector<int>(nBins,-1);
+    if (isBin == false && inLimits == false) continue;
 
-  //fill the vector
-  for (int i = 0; i < getNumHyperVolumes(); i++){
-    if ( _binNum.get().at(i) != -1 ) {
-      _hyperVolumeNumFromBinNum.get().at( _binNum.get().at(i) ) = i;
+    HyperVolume volume = getHyperVolume(i);
+
+    for (int d = 0; d < dim; d++){
+      double low  = volume.getMin(d);
+      double high = volume.getMax(d);
+      
+      if (isBin) widthSum.at(d) += high - low;
+
+      if (inLimits){
+        if (foundLimits == false || min.at(d) > low ) min.at(d) = low;
+        if (foundLimits == false || max.at(d) < high) max.at(d) = high;
+      }
     }
-  }    
 
-  _hyperVolumeNumFromBinNum.updated();
-  _binNum                  .updated();
+    if (inLimits) foundLimits = true;
+  }
+
+  if (_minmax.isUpdateNeeded() == true){
+    if (foundLimits) _minmax = HyperCuboid(min, max);
+    else             _minmax = HyperCuboid(dim, 0.0, 1.0);
+    _minmax.updated();
+  }
+
+  if (_averageBinWidth.isUpdateNeeded() == true){
+    if (volNum.size() != 0) _averageBinWidth = widthSum/(double)volNum.size();
+    else                    _averageBinWidth = HyperPoint(dim, 1.0);
+    _averageBinWidth.updated();
+  }
+
+  if (newBinNumbering == true){
+    _binNum                  .get().swap(binNum);
+    _hyperVolumeNumFromBinNum.get().swap(volNum);
+    _hyperVolumeNumFromBinNum.updated();
+    _binNum                  .updated();
+  }
 
   if (printout) {
     INFO_LOG << "Finished!" << std::endl;    
   }
 
-
 }
 
-///return the limits of the binning.
-///This value is cashed for speed - when the binning changes the cashe will
-///automatically be updated.
-HyperCuboid HyperBinning::getLimits() const{
-  if (_minmax.isUpdateNeeded() == true) {
-    updateMinMax();  
-  } 
-  return _minmax;
+///Are the bin numbering, limits and average bin width all
+///up to date?
+bool HyperBinning::isCacheUpToDate() const{
+  return _binNum                  .isUpdateNeeded() == false &&
+         _hyperVolumeNumFromBinNum.isUpdateNeeded() == false &&
+         _minmax                  .isUpdateNeeded() == false &&
+         _averageBinWidth         .isUpdateNeeded() == false;
 }
 
+///Save the limits, average bin width and bin numbering to the 
+///open (and in scope) TFile, so they don't need to be found again 
+///when the binning is loaded. The TTree "HyperBinningCache" has a
+///single entry, "HyperBinningBinNumbers" gives the HyperVolume
+///number of each bin and "HyperBinningVolumeBins" the bin number of
+///each HyperVolume (unless saveBinNumbering is false). If the 
+///adjacency graph has been built, it is saved in "HyperBinningAdjacency".
+void HyperBinning::saveCache(bool writeTrees, bool saveBinNumbering) const{
 
+  int dim = getDimension();
 
-///update the _averageBinWidth HyperPoint. 
-///Will usually be called from updateCash()
-void HyperBinning::updateAverageBinWidth() const{
+  HyperCuboid limits = getLimits();
+  HyperPoint  width  = getAverageBinWidth();
+
+  TTree* tree = new TTree("HyperBinningCache", "HyperBinningCache");
+
+  if (tree == 0){
+    ERROR_LOG << "Could not open TTree in HyperBinning::saveCache()";
+    return;
+  }
+
+  int nVolumes = getNumHyperVolumes();
+  int nBins    = getNumBins();
+
+  ULong64_t fingerprint = getFingerprint();
+
+  tree->Branch("nVolumes"   , &nVolumes   );
+  tree->Branch("nBins"      , &nBins      );
+  tree->Branch("fingerprint", &fingerprint);
+
+  for (int i = 0; i < dim; i++) {
+    TString lowLimitName  = "lowLimit_" ; lowLimitName  += i;
+    TString highLimitName = "highLimit_"; highLimitName += i;
+    TString widthName     = "averageBinWidth_"; widthName += i;
+    tree->Branch(lowLimitName , &limits.getLowCorner ().at(i));
+    tree->Branch(highLimitName, &limits.getHighCorner().at(i));
+    tree->Branch(widthName    , &width.at(i));
+  }
+
+  tree->Fill();
+
+  TTree* binTree    = 0;
+  TTree* volumeTree = 0;
   
-  if (getNumHyperVolumes() > 2e6 && isDiskResident() == true) {
-    INFO_LOG << "Since this is a large (>2x10^6) disk resident HyperBinning, I'm going to give you information on this cache update." << std::endl;    
-    INFO_LOG << "I'm currently updating the average bin width by looping over all bin volumes" << std::endl;
+  if (saveBinNumbering){
+    binTree    = new TTree("HyperBinningBinNumbers", "HyperBinningBinNumbers");
+    volumeTree = new TTree("HyperBinningVolumeBins", "HyperBinningVolumeBins");
+
+    if (binTree == 0 || volumeTree == 0){
+      ERROR_LOG << "Could not open TTree in HyperBinning::saveCache()";
+      return;
+    }
+
+    int volumeNumber = -1;
+    int binNumber    = -1;
+    binTree   ->Branch("volumeNumber", &volumeNumber);
+    volumeTree->Branch("binNumber"   , &binNumber   );
+
+    updateFullBinNumbering();
+
+    const std::vector<int>& volNum = _hyperVolumeNumFromBinNum.get();
+    for (int bin = 0; bin < nBins; bin++){
+      volumeNumber = volNum.at(bin);
+      binTree->Fill();
+    }
+
+    const std::vector<int>& binNum = _binNum.get();
+    for (int vol = 0; vol < nVolumes; vol++){
+      binNumber = binNum.at(vol);
+      volumeTree->Fill();
+    }
+  }
+
+  //the adjacency graph is only saved if it's already been found
+  TTree* adjacencyTree = 0;
+  if (_adjacency.isUpdateNeeded() == false) adjacencyTree = _adjacency.get().save();
+
+  if (writeTrees){
+    tree->Write();
+    if (binTree    != 0) binTree   ->Write();
+    if (volumeTree != 0) volumeTree->Write();
+    if (adjacencyTree != 0) adjacencyTree->Write();
+  }
+
+}
+
+///Load the limits and average bin width saved by saveCache, if
+///they exist and match this binning. The bin numbering is only
+///read when it is first needed.
+void HyperBinning::loadCache(TString filename){
+
+  TFile* file = new TFile(filename, "READ");
+
+  if (file == 0 || file->IsZombie()){
+    return;
+  }
+
+  TTree* tree = dynamic_cast<TTree*>( file->Get("HyperBinningCache") );
+
+  if (tree == 0 || tree->GetEntries() != 1){
+    file->Close();
+    return;
   }
 
   int dim = getDimension();
 
-  HyperPoint averageWidth(dim);
+  int nVolumes = -1;
+  int nBins    = -1;
+  ULong64_t fingerprint = 0;
+  HyperPoint low  (dim);
+  HyperPoint high (dim);
+  HyperPoint width(dim);
+
+  tree->SetBranchAddress("nVolumes", &nVolumes);
+  tree->SetBranchAddress("nBins"   , &nBins   );
+
+  //files saved before the fingerprint was added don't have it
+  if (tree->GetBranch("fingerprint") != 0) tree->SetBranchAddress("fingerprint", &fingerprint);
+
+  for (int i = 0; i < dim; i++) {
+    TString lowLimitName  = "lowLimit_" ; lowLimitName  += i;
+    TString highLimitName = "highLimit_"; highLimitName += i;
+    TString widthName     = "averageBinWidth_"; widthName += i;
+    tree->SetBranchAddress(lowLimitName , &low  .at(i));
+    tree->SetBranchAddress(highLimitName, &high .at(i));
+    tree->SetBranchAddress(widthName    , &width.at(i));
+  }
+
+  tree->GetEntry(0);
 
-  for (int i = 0; i < getNumBins(); i++){
-    for (int j = 0; j < dim; j++) {
-      double min = getBinHyperVolume(i).getMin(j);
-      double max = getBinHyperVolume(i).getMax(j);
-      averageWidth.at(j) += (max - min);
-    }  
-  }    
+  bool hasAdjacency  = file->Get("HyperBinningAdjacency" ) != 0;
+  bool hasBinNumbers = file->Get("HyperBinningBinNumbers") != 0;
+  bool hasVolumeBins = file->Get("HyperBinningVolumeBins") != 0;
 
-  _averageBinWidth = averageWidth/(double)getNumBins();
+  file->Close();
+
+  if (nVolumes != getNumHyperVolumes()){
+    INFO_LOG << "HyperBinning::loadCache - the saved cache doesn't match this binning, so ignoring it" << std::endl;
+    return;
+  }
+
+  _minmax          = HyperCuboid(low, high);
+  _averageBinWidth = width;
+  _minmax         .updated();
   _averageBinWidth.updated();
 
+  if (fingerprint != 0){
+    _fingerprint = fingerprint;
+    _fingerprint.updated();
+  }
+
+  if (hasBinNumbers) _cacheFilename = filename;
+
+  //files saved before "HyperBinningVolumeBins" was added can
+  //only have their bin numbering read all at once
+  if (hasBinNumbers && hasVolumeBins){
+    _savedBinNumbers    = TreeEntryReader(filename, "HyperBinningVolumeBins", "binNumber"   );
+    _savedVolumeNumbers = TreeEntryReader(filename, "HyperBinningBinNumbers", "volumeNumber");
+    _savedNumBins       = nBins;
+  }
+
+  if (hasAdjacency && _adjacency.get().load(filename, nBins, dim)){
+    _adjacency.updated();
+  }
+
 }
 
+///Read one entry of the bin numbering saved by saveCache. Returns
+///false if it can't be read, or if so many entries have been read
+///that it's time to read them all with loadBinNumbering. 
+///_cacheMutex must be locked.
+bool HyperBinning::readSavedBinNumbering(TreeEntryReader& reader, int entry, int& value) const{
 
-///Update the miniumum and maximum values, _minmax, 
-///in the cashe. Will usually be called from updateCash().
-void HyperBinning::updateMinMax() const{
-  
-  int dim = getDimension(); 
+  if (_cacheFilename == "" || reader.isSet() == false) return false;
+  if (reader.getNumReads() >= s_maxSavedBinReads) return false;
 
-  HyperPoint min(dim);
-  HyperPoint max(dim);
-  
-  for (int d = 0; d < dim; d++){
-    min.at(d) = getHyperVolume(0).getMin(d);
-    max.at(d) = getHyperVolume(0).getMax(d);
+  return reader.read(entry, value);
+
+}
+
+///Read the whole bin numbering saved by saveCache. Returns false 
+///if it can't be read (in which case it needs to be recalculated).
+bool HyperBinning::loadBinNumbering() const{
+
+  BulkTreeReader reader(_cacheFilename, "HyperBinningBinNumbers");
+
+  _cacheFilename = "";
+  _savedBinNumbers   .close();
+  _savedVolumeNumbers.close();
+
+  if (reader.isOpen() == false) return false;
+
+  int nVolumes = getNumHyperVolumes();
+  int nBins    = reader.getNumEntries();
+
+  std::vector<int>& binNum = _binNum                  .get();
+  std::vector<int>& volNum = _hyperVolumeNumFromBinNum.get();
+
+  volNum.assign(nBins, -1);
+
+  if (nBins > 0){
+    reader.addColumn("volumeNumber", &volNum.at(0));
+    if (reader.read() == false) return false;
   }
-  
-  int nPrimVols = getNumPrimaryVolumes();
-  
-  if (nPrimVols == 0){
 
-    if (getNumHyperVolumes() > 2e6 && isDiskResident() == true) {
-      INFO_LOG << "Since this is a large (>2x10^6) disk resident HyperBinning, I'm going to give you information on this cache update." << std::endl;    
-      INFO_LOG << "I'm currently determining the limits of this histogram by looping over all bin volumes" << std::endl;
-    }
+  binNum.assign(nVolumes, -1);
 
-    for(int i = 1; i < getNumHyperVolumes(); i++){
-      HyperVolume thisVol = getHyperVolume(i);
-      for (int d = 0; d < dim; d++){
-        if (min.at(d) > thisVol.getMin(d)) min.at(d) = thisVol.getMin(d);
-        if (max.at(d) < thisVol.getMax(d)) max.at(d) = thisVol.getMax(d);
-      }
+  for (int bin = 0; bin < nBins; bin++){
+    int vol = volNum.at(bin);
+    if (vol < 0 || vol >= nVolumes){
+      ERROR_LOG << "HyperBinning::loadBinNumbering - volume number " << vol << " is out of range" << std::endl;
+      return false;
     }
-
+    binNum.at(vol) = bin;
   }
 
-  else{
+  _hyperVolumeNumFromBinNum.updated();
+  _binNum                  .updated();
 
-    for(int i = 1; i < getNumPrimaryVolumes(); i++){
-      HyperVolume thisVol = getHyperVolume( getPrimaryVolumeNumber(i) );
-      for (int d = 0; d < dim; d++){
-        if (min.at(d) > thisVol.getMin(d)) min.at(d) = thisVol.getMin(d);
-        if (max.at(d) < thisVol.getMax(d)) max.at(d) = thisVol.getMax(d);
-      }
-    }    
+  return true;
 
-  }
+}
 
-  _minmax = HyperCuboid(min, max);
-  _minmax.updated();
+///return the limits of the binning.
+///This value is cashed for speed - when the binning changes the cashe will
+///automatically be updated.
+HyperCuboid HyperBinning::getLimits() const{
+  if (_minmax.isUpdateNeeded() == true) {
+    std::lock_guard<CacheMutex> lock(_cacheMutex);
+    if (_minmax.isUpdateNeeded() == true) updateDerivedCaches();  
+  } 
+  return _minmax;
 }
 
 
+
 ///get the average bin width HyperPoint (average bin width in each dimension).
 ///This value is cashed for speed - when the binning changes the cashe will
 ///automatically be updated.
 HyperPoint HyperBinning::getAverageBinWidth() const{
   if (_averageBinWidth.isUpdateNeeded() == true) {
-    updateAverageBinWidth();  
+    std::lock_guard<CacheMutex> lock(_cacheMutex);
+    if (_averageBinWidth.isUpdateNeeded() == true) updateDerivedCaches();  
   } 
   return _averageBinWidth;  
 
@@ -824,9 +1259,251 @@ void HyperBinning::save() const{
   delete highCorner;
   delete linkedBins;
 
+  saveCache();
+
 }
 
+///Is the HyperVolume a single HyperCuboid that has been split in
+///two (along one dimension) to give its two linked HyperVolumes - 
+///the first below the split and the second above it? This is how 
+///the HyperBinningMaker builds the bin hierarchy. If so, return the 
+///split dimension and set splitValue, otherwise return -1.
+int HyperBinning::getSplitDimension(int volumeNumber, double& splitValue) const{
+
+  std::vector<int> linkedVolumes = getLinkedHyperVolumes(volumeNumber);
 
+  if (linkedVolumes.size() != 2) return -1;
+
+  HyperVolume parent = getHyperVolume(volumeNumber);
+  HyperVolume below  = getHyperVolume(linkedVolumes.at(0));
+  HyperVolume above  = getHyperVolume(linkedVolumes.at(1));
+
+  if (parent.size() != 1 || below.size() != 1 || above.size() != 1) return -1;
+
+  const HyperPoint& parentLow  = parent.at(0).getLowCorner ();
+  const HyperPoint& parentHigh = parent.at(0).getHighCorner();
+  const HyperPoint& belowLow   = below .at(0).getLowCorner ();
+  const HyperPoint& belowHigh  = below .at(0).getHighCorner();
+  const HyperPoint& aboveLow   = above .at(0).getLowCorner ();
+  const HyperPoint& aboveHigh  = above .at(0).getHighCorner();
+
+  int splitDim = -1;
+
+  for (int i = 0; i < getDimension(); i++){
+
+    //the outer edges must always match the parent
+    if (belowLow.at(i) != parentLow.at(i) || aboveHigh.at(i) != parentHigh.at(i)) return -1;
+    
+    //dimensions that weren't split
+    if (belowHigh.at(i) == parentHigh.at(i) && aboveLow.at(i) == parentLow.at(i)) continue;
+
+    //only one dimension can be split, and the two halves must meet
+    if (splitDim != -1 || belowHigh.at(i) != aboveLow.at(i)) return -1;
+
+    splitDim   = i;
+    splitValue = belowHigh.at(i);
+  }
+
+  return splitDim;
+
+}
+
+///Save the HyperBinning to a TFile in the compact format (see
+///saveCompact()). 
+void HyperBinning::saveCompact(TString filename) const{
+
+  TFile* file = new TFile(filename, "RECREATE");
+
+  if (file == 0){
+    ERROR_LOG << "Could not open TFile in HyperBinning::saveCompact(" << filename << ")";
+    return;
+  }
+
+  saveCompact();
+
+  file->Close();
+
+}
+
+///Save the HyperBinning to the open (and in scope) TFile in a
+///compact format. Rather than saving the corners of every 
+///HyperVolume, only the splits are saved: the TTree 
+///"HyperBinningCompact" has one entry for every HyperVolume that
+///was split in two, in order of volume number, giving the split
+///dimension (as a char) and the split value. The two HyperVolumes
+///made by the k-th split aren't saved at all - they are the 
+///(2k)-th and (2k+1)-th of the HyperVolumes that are not in 
+///"HyperBinningExplicit", so they must be consecutive, and the 
+///splits must create them in order (as HyperBinningMaker does).
+///The TTree "HyperBinningSplitFlags" marks which HyperVolumes were
+///split, using one bit per HyperVolume.
+///
+///Any HyperVolumes that can't be found this way (the primary 
+///volumes, volumes with several HyperCuboids, or volumes linked 
+///in some other way, as happens when binnings are merged) are 
+///saved in full to the TTree "HyperBinningExplicit", which has 
+///the same layout as the usual "HyperBinning" TTree. The bin 
+///numbering isn't saved, since it's quick to find again.
+///
+///These files can only be loaded by HyperBinningMemRes.
+void HyperBinning::saveCompact() const{
+
+  savePrimaryVolumeNumbers();
+
+  int nVolumes = getNumHyperVolumes();
+
+  //Find which volumes are simple splits whose two halves are
+  //consecutive, and can be stored with a char split dimension
+
+  std::vector<int>    splitDims  (nVolumes, -1 );
+  std::vector<double> splitValues(nVolumes, 0.0);
+  std::vector<int>    lowChildren(nVolumes, -1 );
+  std::vector<bool>   hasLinks   (nVolumes, false);
+
+  for (int vol = 0; vol < nVolumes; vol++){
+    hasLinks.at(vol) = getNumLinkedHyperVolumes(vol) > 0;
+
+    int splitDim = getSplitDimension(vol, splitValues.at(vol));
+    if (splitDim == -1 || splitDim > 127) continue;
+
+    std::vector<int> linkedVolumes = getLinkedHyperVolumes(vol);
+    if (linkedVolumes.at(1) != linkedVolumes.at(0) + 1) continue;
+
+    splitDims  .at(vol) = splitDim;
+    lowChildren.at(vol) = linkedVolumes.at(0);
+  }
+
+  //Choose the splits to store. The k-th stored split must create
+  //the (2k)-th and (2k+1)-th derived volumes, and a derived volume
+  //can't have any links other than its own stored split. Volumes 
+  //that break this are saved explicitly, which can stop their 
+  //parent being stored as a split, so repeat until nothing changes.
+
+  std::vector<bool> mustBeExplicit(nVolumes, false);
+  std::vector<bool> stored        (nVolumes, false);
+  std::vector<bool> derived       (nVolumes, false);
+
+  for (int vol = 0; vol < nVolumes; vol++){
+    mustBeExplicit.at(vol) = splitDims.at(vol) == -1 && hasLinks.at(vol);
+  }
+
+  bool changed = true;
+
+  while (changed){
+
+    std::set<int> unclaimed;
+
+    for (int vol = 0; vol < nVolumes; vol++){
+      stored .at(vol) = false;
+      derived.at(vol) = false;
+      
+      int low = lowChildren.at(vol);
+      if (splitDims.at(vol) == -1 || mustBeExplicit.at(low) || mustBeExplicit.at(low + 1)) continue;
+
+      stored.at(vol) = true;
+      unclaimed.insert(low);
+      unclaimed.insert(low + 1);
+    }
+
+    for (int vol = 0; vol < nVolumes; vol++){
+      if (stored.at(vol) == false) continue;
+      
+      int low = lowChildren.at(vol);
+
+      if (unclaimed.size() != 0 && *unclaimed.begin() == low && unclaimed.count(low + 1) != 0){
+        derived.at(low    ) = true;
+        derived.at(low + 1) = true;
+      }
+      else{
+        stored.at(vol) = false;
+      }
+
+      unclaimed.erase(low    );
+      unclaimed.erase(low + 1);
+    }
+
+    changed = false;
+
+    for (int vol = 0; vol < nVolumes; vol++){
+      if (derived.at(vol) && stored.at(vol) == false && hasLinks.at(vol)){
+        mustBeExplicit.at(vol) = true;
+        changed = true;
+      }
+    }
+  }
+
+  //Save the stored splits, and mark which volumes they belong to
+
+  TTree* compactTree = new TTree("HyperBinningCompact", "HyperBinningCompact");
+  TTree* flagTree    = new TTree("HyperBinningSplitFlags", "HyperBinningSplitFlags");
+
+  if (compactTree == 0 || flagTree == 0){
+    ERROR_LOG << "Could not open TTree in HyperBinning::saveCompact()";
+    return;
+  }
+
+  Char_t splitDim   = -1;
+  double splitValue = 0.0;
+  Char_t splitFlags = 0;
+
+  compactTree->Branch("splitDim"  , &splitDim  , "splitDim/B"  );
+  compactTree->Branch("splitValue", &splitValue, "splitValue/D");
+  flagTree   ->Branch("splitFlags", &splitFlags, "splitFlags/B");
+
+  int nSplits = 0;
+
+  for (int vol = 0; vol < nVolumes; vol++){
+    
+    if (stored.at(vol)){
+      splitDim   = splitDims  .at(vol);
+      splitValue = splitValues.at(vol);
+      compactTree->Fill();
+      splitFlags |= Char_t(1 << (vol % 8));
+      nSplits++;
+    }
+
+    if (vol % 8 == 7 || vol == nVolumes - 1){
+      flagTree->Fill();
+      splitFlags = 0;
+    }
+  }
+
+  //Save everything that can't be found from the splits
+
+  TTree* explicitTree = new TTree("HyperBinningExplicit", "HyperBinningExplicit");
+  
+  if (explicitTree == 0){
+    ERROR_LOG << "Could not open TTree in HyperBinning::saveCompact()";
+    return;
+  }
+
+  int binNumber = -1;
+  double* lowCorner  = new double [getDimension()];
+  double* highCorner = new double [getDimension()];
+  std::vector<int>* linkedBins = new std::vector<int>();
+
+  createBranches(explicitTree, &binNumber, lowCorner, highCorner, &linkedBins);
+
+  for (int vol = 0; vol < nVolumes; vol++){
+    
+    if (derived.at(vol)) continue;
+
+    binNumber = vol;
+    linkedBins->clear();
+    if (stored.at(vol) == false) *linkedBins = getLinkedHyperVolumes(vol);
+    saveHyperVolumeToTree(explicitTree, lowCorner, highCorner, getHyperVolume(vol));
+  }
+
+  INFO_LOG << "HyperBinning::saveCompact - " << 2*nSplits << " of " << nVolumes;
+  INFO_LOG << " HyperVolumes are stored as splits" << std::endl;
+    
+  delete[] lowCorner;
+  delete[] highCorner;
+  delete linkedBins;
+
+  saveCache(false, false);
+
+}
 
 std::vector<int> HyperBinning::getPrimaryVolumeNumbers() const{
   std::vector<int> primaryVolumeNumbers;
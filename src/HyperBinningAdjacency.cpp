@@ -0,0 +1,434 @@
+#include "HyperBinningAdjacency.h"
+
+// std includes
+#include <algorithm>
+
+double HyperBinningAdjacency::s_tolerance = 1e-10;
+
+
+///Constructor for an empty graph
+///
+HyperBinningAdjacency::HyperBinningAdjacency() :
+  _dimension(0),
+  _numBins(0),
+  _offsets(1, 0)
+{
+
+}
+
+///Remove every bin from the graph
+///
+void HyperBinningAdjacency::clear(){
+  _dimension = 0;
+  _numBins   = 0;
+  _offsets   .assign(1, 0);
+  _neighbours.clear();
+  _faceDims  .clear();
+  _faceSides .clear();
+  _tolerances.clear();
+}
+
+///Find which bins share a face. For each dimension, the high and
+///low faces of every HyperCuboid are sorted by position, and those
+///on the same plane are matched up by matchFaces.
+void HyperBinningAdjacency::build(const BinningBase& binning){
+
+  clear();
+
+  int dim   = binning.getDimension();
+  int nBins = binning.getNumBins();
+
+  _dimension = dim;
+  _numBins   = nBins;
+
+  //copy the corners of every HyperCuboid into flat arrays
+
+  std::vector<double> low;
+  std::vector<double> high;
+  std::vector<int>    binOfCuboid;
+
+  for (int bin = 0; bin < nBins; bin++){
+    HyperVolume volume = binning.getBinHyperVolume(bin);
+    for (int i = 0; i < volume.size(); i++){
+      const HyperCuboid& cuboid = volume.at(i);
+      for (int d = 0; d < dim; d++){
+        low .push_back(cuboid.getLowCorner ().at(d));
+        high.push_back(cuboid.getHighCorner().at(d));
+      }
+      binOfCuboid.push_back(bin);
+    }
+  }
+
+  int nCuboids = binOfCuboid.size();
+
+  //the tolerance in each dimension is relative to the size of the binning
+
+  _tolerances.assign(dim, 0.0);
+  for (int d = 0; d < dim && nCuboids != 0; d++){
+    double min = low [d];
+    double max = high[d];
+    for (int c = 1; c < nCuboids; c++){
+      min = std::min(min, low [c*dim + d]);
+      max = std::max(max, high[c*dim + d]);
+    }
+    _tolerances.at(d) = s_tolerance*(max - min);
+  }
+
+  //each edge is stored as (neighbour, dimension, side)
+
+  std::vector< std::vector<int> > edges(nBins);
+
+  std::vector<Face> highFaces(nCuboids);
+  std::vector<Face> lowFaces (nCuboids);
+
+  for (int d = 0; d < dim; d++){
+
+    for (int c = 0; c < nCuboids; c++){
+      highFaces.at(c).position = high[c*dim + d];
+      highFaces.at(c).cuboid   = c;
+      lowFaces .at(c).position = low [c*dim + d];
+      lowFaces .at(c).cuboid   = c;
+    }
+
+    std::sort(highFaces.begin(), highFaces.end(), FaceLess());
+    std::sort(lowFaces .begin(), lowFaces .end(), FaceLess());
+
+    matchFaces(d, highFaces, lowFaces, low, high, binOfCuboid, edges);
+
+  }
+
+  setEdges(edges);
+
+  //the hierarchy over the faces is only needed while building
+  std::vector<int>   ().swap(_faceOrder);
+  std::vector<double>().swap(_nodeLow  );
+  std::vector<double>().swap(_nodeHigh );
+  std::vector<int>   ().swap(_nodeFirst);
+  std::vector<int>   ().swap(_nodeCount);
+  std::vector<int>   ().swap(_nodeLeft );
+  std::vector<int>   ().swap(_nodeRight);
+
+  VERBOSE_LOG << "HyperBinningAdjacency::build - found " << getNumEdges()/2 << " pairs of neighbouring bins" << std::endl;
+
+}
+
+///Find the HyperCuboids whose high face (in dimension dim) touches
+///the low face of another. The faces are already sorted by position,
+///so groups on the same plane are found in one pass. The low faces
+///in each group are put in a bounding volume hierarchy, which each
+///high face searches for the low faces it overlaps.
+void HyperBinningAdjacency::matchFaces(int dim, const std::vector<Face>& highFaces, const std::vector<Face>& lowFaces,
+                                       const std::vector<double>& low, const std::vector<double>& high, const std::vector<int>& binOfCuboid,
+                                       std::vector< std::vector<int> >& edges){
+
+  double tol = _tolerances.at(dim);
+
+  unsigned nFaces = highFaces.size();
+  unsigned h = 0;
+  unsigned l = 0;
+
+  std::vector<int> stack;
+
+  while (h < nFaces){
+
+    //the high and low faces on this plane
+
+    double position = highFaces[h].position;
+
+    unsigned hEnd = h;
+    while (hEnd < nFaces && highFaces[hEnd].position <= position + tol) hEnd++;
+
+    while (l < nFaces && lowFaces[l].position < position - tol) l++;
+
+    unsigned lEnd = l;
+    while (lEnd < nFaces && lowFaces[lEnd].position <= position + tol) lEnd++;
+
+    if (lEnd == l) {
+      h = hEnd;
+      continue;
+    }
+
+    //build the hierarchy over the low faces
+
+    _faceOrder.clear();
+    for (unsigned i = l; i < lEnd; i++) _faceOrder.push_back(lowFaces[i].cuboid);
+
+    _nodeLow  .clear();
+    _nodeHigh .clear();
+    _nodeFirst.clear();
+    _nodeCount.clear();
+    _nodeLeft .clear();
+    _nodeRight.clear();
+
+    buildFaceNode(0, _faceOrder.size(), dim, low, high);
+
+    //find the low faces that each high face overlaps
+
+    for (unsigned i = h; i < hEnd; i++){
+
+      int lowSide = highFaces[i].cuboid;
+      int lowBin  = binOfCuboid[lowSide];
+
+      stack.assign(1, 0);
+
+      while (stack.size() != 0){
+
+        int node = stack.back();
+        stack.pop_back();
+
+        if (overlapsNode(node, lowSide, dim, low, high) == false) continue;
+
+        if (_nodeLeft[node] != -1){
+          stack.push_back(_nodeLeft [node]);
+          stack.push_back(_nodeRight[node]);
+          continue;
+        }
+
+        for (int k = _nodeFirst[node]; k < _nodeFirst[node] + _nodeCount[node]; k++){
+
+          int highSide = _faceOrder[k];
+          int highBin  = binOfCuboid[highSide];
+
+          if (lowBin == highBin) continue;
+          if (overlap(lowSide, highSide, dim, low, high) == false) continue;
+
+          //highBin is on the high side of lowBin, and vice versa
+          edges[lowBin ].push_back(highBin); edges[lowBin ].push_back(dim); edges[lowBin ].push_back(+1);
+          edges[highBin].push_back(lowBin ); edges[highBin].push_back(dim); edges[highBin].push_back(-1);
+        }
+      }
+    }
+
+    h = hEnd;
+  }
+
+}
+
+///Make a node of the hierarchy from the faces _faceOrder[first, first + count),
+///and return its node number. The faces are split in half (at the median
+///centre) along the dimension of the plane where their centres are most
+///spread out, until there are at most s_leafSize in each node.
+int HyperBinningAdjacency::buildFaceNode(int first, int count, int faceDim, const std::vector<double>& low, const std::vector<double>& high){
+
+  int node = _nodeFirst.size();
+
+  _nodeFirst.push_back(first);
+  _nodeCount.push_back(count);
+  _nodeLeft .push_back(-1);
+  _nodeRight.push_back(-1);
+
+  //box around every face in the node, and the spread of their centres
+
+  int nodeStart = _nodeLow.size();
+  _nodeLow .resize(nodeStart + _dimension, 0.0);
+  _nodeHigh.resize(nodeStart + _dimension, 0.0);
+
+  int    splitDim = -1;
+  double spread   = 0.0;
+
+  for (int d = 0; d < _dimension; d++){
+
+    double lo     = 0.0;
+    double hi     = 0.0;
+    double minCen = 0.0;
+    double maxCen = 0.0;
+
+    for (int i = 0; i < count; i++){
+      int    c   = _faceOrder[first + i];
+      double cen = low[c*_dimension + d] + high[c*_dimension + d];
+      if (i == 0 || low [c*_dimension + d] < lo    ) lo     = low [c*_dimension + d];
+      if (i == 0 || high[c*_dimension + d] > hi    ) hi     = high[c*_dimension + d];
+      if (i == 0 || cen                    < minCen) minCen = cen;
+      if (i == 0 || cen                    > maxCen) maxCen = cen;
+    }
+
+    _nodeLow [nodeStart + d] = lo;
+    _nodeHigh[nodeStart + d] = hi;
+
+    //every face has the same position in the dimension of the plane
+    if (d != faceDim && maxCen - minCen > spread) { spread = maxCen - minCen; splitDim = d; }
+  }
+
+  //in 1D (or if every face has the same centre) there's nothing to split
+  if (count <= s_leafSize || splitDim == -1) return node;
+
+  int half = count/2;
+  CentreLess centreLess = {low, high, _dimension, splitDim};
+  std::nth_element(_faceOrder.begin() + first, _faceOrder.begin() + first + half, _faceOrder.begin() + first + count, centreLess);
+
+  int left  = buildFaceNode(first       , half        , faceDim, low, high);
+  int right = buildFaceNode(first + half, count - half, faceDim, low, high);
+
+  _nodeLeft .at(node) = left;
+  _nodeRight.at(node) = right;
+
+  return node;
+
+}
+
+///Does a HyperCuboid overlap (by more than the tolerance) the box
+///around a node, in every dimension apart from faceDim
+bool HyperBinningAdjacency::overlapsNode(int node, int cuboid, int faceDim, const std::vector<double>& low, const std::vector<double>& high) const{
+
+  for (int d = 0; d < _dimension; d++){
+    if (d == faceDim) continue;
+    double overlapLow  = std::max(low [cuboid*_dimension + d], _nodeLow [node*_dimension + d]);
+    double overlapHigh = std::min(high[cuboid*_dimension + d], _nodeHigh[node*_dimension + d]);
+    if (overlapHigh - overlapLow <= _tolerances.at(d)) return false;
+  }
+
+  return true;
+
+}
+
+///Do two HyperCuboids overlap (by more than the tolerance) in
+///every dimension apart from skipDim
+bool HyperBinningAdjacency::overlap(int a, int b, int skipDim, const std::vector<double>& low, const std::vector<double>& high) const{
+
+  for (int d = 0; d < _dimension; d++){
+    if (d == skipDim) continue;
+    double overlapLow  = std::max(low [a*_dimension + d], low [b*_dimension + d]);
+    double overlapHigh = std::min(high[a*_dimension + d], high[b*_dimension + d]);
+    if (overlapHigh - overlapLow <= _tolerances.at(d)) return false;
+  }
+
+  return true;
+
+}
+
+///Store the edges of each bin, given as (neighbour, dimension, side),
+///in the CSR arrays. Duplicates (from bins made of several HyperCuboids)
+///are removed.
+void HyperBinningAdjacency::setEdges(std::vector< std::vector<int> >& edges){
+
+  _offsets.assign(1, 0);
+  _neighbours.clear();
+  _faceDims  .clear();
+  _faceSides .clear();
+
+  for (unsigned bin = 0; bin < edges.size(); bin++){
+
+    std::vector<int>& binEdges = edges.at(bin);
+    int nEdges = binEdges.size()/3;
+
+    std::vector< std::vector<int> > sorted(nEdges);
+    for (int e = 0; e < nEdges; e++){
+      sorted.at(e).assign(binEdges.begin() + 3*e, binEdges.begin() + 3*e + 3);
+    }
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase( std::unique(sorted.begin(), sorted.end()), sorted.end() );
+
+    for (unsigned e = 0; e < sorted.size(); e++){
+      _neighbours.push_back(sorted.at(e).at(0));
+      _faceDims  .push_back(sorted.at(e).at(1));
+      _faceSides .push_back(sorted.at(e).at(2));
+    }
+
+    _offsets.push_back(_neighbours.size());
+
+    std::vector<int>().swap(binEdges);
+  }
+
+}
+
+///Get the bin numbers of every bin sharing a face with this one
+///
+std::vector<int> HyperBinningAdjacency::getNeighbours(int bin) const{
+  return std::vector<int>(_neighbours.begin() + _offsets.at(bin), _neighbours.begin() + _offsets.at(bin + 1));
+}
+
+///Save the graph to the open (and in scope) TFile. The TTree
+///"HyperBinningAdjacency" has one entry per edge, in order of
+///bin number.
+TTree* HyperBinningAdjacency::save() const{
+
+  TTree* tree = new TTree("HyperBinningAdjacency", "HyperBinningAdjacency");
+
+  if (tree == 0){
+    ERROR_LOG << "Could not open TTree in HyperBinningAdjacency::save()";
+    return 0;
+  }
+
+  int binNumber = -1;
+  int neighbour = -1;
+  int faceDim   = -1;
+  int faceSide  =  0;
+
+  tree->Branch("binNumber", &binNumber);
+  tree->Branch("neighbour", &neighbour);
+  tree->Branch("faceDim"  , &faceDim  );
+  tree->Branch("faceSide" , &faceSide );
+
+  for (binNumber = 0; binNumber < _numBins; binNumber++){
+    for (int e = _offsets.at(binNumber); e < _offsets.at(binNumber + 1); e++){
+      neighbour = _neighbours.at(e);
+      faceDim   = _faceDims  .at(e);
+      faceSide  = _faceSides .at(e);
+      tree->Fill();
+    }
+  }
+
+  return tree;
+
+}
+
+///Load the graph saved by save(). Returns false if it can't be
+///read, or doesn't match the number of bins given.
+bool HyperBinningAdjacency::load(TString filename, int nBins, int dimension){
+
+  clear();
+
+  BulkTreeReader reader(filename, "HyperBinningAdjacency");
+
+  if (reader.isOpen() == false) return false;
+
+  int nEdges = reader.getNumEntries();
+
+  std::vector<int> binNumbers(nEdges);
+  _neighbours.resize(nEdges);
+  _faceDims  .resize(nEdges);
+  _faceSides .resize(nEdges);
+
+  if (nEdges > 0){
+    reader.addColumn("binNumber", &binNumbers .at(0));
+    reader.addColumn("neighbour", &_neighbours.at(0));
+    reader.addColumn("faceDim"  , &_faceDims  .at(0));
+    reader.addColumn("faceSide" , &_faceSides .at(0));
+    if (reader.read() == false) {
+      clear();
+      return false;
+    }
+  }
+
+  //the edges are saved in order of bin number, so just count them
+
+  _offsets.assign(nBins + 1, 0);
+
+  for (int e = 0; e < nEdges; e++){
+    int bin = binNumbers.at(e);
+    bool valid = bin >= 0 && bin < nBins && (e == 0 || bin >= binNumbers.at(e - 1));
+    valid = valid && _neighbours.at(e) >= 0 && _neighbours.at(e) < nBins;
+    valid = valid && _faceDims.at(e) >= 0 && _faceDims.at(e) < dimension;
+    if (valid == false){
+      ERROR_LOG << "HyperBinningAdjacency::load - the saved graph doesn't match the binning" << std::endl;
+      clear();
+      return false;
+    }
+    _offsets.at(bin + 1)++;
+  }
+
+  for (int bin = 0; bin < nBins; bin++) _offsets.at(bin + 1) += _offsets.at(bin);
+
+  _dimension = dimension;
+  _numBins   = nBins;
+  _tolerances.assign(dimension, 0.0);
+
+  return true;
+
+}
+
+///Destructor
+///
+HyperBinningAdjacency::~HyperBinningAdjacency(){
+
+}
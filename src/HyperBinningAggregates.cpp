@@ -0,0 +1,299 @@
+#include "HyperBinningAggregates.h"
+#include "HyperBinning.h"
+
+// std includes
+#include <algorithm>
+
+
+///Constructor for an empty hierarchy
+///
+HyperBinningAggregates::HyperBinningAggregates() :
+  _dimension(0),
+  _childOffsets(1, 0),
+  _contentsVersion(0),
+  _built(false)
+{
+
+}
+
+///Remove every HyperVolume
+///
+void HyperBinningAggregates::clear(){
+  _dimension = 0;
+  _roots       .clear();
+  _parents     .clear();
+  _childOffsets.assign(1, 0);
+  _children    .clear();
+  _binNumbers  .clear();
+  _volumeOfBin .clear();
+  _low         .clear();
+  _high        .clear();
+  _contents    .clear();
+  _sumW2       .clear();
+  _volumes     .clear();
+  _numBins     .clear();
+  _contentsVersion = 0;
+  _built = false;
+}
+
+///Copy the hierarchy of the binning, and sum the contents of
+///the histogram up it. Each HyperVolume is only summed into the
+///first HyperVolume that links to it, so nothing is counted twice.
+void HyperBinningAggregates::build(const HyperBinning& binning, const HistogramBase& histogram){
+
+  clear();
+
+  int dim      = binning.getDimension();
+  int nVolumes = binning.getNumHyperVolumes();
+  int nBins    = binning.getNumBins();
+
+  _dimension = dim;
+
+  _parents   .assign(nVolumes, -1);
+  _binNumbers.assign(nVolumes, -1);
+  _volumeOfBin.assign(nBins, -1);
+  _low       .assign(nVolumes*dim, 0.0);
+  _high      .assign(nVolumes*dim, 0.0);
+  _contents  .assign(nVolumes, 0.0);
+  _sumW2     .assign(nVolumes, 0.0);
+  _volumes   .assign(nVolumes, 0.0);
+  _numBins   .assign(nVolumes, 0);
+
+  std::vector< std::vector<int> > linked(nVolumes);
+
+  for (int vol = 0; vol < nVolumes; vol++){
+
+    HyperVolume hyperVolume = binning.getHyperVolume(vol);
+    HyperCuboid limits      = hyperVolume.getLimits();
+
+    for (int d = 0; d < dim; d++){
+      _low [vol*dim + d] = limits.getLowCorner ().at(d);
+      _high[vol*dim + d] = limits.getHighCorner().at(d);
+    }
+
+    linked.at(vol) = binning.getLinkedHyperVolumes(vol);
+
+    int bin = binning.getBinNum(vol);
+    _binNumbers.at(vol) = bin;
+
+    if (bin >= 0 && bin < nBins){
+      _volumeOfBin.at(bin) = vol;
+      _contents   .at(vol) = histogram.getBinContent(bin);
+      _sumW2      .at(vol) = histogram.getBinError(bin)*histogram.getBinError(bin);
+      _volumes    .at(vol) = hyperVolume.volume();
+      _numBins    .at(vol) = 1;
+    }
+  }
+
+  //only keep the first link to each HyperVolume
+
+  for (int vol = 0; vol < nVolumes; vol++){
+    for (unsigned i = 0; i < linked.at(vol).size(); i++){
+      int child = linked.at(vol).at(i);
+      if (child < 0 || child >= nVolumes || child == vol) continue;
+      if (_parents.at(child) == -1) _parents.at(child) = vol;
+    }
+  }
+
+  std::vector<int> nChildren(nVolumes, 0);
+  for (int vol = 0; vol < nVolumes; vol++){
+    if (_parents.at(vol) == -1) _roots.push_back(vol);
+    else nChildren.at(_parents.at(vol))++;
+  }
+
+  _childOffsets.assign(nVolumes + 1, 0);
+  for (int vol = 0; vol < nVolumes; vol++) _childOffsets.at(vol + 1) = _childOffsets.at(vol) + nChildren.at(vol);
+
+  _children.assign(_childOffsets.at(nVolumes), -1);
+  std::vector<int> filled(_childOffsets.begin(), _childOffsets.end() - 1);
+  for (int vol = 0; vol < nVolumes; vol++){
+    if (_parents.at(vol) != -1) _children.at( filled.at(_parents.at(vol))++ ) = vol;
+  }
+
+  //sum up the hierarchy, children before parents
+
+  std::vector<int> order = getTopDownOrder();
+
+  for (int i = order.size() - 1; i >= 0; i--){
+    int vol    = order.at(i);
+    int parent = _parents.at(vol);
+    if (parent == -1) continue;
+    _contents.at(parent) += _contents.at(vol);
+    _sumW2   .at(parent) += _sumW2   .at(vol);
+    _volumes .at(parent) += _volumes .at(vol);
+    _numBins .at(parent) += _numBins .at(vol);
+  }
+
+  _contentsVersion = histogram.getContentsVersion();
+  _built = true;
+
+  VERBOSE_LOG << "HyperBinningAggregates::build - summed " << nBins << " bins into " << nVolumes << " HyperVolumes" << std::endl;
+
+}
+
+///Get every HyperVolume reachable from the roots, with each
+///HyperVolume after the one that links to it
+std::vector<int> HyperBinningAggregates::getTopDownOrder() const{
+
+  std::vector<int> order(_roots);
+  order.reserve(_parents.size());
+
+  for (unsigned i = 0; i < order.size(); i++){
+    int vol = order.at(i);
+    for (int c = _childOffsets.at(vol); c < _childOffsets.at(vol + 1); c++) order.push_back(_children.at(c));
+  }
+
+  return order;
+
+}
+
+///Add a weight to a bin, and every HyperVolume above it. This keeps
+///the aggregates up to date when the histogram is filled.
+void HyperBinningAggregates::fill(int bin, double weight){
+
+  if (_built == false) return;
+  if (bin < 0 || bin >= (int)_volumeOfBin.size()) return;
+
+  int vol = _volumeOfBin[bin];
+
+  while (vol != -1){
+    _contents[vol] += weight;
+    _sumW2   [vol] += weight*weight;
+    vol = _parents[vol];
+  }
+
+}
+
+///Have the aggregates been built from the current contents
+///of this histogram?
+bool HyperBinningAggregates::isUpToDate(const HistogramBase& histogram) const{
+  if (_built == false) return false;
+  if ((int)_volumeOfBin.size() != histogram.getNBins()) return false;
+  return _contentsVersion == histogram.getContentsVersion();
+}
+
+///Get the limits of a HyperVolume
+///
+HyperCuboid HyperBinningAggregates::getLimits(int volumeNumber) const{
+
+  HyperPoint low (_dimension);
+  HyperPoint high(_dimension);
+
+  for (int d = 0; d < _dimension; d++){
+    low .at(d) = getLowEdge (volumeNumber, d);
+    high.at(d) = getHighEdge(volumeNumber, d);
+  }
+
+  return HyperCuboid(low, high);
+
+}
+
+///Get the frequency density of a HyperVolume i.e. the sum of the
+///bin contents divided by the sum of the bin volumes
+double HyperBinningAggregates::getDensity(int volumeNumber) const{
+  if (_volumes[volumeNumber] <= 0.0) return 0.0;
+  return _contents[volumeNumber]/_volumes[volumeNumber];
+}
+
+///Get the mean content of the bins in a HyperVolume
+///
+double HyperBinningAggregates::getAverageContent(int volumeNumber) const{
+  if (_numBins[volumeNumber] == 0) return 0.0;
+  return _contents[volumeNumber]/_numBins[volumeNumber];
+}
+
+///Are the limits of the HyperVolume completely inside the region?
+///
+bool HyperBinningAggregates::isInside(int volumeNumber, const HyperCuboid& region) const{
+  for (int d = 0; d < _dimension; d++){
+    if (getLowEdge (volumeNumber, d) < region.getLowCorner ().at(d)) return false;
+    if (getHighEdge(volumeNumber, d) > region.getHighCorner().at(d)) return false;
+  }
+  return true;
+}
+
+///Are the limits of the HyperVolume completely outside the region?
+///
+bool HyperBinningAggregates::isOutside(int volumeNumber, const HyperCuboid& region) const{
+  for (int d = 0; d < _dimension; d++){
+    if (getHighEdge(volumeNumber, d) <= region.getLowCorner ().at(d)) return true;
+    if (getLowEdge (volumeNumber, d) >= region.getHighCorner().at(d)) return true;
+  }
+  return false;
+}
+
+///The fraction of a HyperVolume that's inside the region
+///
+double HyperBinningAggregates::getFractionInside(const HyperVolume& hyperVolume, const HyperCuboid& region){
+
+  double total  = 0.0;
+  double inside = 0.0;
+
+  for (int i = 0; i < hyperVolume.size(); i++){
+    const HyperCuboid& cuboid = hyperVolume.at(i);
+
+    double overlap = 1.0;
+    for (int d = 0; d < cuboid.getDimension(); d++){
+      double low  = std::max(cuboid.getLowCorner ().at(d), region.getLowCorner ().at(d));
+      double high = std::min(cuboid.getHighCorner().at(d), region.getHighCorner().at(d));
+      overlap *= high > low ? high - low : 0.0;
+    }
+
+    total  += cuboid.volume();
+    inside += overlap;
+  }
+
+  if (total <= 0.0) return 0.0;
+  return inside/total;
+
+}
+
+///Integrate the histogram over a region. The hierarchy is followed
+///down from the roots, stopping at HyperVolumes that are completely
+///inside (or outside) the region. Bins that are only partly inside
+///contribute the fraction of their volume that's inside (i.e. the
+///content is assumed to be uniform across the bin). The sumW2 of
+///such a bin is scaled by the fraction squared (as for any weight
+///multiplied by the fraction), and is returned in the last argument.
+double HyperBinningAggregates::integral(const HyperCuboid& region, const BinningBase& binning, double& sumW2) const{
+
+  double integral = 0.0;
+  sumW2 = 0.0;
+
+  std::vector<int> stack(_roots.rbegin(), _roots.rend());
+
+  while (stack.empty() == false){
+
+    int vol = stack.back();
+    stack.pop_back();
+
+    if (isOutside(vol, region)) continue;
+
+    if (isInside(vol, region)){
+      integral += _contents[vol];
+      sumW2    += _sumW2   [vol];
+      continue;
+    }
+
+    int bin = _binNumbers[vol];
+
+    if (bin != -1){
+      double fraction = getFractionInside(binning.getBinHyperVolume(bin), region);
+      integral += fraction*_contents[vol];
+      sumW2    += fraction*fraction*_sumW2[vol];
+      continue;
+    }
+
+    for (int c = _childOffsets[vol + 1] - 1; c >= _childOffsets[vol]; c--) stack.push_back(_children[c]);
+
+  }
+
+  return integral;
+
+}
+
+///Destructor
+///
+HyperBinningAggregates::~HyperBinningAggregates(){
+
+}
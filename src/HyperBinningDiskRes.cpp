@@ -1,5 +1,40 @@
 #include "HyperBinningDiskRes.h"
 
+// Root includes
+#include "TROOT.h"
+
+
+int HyperBinningDiskRes::s_defaultCacheCapacity = 100000;
+int HyperBinningDiskRes::s_defaultPinnedLevels  = 10;
+
+std::atomic<Long64_t> HyperBinningDiskRes::s_numInstances(0);
+
+
+///Constructor for a Reader with no tree or file
+///
+HyperBinningDiskRes::Reader::Reader(int dim) :
+  file(0),
+  tree(0),
+  cuboid(dim),
+  linkedBins(new std::vector<int>()),
+  volumeNumber(-1),
+  currentEntry(-1),
+  clockHand(-1),
+  hits(0),
+  misses(0)
+{
+
+}
+
+///Destructor - closes the file if the Reader opened one
+///
+HyperBinningDiskRes::Reader::~Reader(){
+  if (file != 0){
+    file->Close();
+    delete file;
+  }
+  delete linkedBins;
+}
 
 ///The empty constuctor. Must call the load function to associate this
 ///object to a file
@@ -7,12 +42,13 @@ HyperBinningDiskRes::HyperBinningDiskRes() :
   _file(0),
   _writeable(false),
   _tree(0),
-  _cuboid(0),
-  _linkedBins(new std::vector<int>()),
-  _volumeNumber(-1),
-  _currentEntry(-1),
+  _mainReader(0),
   _treePrimVol(0),
-  _primVolNum(-1)
+  _primVolNum(-1),
+  _cacheCapacity(s_defaultCacheCapacity),
+  _pinnedLevels(s_defaultPinnedLevels),
+  _ownerThread(std::this_thread::get_id()),
+  _instanceId(s_numInstances++)
 {
   WELCOME_LOG << "Hello from the HyperBinningDiskRes() Constructor";
 }
@@ -23,12 +59,13 @@ HyperBinningDiskRes::HyperBinningDiskRes(const HyperBinningDiskRes& other) :
   _file(0),
   _writeable(false),
   _tree(0),
-  _cuboid(0),
-  _linkedBins(new std::vector<int>()),
-  _volumeNumber(-1),
-  _currentEntry(-1),
+  _mainReader(0),
   _treePrimVol(0),
-  _primVolNum(-1)
+  _primVolNum(-1),
+  _cacheCapacity(other._cacheCapacity),
+  _pinnedLevels(other._pinnedLevels),
+  _ownerThread(std::this_thread::get_id()),
+  _instanceId(s_numInstances++)
 { 
   if (other._writeable == true){
     other._file->Write();
@@ -45,35 +82,532 @@ void HyperBinningDiskRes::setDimension(int dim){
   
   if (getDimension() == 0){
     HyperBinning::setDimension(dim);
-    _cuboid = HyperCuboid(dim);
+    _mainReader.cuboid = HyperCuboid(dim);
   }
 
 }
 
+///Get the Reader belonging to the calling thread. The thread 
+///that loaded the binning uses _mainReader, and any other thread
+///is given its own Reader the first time it calls this.
+HyperBinningDiskRes::Reader& HyperBinningDiskRes::getReader() const{
+
+  if (std::this_thread::get_id() == _ownerThread) return _mainReader;
+
+  //remember the last Reader used by this thread, so the
+  //mutex is only needed when switching between binnings
+  static thread_local Long64_t lastInstanceId = -1;
+  static thread_local Reader*  lastReader     = 0;
+
+  if (lastInstanceId == _instanceId) return *lastReader;
+
+  std::lock_guard<std::mutex> lock(_readerMutex);
+
+  std::map<std::thread::id, Reader*>::const_iterator it = _threadReaders.find( std::this_thread::get_id() );
+
+  Reader* reader = 0;
+  if (it != _threadReaders.end()) reader = it->second;
+  else reader = createThreadReader();
+
+  lastInstanceId = _instanceId;
+  lastReader     = reader;
+
+  return *reader;
+
+}
+
+///Create a Reader for the calling thread, which opens its own
+///copy of the file. _readerMutex must be locked. Binnings that are
+///being written to can't be reopened, so if no Reader can be made
+///the thread shares _mainReader, and every read from it is 
+///serialised with _mainReaderMutex (see getVolume).
+HyperBinningDiskRes::Reader* HyperBinningDiskRes::createThreadReader() const{
+
+  if (_writeable == true || _file == 0){
+    ERROR_LOG << "HyperBinningDiskRes::getReader - the binning was opened in UPDATE or RECREATE mode, so other threads";
+    ERROR_LOG << " can't have their own copy of the file. They will take turns with the thread that loaded it." << std::endl;
+    return &_mainReader;
+  }
+
+  //Every thread has its own TFile, but ROOT still needs to
+  //protect its global state
+  ROOT::EnableThreadSafety();
+
+  Reader* reader = new Reader( getDimension() );
+  reader->file = new TFile(filename(), "READ");
+
+  if (reader->file->IsZombie() == false){
+    reader->tree = dynamic_cast<TTree*>( reader->file->Get("HyperBinning") );
+  }
+
+  if (reader->tree == 0){
+    ERROR_LOG << "HyperBinningDiskRes::getReader - could not open " << filename() << " for another thread,";
+    ERROR_LOG << " so it will take turns with the thread that loaded the binning" << std::endl;
+    delete reader;
+    return &_mainReader;
+  }
+
+  setBranchAddresses(reader->tree, *reader);
+
+  _threadReaders[ std::this_thread::get_id() ] = reader;
+
+  return reader;
+
+}
+
+///Delete the Readers of every thread other than the owner, and
+///give this object a new id so that no thread uses them again
+void HyperBinningDiskRes::deleteThreadReaders(){
+
+  std::lock_guard<std::mutex> lock(_readerMutex);
+
+  for (std::map<std::thread::id, Reader*>::iterator it = _threadReaders.begin(); it != _threadReaders.end(); ++it){
+    delete it->second;
+  }
+  _threadReaders.clear();
+
+  _instanceId = s_numInstances++;
+
+}
+
+///Point the branches of the HyperBinning tree at a Reader
+///
+void HyperBinningDiskRes::setBranchAddresses(TTree* tree, Reader& reader) const{
+
+  tree->SetBranchAddress("binNumber" , &reader.volumeNumber);
+  tree->SetBranchAddress("linkedBins", &reader.linkedBins  );
+
+  for (int i = 0; i < getDimension(); i++){
+    TString lowCornerName  = "lowCorner_" ; lowCornerName  += i; 
+    TString highCornerName = "highCorner_"; highCornerName += i;   
+    tree->SetBranchAddress(lowCornerName , &reader.cuboid.getLowCorner ().at(i) );
+    tree->SetBranchAddress(highCornerName, &reader.cuboid.getHighCorner().at(i) );
+  }
+
+  reader.currentEntry = -1;
+
+}
+
 ///Get a HyperVolume from the tree and load it into memory
 ///
-void HyperBinningDiskRes::getEntry(int volumeNumber) const{
-  if (_tree == 0){
+void HyperBinningDiskRes::getEntry(Reader& reader, int volumeNumber) const{
+  if (reader.tree == 0){
     ERROR_LOG << "HyperBinningDiskRes::getEntry - tree doesn't exist" << std::endl; 
     return;
   }
-  if ( _currentEntry != volumeNumber ){
-    _currentEntry = volumeNumber;
-    _tree->GetEntry(volumeNumber);
+  if ( reader.currentEntry != volumeNumber ){
+    reader.currentEntry = volumeNumber;
+    reader.tree->GetEntry(volumeNumber);
   }
 }
 
+///Add an empty slot to the cache of a Reader, and return its number
+///
+int HyperBinningDiskRes::addSlot(Reader& reader) const{
+
+  int slot = reader.slotVolume.size();
+
+  reader.slotCorners   .resize( reader.slotCorners.size() + 2*getDimension(), 0.0 );
+  reader.slotLinks     .push_back( std::vector<int>() );
+  reader.slotVolume    .push_back( -1 );
+  reader.slotReferenced.push_back( false );
+
+  return slot;
+
+}
+
+///Find a slot for a new volume. If the cache isn't full, a new
+///slot is added, otherwise the CLOCK algorithm is used to choose
+///which volume to remove from the cache.
+int HyperBinningDiskRes::getFreeSlot(Reader& reader) const{
+
+  int nSlots = reader.slotVolume.size();
+
+  if (nSlots < _cacheCapacity) return addSlot(reader);
+
+  while (true){
+    reader.clockHand = (reader.clockHand + 1) % nSlots;
+    if (reader.slotReferenced[reader.clockHand] == true) {
+      reader.slotReferenced[reader.clockHand] = false;
+      continue;
+    }
+    break;
+  }
+
+  reader.slotOfVolume.erase( reader.slotVolume[reader.clockHand] );
+
+  return reader.clockHand;
+
+}
+
+///Read a volume from the tree into a slot
+///
+void HyperBinningDiskRes::fillSlot(Reader& reader, int slot, int volumeNumber) const{
+
+  getEntry(reader, volumeNumber);
+
+  int dim = getDimension();
+  double* corners = &reader.slotCorners[2*dim*slot];
+
+  for (int i = 0; i < dim; i++){
+    corners[i]       = reader.cuboid.getLowCorner ().at(i);
+    corners[dim + i] = reader.cuboid.getHighCorner().at(i);
+  }
+
+  reader.slotLinks     [slot] = *reader.linkedBins;
+  reader.slotVolume    [slot] = volumeNumber;
+  reader.slotReferenced[slot] = true;
+
+  reader.slotOfVolume[volumeNumber] = slot;
+
+}
+
+///Get the slot that a volume is in, reading it from 
+///the tree if it isn't already in the cache. The slot
+///number is only valid until the next call.
+int HyperBinningDiskRes::getSlot(Reader& reader, int volumeNumber) const{
+
+  std::unordered_map<int, int>::const_iterator it = reader.slotOfVolume.find(volumeNumber);
+
+  if (it != reader.slotOfVolume.end()){
+    reader.hits.fetch_add(1, std::memory_order_relaxed);
+    reader.slotReferenced[it->second] = true;
+    return it->second;
+  }
+
+  reader.misses.fetch_add(1, std::memory_order_relaxed);
+
+  int slot = getFreeSlot(reader);
+  fillSlot(reader, slot, volumeNumber);
+  return slot;
+
+}
+
+///Get the corners (low then high) and links of a volume, either 
+///from the pinned volumes or the cache of the calling thread. The 
+///pointers are only valid until the next call from the same thread.
+///If they point into _mainReader (which other threads may be sharing,
+///see createThreadReader) lock is set to hold _mainReaderMutex, and
+///they must only be used while it's held.
+void HyperBinningDiskRes::getVolume(int volumeNumber, const double*& corners, const std::vector<int>*& links, std::unique_lock<std::mutex>& lock) const{
+
+  int dim = getDimension();
+  Reader& reader = getReader();
+
+  std::unordered_map<int, int>::const_iterator it = _pinnedSlotOfVolume.find(volumeNumber);
+
+  if (it != _pinnedSlotOfVolume.end()){
+    reader.hits.fetch_add(1, std::memory_order_relaxed);
+    corners = &_pinnedCorners[2*dim*it->second];
+    links   = &_pinnedLinks  [it->second];
+    return;
+  }
+
+  if (&reader == &_mainReader) lock = std::unique_lock<std::mutex>(_mainReaderMutex);
+
+  int slot = getSlot(reader, volumeNumber);
+  corners = &reader.slotCorners[2*dim*slot];
+  links   = &reader.slotLinks  [slot];
+
+}
+
+///Pin the top _pinnedLevels levels of the bin hierarchy (starting
+///from the primary volumes) in memory. No more volumes than the
+///cache capacity are pinned.
+void HyperBinningDiskRes::pinTopLevels(){
+
+  if (_tree == 0 || _pinnedLevels <= 0) return;
+
+  int nVolumes = getNumHyperVolumes();
+  if (nVolumes == 0) return;
+
+  int dim = getDimension();
+
+  std::vector<int> level;
+
+  int nPrimVols = getNumPrimaryVolumes();
+  if (nPrimVols == 0) level.push_back(0);
+  for (int i = 0; i < nPrimVols; i++) level.push_back( getPrimaryVolumeNumber(i) );
+
+  for (int l = 0; l < _pinnedLevels && level.size() != 0; l++){
+
+    std::vector<int> nextLevel;
+
+    for (unsigned i = 0; i < level.size(); i++){
+      
+      int volumeNumber = level.at(i);
+
+      if (volumeNumber < 0 || volumeNumber >= nVolumes) continue;
+      if (_pinnedSlotOfVolume.count(volumeNumber) != 0) continue;
+      if (getNumPinnedVolumes() >= _cacheCapacity) {
+        nextLevel.clear();
+        break;
+      }
+
+      getEntry(_mainReader, volumeNumber);
+
+      _pinnedSlotOfVolume[volumeNumber] = _pinnedLinks.size();
+
+      for (int j = 0; j < dim; j++) _pinnedCorners.push_back( _mainReader.cuboid.getLowCorner ().at(j) );
+      for (int j = 0; j < dim; j++) _pinnedCorners.push_back( _mainReader.cuboid.getHighCorner().at(j) );
+      _pinnedLinks.push_back( *_mainReader.linkedBins );
+
+      nextLevel.insert(nextLevel.end(), _mainReader.linkedBins->begin(), _mainReader.linkedBins->end());
+    }
+
+    level.swap(nextLevel);
+  }
+
+  VERBOSE_LOG << "Pinned " << getNumPinnedVolumes() << " HyperVolumes in memory";
+
+}
+
+///Remove every volume from the cache of a Reader
+///
+void HyperBinningDiskRes::clearSlots(Reader& reader) const{
+  reader.slotCorners   .clear();
+  reader.slotLinks     .clear();
+  reader.slotVolume    .clear();
+  reader.slotReferenced.clear();
+  reader.slotOfVolume  .clear();
+  reader.clockHand = -1;
+}
+
+///Remove every volume from the cache of every thread, then pin 
+///the top levels of the bin hierarchy again. Must not be called 
+///while other threads are reading from the binning.
+void HyperBinningDiskRes::clearCache(){
+
+  _pinnedCorners     .clear();
+  _pinnedLinks       .clear();
+  _pinnedSlotOfVolume.clear();
+
+  clearSlots(_mainReader);
+
+  {
+    std::lock_guard<std::mutex> lock(_readerMutex);
+    for (std::map<std::thread::id, Reader*>::iterator it = _threadReaders.begin(); it != _threadReaders.end(); ++it){
+      clearSlots(*it->second);
+    }
+  }
+
+  pinTopLevels();
+
+}
+
+///Set the maximum number of volumes that can be held in the 
+///cache of each thread (not including the pinned volumes). Each 
+///volume takes roughly 16*dim + 64 bytes, plus 4 bytes per link.
+void HyperBinningDiskRes::setCacheCapacity(int nVolumes){
+  if (nVolumes < 1) {
+    ERROR_LOG << "HyperBinningDiskRes::setCacheCapacity - the cache must hold at least one volume" << std::endl;
+    nVolumes = 1;
+  }
+  _cacheCapacity = nVolumes;
+  clearCache();
+}
+
+///Set how many levels of the bin hierarchy are pinned in memory.
+///Zero means nothing is pinned.
+void HyperBinningDiskRes::setPinnedLevels(int nLevels){
+  _pinnedLevels = nLevels;
+  clearCache();
+}
+
+///Get ready for several threads to read from the binning at once.
+///The bin numbering, limits, average bin width and the index over 
+///the primary volumes are all found here, so that no thread needs 
+///to update them while others are reading. Only the reading of 
+///HyperVolumes (getHyperVolume, getBinNum, ...) is safe to do 
+///from several threads; the binning must not be changed while 
+///they are running.
+void HyperBinningDiskRes::prepareConcurrentReads() const{
+
+  if (_writeable == true){
+    ERROR_LOG << "HyperBinningDiskRes::prepareConcurrentReads - binning must be opened in READ mode" << std::endl;
+    return;
+  }
+
+  ROOT::EnableThreadSafety();
+
+  updateFullBinNumbering();
+  getLimits             ();
+  getAverageBinWidth    ();
+  getVolumeIndex        ();
+
+}
+
+///Number of threads, including the one that loaded the 
+///binning, that have read from it
+int HyperBinningDiskRes::getNumReaders() const{
+  std::lock_guard<std::mutex> lock(_readerMutex);
+  return _threadReaders.size() + 1;
+}
+
+///Number of volumes held in memory, summed over every thread
+///(including the pinned volumes). The caches of the other threads
+///aren't locked, so only call this while they aren't reading.
+int HyperBinningDiskRes::getNumCachedVolumes() const{
+  std::lock_guard<std::mutex> lock(_readerMutex);
+  int nVolumes = getNumPinnedVolumes() + _mainReader.slotVolume.size();
+  for (std::map<std::thread::id, Reader*>::const_iterator it = _threadReaders.begin(); it != _threadReaders.end(); ++it){
+    nVolumes += it->second->slotVolume.size();
+  }
+  return nVolumes;
+}
+
+///Number of volume lookups, summed over every thread, 
+///that were found in memory. Safe to call while other threads
+///are reading (their counts are atomic).
+Long64_t HyperBinningDiskRes::getCacheHits() const{
+  std::lock_guard<std::mutex> lock(_readerMutex);
+  Long64_t hits = _mainReader.hits.load(std::memory_order_relaxed);
+  for (std::map<std::thread::id, Reader*>::const_iterator it = _threadReaders.begin(); it != _threadReaders.end(); ++it){
+    hits += it->second->hits.load(std::memory_order_relaxed);
+  }
+  return hits;
+}
+
+///Number of volume lookups, summed over every thread, 
+///that had to be read from the file
+Long64_t HyperBinningDiskRes::getCacheMisses() const{
+  std::lock_guard<std::mutex> lock(_readerMutex);
+  Long64_t misses = _mainReader.misses.load(std::memory_order_relaxed);
+  for (std::map<std::thread::id, Reader*>::const_iterator it = _threadReaders.begin(); it != _threadReaders.end(); ++it){
+    misses += it->second->misses.load(std::memory_order_relaxed);
+  }
+  return misses;
+}
+
+///Approximate memory (in MB) used by the pinned volumes and 
+///the cache of every thread. The caches of the other threads
+///aren't locked, so only call this while they aren't reading.
+double HyperBinningDiskRes::getCacheMemory() const{
+
+  std::vector<const Reader*> readers(1, &_mainReader);
+  {
+    std::lock_guard<std::mutex> lock(_readerMutex);
+    for (std::map<std::thread::id, Reader*>::const_iterator it = _threadReaders.begin(); it != _threadReaders.end(); ++it){
+      readers.push_back(it->second);
+    }
+  }
+
+  double bytes = _pinnedCorners.size()*sizeof(double);
+  
+  for (unsigned i = 0; i < _pinnedLinks.size(); i++){
+    bytes += sizeof(std::vector<int>) + _pinnedLinks[i].capacity()*sizeof(int);
+  }
+  
+  //the hash map entry
+  bytes += _pinnedLinks.size()*(2*sizeof(int) + 2*sizeof(void*));
+
+  for (unsigned r = 0; r < readers.size(); r++){
+
+    const Reader& reader = *readers.at(r);
+
+    bytes += reader.slotCorners.size()*sizeof(double);
+    
+    for (unsigned i = 0; i < reader.slotLinks.size(); i++){
+      bytes += sizeof(std::vector<int>) + reader.slotLinks[i].capacity()*sizeof(int);
+    }
+
+    //volume number, flag, and the hash map entry
+    bytes += reader.slotVolume.size()*(sizeof(int) + 2*sizeof(int) + 4*sizeof(void*));
+  }
+
+  return bytes/(1024.0*1024.0);
+
+}
+
+///Fraction of volume lookups that were found in memory
+///
+double HyperBinningDiskRes::getCacheHitRate() const{
+  Long64_t hits     = getCacheHits();
+  Long64_t nLookups = hits + getCacheMisses();
+  if (nLookups == 0) return 0.0;
+  return double(hits)/double(nLookups);
+}
+
+///Reset the number of cache hits and misses of every thread
+///
+void HyperBinningDiskRes::resetCacheStatistics(){
+  std::lock_guard<std::mutex> lock(_readerMutex);
+  _mainReader.hits  .store(0, std::memory_order_relaxed);
+  _mainReader.misses.store(0, std::memory_order_relaxed);
+  for (std::map<std::thread::id, Reader*>::iterator it = _threadReaders.begin(); it != _threadReaders.end(); ++it){
+    it->second->hits  .store(0, std::memory_order_relaxed);
+    it->second->misses.store(0, std::memory_order_relaxed);
+  }
+}
+
+///Print the cache hits, misses and memory use
+///
+void HyperBinningDiskRes::printCacheStatistics() const{
+  INFO_LOG << "HyperBinningDiskRes cache: " << getCacheHits() << " hits, " << getCacheMisses() << " misses";
+  INFO_LOG << " (hit rate " << getCacheHitRate()*100.0 << "%) over " << getNumReaders() << " threads" << std::endl;
+  INFO_LOG << "HyperBinningDiskRes cache: " << getNumCachedVolumes() << " volumes (" << getNumPinnedVolumes() << " pinned), ";
+  INFO_LOG << getCacheMemory() << " MB" << std::endl;
+}
+
 ///Get a HyperVolume from its volume number
 HyperVolume HyperBinningDiskRes::getHyperVolume(int volumeNumber) const{
-  getEntry(volumeNumber);
-  return HyperVolume(_cuboid);
+
+  int dim = getDimension();
+  const double*           corners = 0;
+  const std::vector<int>* links   = 0;
+  std::unique_lock<std::mutex> lock;
+  getVolume(volumeNumber, corners, links, lock);
+
+  HyperPoint lowCorner (dim);
+  HyperPoint highCorner(dim);
+  for (int i = 0; i < dim; i++){
+    lowCorner .at(i) = corners[i];
+    highCorner.at(i) = corners[dim + i];
+  }
+
+  return HyperVolume( HyperCuboid(lowCorner, highCorner) );
 } 
 
 ///Get all HyperVolumes linked to a specific volume number i.e.
 ///from the binning hiearcy
 std::vector<int> HyperBinningDiskRes::getLinkedHyperVolumes( int volumeNumber ) const{
-  getEntry(volumeNumber);
-  return *_linkedBins;
+  const double*           corners = 0;
+  const std::vector<int>* links   = 0;
+  std::unique_lock<std::mutex> lock;
+  getVolume(volumeNumber, corners, links, lock);
+  return *links;
+}
+
+///Get the number of HyperVolumes linked to a specific volume number
+///
+int HyperBinningDiskRes::getNumLinkedHyperVolumes( int volumeNumber ) const{
+  const double*           corners = 0;
+  const std::vector<int>* links   = 0;
+  std::unique_lock<std::mutex> lock;
+  getVolume(volumeNumber, corners, links, lock);
+  return links->size();
+}
+
+///Is a HyperPoint inside one of the HyperVolumes. Tests the
+///cached corners directly, using the same convention as 
+///HyperCuboid::inVolume (low < x <= high).
+bool HyperBinningDiskRes::isInHyperVolume(int volumeNumber, const HyperPoint& coords) const{
+
+  int dim = getDimension();
+  const double*           corners = 0;
+  const std::vector<int>* links   = 0;
+  std::unique_lock<std::mutex> lock;
+  getVolume(volumeNumber, corners, links, lock);
+
+  const double* low  = corners;
+  const double* high = corners + dim;
+
+  for (int i = 0; i < dim; i++){
+    double x = coords.at(i);
+    if ( (low[i] < x && x <= high[i]) == false ) return false;
+  }
+
+  return true;
 }
 
 ///Create a clone of the object and return a pointer to it.
@@ -114,6 +648,7 @@ void HyperBinningDiskRes::addPrimaryVolumeNumber(int volumeNumber){
 
   _primVolNum = volumeNumber;
   _treePrimVol->Fill();
+  _primaryVolumeNumbers.push_back(volumeNumber);
 }
 
 
@@ -150,13 +685,16 @@ bool HyperBinningDiskRes::addHyperVolume(const HyperVolume& hyperVolume, std::ve
     return false;
   }
 
+  std::lock_guard<std::mutex> lock(_mainReaderMutex);
+
   int nVolumes = getNumHyperVolumes();
   for (int i = 0; i < hyperVolume.size(); i++){
-    *_linkedBins  = linkedVolumes;
-    _cuboid       = hyperVolume.at(i);
-    _volumeNumber = nVolumes;
+    *_mainReader.linkedBins  = linkedVolumes;
+    _mainReader.cuboid       = hyperVolume.at(i);
+    _mainReader.volumeNumber = nVolumes;
     _tree->Fill();
   }
+  _mainReader.currentEntry = -1;
   
   updateCash();
   
@@ -167,18 +705,13 @@ bool HyperBinningDiskRes::addHyperVolume(const HyperVolume& hyperVolume, std::ve
 ///Get the number of primary volumes
 ///
 int HyperBinningDiskRes::getNumPrimaryVolumes  () const{
-  if (_treePrimVol == 0) return 0;
-  return _treePrimVol->GetEntries();
+  return _primaryVolumeNumbers.size();
 }
 
-///Get the primary volume numbers 
-///
+///Get the primary volume numbers. These are read into memory
+///when the binning is loaded, so the tree isn't used here.
 int HyperBinningDiskRes::getPrimaryVolumeNumber(int i) const{
-  if (_treePrimVol == 0) {
-    ERROR_LOG << "HyperBinningDiskRes::getPrimaryVolumeNumber - No tree found" << std::endl;
-  }
-  _treePrimVol->GetEntry(i);
-  return _primVolNum;
+  return _primaryVolumeNumbers.at(i);
 }
 
 
@@ -194,18 +727,10 @@ void HyperBinningDiskRes::loadHyperBinningTree(){
   //Figure out how many dimensions there are from the tree
   setDimension( getHyperBinningDimFromTree(_tree) );
   
-  _tree->SetBranchAddress("binNumber" , &_volumeNumber);
-  _tree->SetBranchAddress("linkedBins", &_linkedBins   );
-
-  for (int i = 0; i < getDimension(); i++){
-    TString lowCornerName  = "lowCorner_" ; lowCornerName  += i; 
-    TString highCornerName = "highCorner_"; highCornerName += i;   
-    _tree->SetBranchAddress(lowCornerName , &_cuboid.getLowCorner ().at(i) );
-    _tree->SetBranchAddress(highCornerName, &_cuboid.getHighCorner().at(i) );
-  }
+  _mainReader.tree = _tree;
+  setBranchAddresses(_tree, _mainReader);
   
   //_tree->SetMaxVirtualSize(1000);
-  _currentEntry = -1;
   updateCash();
 
 }
@@ -223,6 +748,13 @@ void HyperBinningDiskRes::loadPrimaryVolumeTree(){
 
   _treePrimVol->SetBranchAddress("volumeNumber", &_primVolNum);
 
+  int nPrimVols = _treePrimVol->GetEntries();
+  _primaryVolumeNumbers.resize(nPrimVols);
+  for (int i = 0; i < nPrimVols; i++){
+    _treePrimVol->GetEntry(i);
+    _primaryVolumeNumbers.at(i) = _primVolNum;
+  }
+
 }
 
 void HyperBinningDiskRes::createHyperBinningTree(){
@@ -242,20 +774,21 @@ void HyperBinningDiskRes::createHyperBinningTree(){
     return;
   }
 
-  _tree->Branch("binNumber" , &_volumeNumber );
-  _tree->Branch("linkedBins", &_linkedBins   );
+  _tree->Branch("binNumber" , &_mainReader.volumeNumber );
+  _tree->Branch("linkedBins", &_mainReader.linkedBins   );
 
   for (int i = 0; i < dim; i++){
     TString lowCornerName  = "lowCorner_" ; lowCornerName  += i; 
     TString highCornerName = "highCorner_"; highCornerName += i;   
-    _tree->Branch(lowCornerName , &_cuboid.getLowCorner ().at(i) );
-    _tree->Branch(highCornerName, &_cuboid.getHighCorner().at(i) );
+    _tree->Branch(lowCornerName , &_mainReader.cuboid.getLowCorner ().at(i) );
+    _tree->Branch(highCornerName, &_mainReader.cuboid.getHighCorner().at(i) );
   }
   
   //random access is really slow. Thought this might help
   //_tree->SetMaxVirtualSize(1000);
 
-  _currentEntry = -1;
+  _mainReader.tree         = _tree;
+  _mainReader.currentEntry = -1;
   updateCash();
 
 }
@@ -283,7 +816,19 @@ void HyperBinningDiskRes::load(TString filename, TString option){
     _writeable = true;
   }
   
-  if (_file != 0) _file->Close();
+  //the readers of other threads use the old file
+  deleteThreadReaders();
+  _ownerThread = std::this_thread::get_id();
+
+  if (_file != 0) {
+    _file->Close();
+    _tree        = 0;
+    _treePrimVol = 0;
+  }
+
+  _mainReader.tree = 0;
+  _primaryVolumeNumbers.clear();
+  clearCache();
 
   _file = new TFile(filename, option);
   
@@ -295,6 +840,8 @@ void HyperBinningDiskRes::load(TString filename, TString option){
   if (option == "UPDATE" || option == "READ"){
     loadHyperBinningTree   ();
     loadPrimaryVolumeTree  ();
+    loadCache              (filename);
+    clearCache             ();
   }
   else if (option == "RECREATE"){
     //if we're opening a new file, we don't know the dimension yet.
@@ -334,18 +881,21 @@ void HyperBinningDiskRes::reserveCapacity(int nElements){
 HyperBinningDiskRes::~HyperBinningDiskRes(){
   GOODBYE_LOG << "Goodbye from the HyperBinningDiskRes() Constructor";
 
+  deleteThreadReaders();
+
   if (_file != 0) {
     _file->cd();
     if (_writeable == true){
       _tree       ->Write();
       _treePrimVol->Write();
+      //only save the cache if it's already been found - it
+      //isn't worth looping over every volume to find it here
+      if (_tree != 0 && isCacheUpToDate()) saveCache(true);
     }
     _file->Close();
     _file = 0;
   }
 
-  delete _linkedBins;
-
 }
 
 
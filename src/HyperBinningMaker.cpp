@@ -5,6 +5,9 @@
 ///Just an empty contructor to make it compile (private, will never be used)
 ///
 HyperBinningMaker::HyperBinningMaker() :
+  _frontierSorted(true),
+  _numBins(0),
+  _numContinueBins(0),
   _minimumEdgeLength(0),
   _drawAlgorithm          (false),  
   _iterationNum           (0    ),
@@ -26,6 +29,10 @@ HyperBinningMaker::HyperBinningMaker(const HyperCuboid& binningRange, const Hype
   _shadowHyperPointSets   (1, HyperPointSet( binningRange.getDimension() ) ), 
   _status                 (1, VolumeStatus::CONTINUE ),
   _dimSpecificStatus      (1, std::vector<int>( binningRange.getDimension(), VolumeStatus::CONTINUE )  ),  
+  _frontier               (1, 0),
+  _frontierSorted         (true),
+  _numBins                (1),
+  _numContinueBins        (1),
   _shadowAdded            (false),
   _useEventWeights        (false),
   _minimumBinContent      (15),
@@ -65,6 +72,10 @@ void HyperBinningMaker::updateFromExistingHyperBinning( const HyperBinning& binn
   _linkedBins           .clear();
   _status               .clear();  
   _dimSpecificStatus    .clear();  
+  _frontier             .clear();
+  _frontierSorted  = true;
+  _numBins         = 0;
+  _numContinueBins = 0;
   
 
   int nvols = binning.getNumHyperVolumes();
@@ -76,6 +87,9 @@ void HyperBinningMaker::updateFromExistingHyperBinning( const HyperBinning& binn
     if ( _linkedBins.at(i).size() == 0 ){
       _status           .push_back( VolumeStatus::CONTINUE );
       _dimSpecificStatus.push_back( std::vector<int>( binning.getDimension(), VolumeStatus::CONTINUE ) );
+      _frontier         .push_back( i );
+      _numBins++;
+      _numContinueBins++;
     }
     else {
       _status           .push_back( VolumeStatus::DONE );
@@ -259,6 +273,12 @@ void HyperBinningMaker::addBin(const HyperCuboid& hyperCuboid, const HyperPointS
   std::vector<int> dimStatus( hyperCuboid.getDimension(), status);
   _dimSpecificStatus.push_back(dimStatus);
 
+  _numBins++;
+  if (status == VolumeStatus::CONTINUE){
+    _numContinueBins++;
+    _frontier.push_back( _hyperCuboids.size() - 1 );
+  }
+
 }
 
 ///Check that we are allowed to bin in this dimension
@@ -309,7 +329,7 @@ void HyperBinningMaker::setDimSpecStatusFromMinBinWidths(int volumeNumber){
   }  
 
   if (allDone == true){
-    getGlobalVolumeStatus(volumeNumber) = VolumeStatus::DONE;
+    setGlobalVolumeStatus(volumeNumber, VolumeStatus::DONE);
   }
 
 }
@@ -336,7 +356,7 @@ void HyperBinningMaker::updateGlobalStatusFromDimSpecific(int volumeNumber){
   }  
 
   if (allDone == true){
-    getGlobalVolumeStatus(volumeNumber) = VolumeStatus::DONE;
+    setGlobalVolumeStatus(volumeNumber, VolumeStatus::DONE);
   }
 
 }
@@ -470,6 +490,7 @@ int HyperBinningMaker::split(int volumeNumber, int dimension, double splitPoint)
   VERBOSE_LOG << "Linking old bin to new bins"<<std::endl;
   _linkedBins.at( volumeNumber ).push_back( newVolumeNum1 );
   _linkedBins.at( volumeNumber ).push_back( newVolumeNum2 );
+  _numBins--;
   
   //clear the HyperPoints and Shadow HyperPoints associated
   //to the original volume.
@@ -483,7 +504,7 @@ int HyperBinningMaker::split(int volumeNumber, int dimension, double splitPoint)
 
   //finally, set the status of the original volume to DONE
 
-  _status.at(volumeNumber) = VolumeStatus::DONE;
+  setGlobalVolumeStatus(volumeNumber, VolumeStatus::DONE);
 
   setDimSpecStatusFromMinBinWidths(newVolumeNum1);
   setDimSpecStatusFromMinBinWidths(newVolumeNum2);
@@ -781,11 +802,12 @@ int HyperBinningMaker::smartLikelihoodSplit(int binNumber){
 ///
 int HyperBinningMaker::likelihoodSplitAll(){
   
-  int initialSize = _hyperCuboids.size();
+  std::vector<int> frontier = getFrontier();
   int nSplits = 0;
 
-  for (int i = 0; i < initialSize; i++){
-    if (_status.at(i) == 1) {
+  for (unsigned j = 0; j < frontier.size(); j++){
+    int i = frontier.at(j);
+    if (_status.at(i) == VolumeStatus::CONTINUE) {
       nSplits += likelihoodSplit(i);
     }
   }
@@ -798,11 +820,12 @@ int HyperBinningMaker::likelihoodSplitAll(){
 ///
 int HyperBinningMaker::smartLikelihoodSplitAll(){
   
-  int initialSize = _hyperCuboids.size();
+  std::vector<int> frontier = getFrontier();
   int nSplits = 0;
 
-  for (int i = 0; i < initialSize; i++){
-    if (_status.at(i) == 1) {
+  for (unsigned j = 0; j < frontier.size(); j++){
+    int i = frontier.at(j);
+    if (_status.at(i) == VolumeStatus::CONTINUE) {
       smartLikelihoodSplit(i);
       nSplits++;
     }
@@ -997,10 +1020,11 @@ int HyperBinningMaker::smartSplitInt(int binNumber, int dimension, double dataFr
 ///
 int HyperBinningMaker::splitAll(int dimension, double splitPoint){
   
-  int initialSize = _hyperCuboids.size();
+  std::vector<int> frontier = getFrontier();
   int nSplits = 0;
 
-  for (int i = 0; i < initialSize; i++){
+  for (unsigned j = 0; j < frontier.size(); j++){
+    int i = frontier.at(j);
     if (_status.at(i) == VolumeStatus::CONTINUE) {
       nSplits += split(i, dimension, splitPoint);
     }
@@ -1014,10 +1038,11 @@ int HyperBinningMaker::splitAll(int dimension, double splitPoint){
 /// have a fraction 'dataFraction' of the original events.
 int HyperBinningMaker::smartSplitAll(int dimension, double dataFraction){
   
-  int initialSize = _hyperCuboids.size();
+  std::vector<int> frontier = getFrontier();
   int nSplits = 0;
 
-  for (int i = 0; i < initialSize; i++){
+  for (unsigned j = 0; j < frontier.size(); j++){
+    int i = frontier.at(j);
     if (_status.at(i) == VolumeStatus::CONTINUE) {
       nSplits += smartSplit(i, dimension, dataFraction);
     }
@@ -1032,10 +1057,11 @@ int HyperBinningMaker::smartSplitAll(int dimension, double dataFraction){
 /// have a fraction 'dataFraction' of the original events.
 int HyperBinningMaker::smartMultiSplitAll(int dimension){
   
-  int initialSize = _hyperCuboids.size();
+  std::vector<int> frontier = getFrontier();
   int nSplits = 0;
 
-  for (int i = 0; i < initialSize; i++){
+  for (unsigned j = 0; j < frontier.size(); j++){
+    int i = frontier.at(j);
     if (_status.at(i) == VolumeStatus::CONTINUE) {
       nSplits += smartMultiSplit(i, dimension);
     }
@@ -1055,11 +1081,12 @@ int HyperBinningMaker::smartMultiSplitAll(int dimension){
 /// are integers, so splits are only made at integers + 0.5
 int HyperBinningMaker::smartSplitAllInt(int dimension, double dataFraction){
   
-  int initialSize = _hyperCuboids.size();
+  std::vector<int> frontier = getFrontier();
   int nSplits = 0;
 
-  for (int i = 0; i < initialSize; i++){
-    if (_status.at(i) == 1) {
+  for (unsigned j = 0; j < frontier.size(); j++){
+    int i = frontier.at(j);
+    if (_status.at(i) == VolumeStatus::CONTINUE) {
       nSplits += smartSplitInt(i, dimension, dataFraction);
     }
   }
@@ -1073,12 +1100,13 @@ int HyperBinningMaker::smartSplitAllInt(int dimension, double dataFraction){
 /// The dimension to split in is chosen at random.
 int HyperBinningMaker::smartSplitAllRandomise(double dataFraction){
   
-  int initialSize = _hyperCuboids.size();
+  std::vector<int> frontier = getFrontier();
   int nSplits = 0;
   
   int ndim = _binningDimensions.size();
 
-  for (int i = 0; i < initialSize; i++){
+  for (unsigned j = 0; j < frontier.size(); j++){
+    int i = frontier.at(j);
     if (_status.at(i) == VolumeStatus::CONTINUE) {
       int dimension = floor(_random->Uniform(0, ndim));
       nSplits += smartSplit(i, _binningDimensions.at(dimension) , dataFraction);
@@ -1094,12 +1122,13 @@ int HyperBinningMaker::smartSplitAllRandomise(double dataFraction){
 /// The dimension to split in is chosen at random.
 int HyperBinningMaker::splitAllRandomise(double splitPoint){
   
-  int initialSize = _hyperCuboids.size();
+  std::vector<int> frontier = getFrontier();
   int nSplits = 0;
 
   int ndim = _binningDimensions.size();
 
-  for (int i = 0; i < initialSize; i++){
+  for (unsigned j = 0; j < frontier.size(); j++){
+    int i = frontier.at(j);
     if (_status.at(i) == VolumeStatus::CONTINUE) {
       int dimension = floor(_random->Uniform(0, ndim));
       nSplits += split(i, _binningDimensions.at(dimension), splitPoint);
@@ -1150,11 +1179,7 @@ void HyperBinningMaker::setMinimumEdgeLength(HyperPoint val)  {
 ///hierarchy which help event to be binned efficiently - this is
 ///descirbed in detail in the HyperVolumeBinning class.
 int HyperBinningMaker::getNumBins() const{
-  int count = 0;
-  for ( int i = 0; i < getNumHyperVolumes(); i++){
-    if (_linkedBins.at(i).size() == 0) count++;
-  }
-  return count;
+  return _numBins;
 }
 
 ///return the number of HyperVolumes - this is NOT the number
@@ -1171,20 +1196,17 @@ int HyperBinningMaker::getNumHyperVolumes() const{
 ///Global status
 int HyperBinningMaker::getNumContinueBins(int dimension) const{
   
-  int size  = getNumHyperVolumes();
+  if (dimension == -1) return _numContinueBins;
+
+  //every CONTINUE volume is in the frontier, so there
+  //is no need to look at any of the other volumes
   int count = 0;
-  
-  //std::cout << "getNumContinueBins " << dimension << std::endl;
 
-  for (int i = 0; i < size; i++){
+  for (unsigned j = 0; j < _frontier.size(); j++){
+    int i = _frontier.at(j);
     if ( getGlobalVolumeStatus(i) == VolumeStatus::CONTINUE ) {
-      if ( dimension == -1 ){
+      if ( getDimensionSpecificVolumeStatus(i, dimension) == VolumeStatus::CONTINUE ){
         count++;
-      } 
-      else{
-        if ( getDimensionSpecificVolumeStatus(i, dimension) == VolumeStatus::CONTINUE ){
-          count++;
-        }
       }
     }
   }  
@@ -1192,6 +1214,46 @@ int HyperBinningMaker::getNumContinueBins(int dimension) const{
   return count;
 }
 
+///Set the global status of a volume, keeping the count
+///of CONTINUE volumes (and the frontier) up to date
+void HyperBinningMaker::setGlobalVolumeStatus(int volumeNumber, int status){
+
+  int& current = _status.at(volumeNumber);
+  if (current == status) return;
+
+  if (current == VolumeStatus::CONTINUE) _numContinueBins--;
+  if (status  == VolumeStatus::CONTINUE) {
+    _numContinueBins++;
+    _frontier.push_back(volumeNumber);
+    _frontierSorted = false;
+  }
+
+  current = status;
+}
+
+///Get the volumes that still have the CONTINUE status, in volume
+///order. Volumes that have been split or marked DONE since the last
+///call are removed first, so this is proportional to the number of 
+///volumes created or left unsplit in the last pass, rather than the
+///total number of volumes.
+const std::vector<int>& HyperBinningMaker::getFrontier(){
+
+  if (_frontierSorted == false){
+    std::sort(_frontier.begin(), _frontier.end());
+    _frontier.erase( std::unique(_frontier.begin(), _frontier.end()), _frontier.end() );
+    _frontierSorted = true;
+  }
+
+  unsigned nKept = 0;
+  for (unsigned j = 0; j < _frontier.size(); j++){
+    int i = _frontier.at(j);
+    if ( _status.at(i) == VolumeStatus::CONTINUE ) _frontier.at(nKept++) = i;
+  }
+  _frontier.resize(nKept);
+
+  return _frontier;
+}
+
 
 
 ///Use the current state of the HyperBinningMaker to create
@@ -0,0 +1,686 @@
+#include "HyperBinningMakerOutOfCore.h"
+
+#include "HyperPointSetReader.h"
+
+#include "TFile.h"
+#include "TSystem.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cmath>
+
+///Constructor that takes the limits of the binning and the
+///algorithm to use (only MINT and SMART are avaliable)
+HyperBinningMakerOutOfCore::HyperBinningMakerOutOfCore(const HyperCuboid& binningRange, HyperBinningAlgorithms::Alg alg) :
+  _binningRange     (binningRange),
+  _alg              (alg),
+  _startingDim      (0),
+  _useEventWeights  (false),
+  _minimumBinContent(15),
+  _minimumEdgeLength( HyperPoint(binningRange.getDimension(), 0.1) ),
+  _memoryBudget     (1024.0*1024.0*1024.0),
+  _scratchDir       ("."),
+  _dimension        (binningRange.getDimension()),
+  _numWeights       (0),
+  _recordSize       (binningRange.getDimension()),
+  _firstVolume      (0),
+  _numHyperVolumes  (0),
+  _numBins          (0),
+  _target           (0),
+  _bytesRead        (0.0),
+  _bytesWritten     (0.0)
+{
+  WELCOME_LOG << "Good day from the HyperBinningMakerOutOfCore() Constructor";
+
+  for (int i = 0; i < binningRange.getDimension(); i++) _binningDimensions.push_back(i);
+
+  if (_alg != HyperBinningAlgorithms::MINT && _alg != HyperBinningAlgorithms::SMART){
+    ERROR_LOG << "HyperBinningMakerOutOfCore only supports the MINT and SMART algorithms - using MINT" << std::endl;
+    _alg = HyperBinningAlgorithms::MINT;
+  }
+
+  //every instance gets its own scratch files, so several
+  //binnings can be made at once (even from one process)
+  static int instanceNumber = 0;
+  _scratchPrefix  = "HyperBinningScratch_";
+  _scratchPrefix += gSystem->GetPid();
+  _scratchPrefix += "_";
+  _scratchPrefix += instanceNumber++;
+
+}
+
+///Set the minimum bin width (the same in every dimension)
+///
+void HyperBinningMakerOutOfCore::setMinimumEdgeLength(double val){
+  _minimumEdgeLength = HyperPoint(_binningRange.getDimension(), val);
+}
+
+///Set the minimum bin width in each dimension
+///
+void HyperBinningMakerOutOfCore::setMinimumEdgeLength(HyperPoint val){
+  _minimumEdgeLength = val;
+}
+
+///Set the amount of memory (in MB) that can be used to buffer
+///points. Scratch files smaller than half of this are read into
+///memory in one go, otherwise they are streamed in buffers.
+void HyperBinningMakerOutOfCore::setMemoryBudget(double megabytes){
+  _memoryBudget = megabytes*1024.0*1024.0;
+}
+
+///Get the scratch file that holds the points of a volume
+///
+TString HyperBinningMakerOutOfCore::getScratchFilename(int volumeNumber) const{
+  TString name = _scratchDir;
+  name += "/";
+  name += _scratchPrefix;
+  name += "_";
+  name += volumeNumber;
+  name += ".bin";
+  return name;
+}
+
+///Number of points in each read / write buffer. There is one
+///read buffer and two write buffers open at any time, so they
+///use at most 3/8 of the memory budget.
+int HyperBinningMakerOutOfCore::getBufferSize() const{
+  double size = _memoryBudget/(8.0*sizeof(double)*_recordSize);
+  if (size < 1024.0    ) return 1024;
+  if (size > 100000000.0) return 100000000;
+  return int(size);
+}
+
+///Check if the dimension is in the list of binning dimensions
+///
+bool HyperBinningMakerOutOfCore::isValidBinningDimension(int dimension) const{
+  for (unsigned i = 0; i < _binningDimensions.size(); i++){
+    if (_binningDimensions.at(i) == dimension) return true;
+  }
+  return false;
+}
+
+///Weight of a point as stored in the bin contents
+///
+double HyperBinningMakerOutOfCore::getWeight(const double* point) const{
+  if (_numWeights == 0) return 1.0;
+  return point[_dimension];
+}
+
+///Weight of a point as used by the split criteria - if
+///_useEventWeights isn't true, this is just 1.0
+double HyperBinningMakerOutOfCore::getSplitWeight(const double* point) const{
+  if (_useEventWeights == true) return getWeight(point);
+  return 1.0;
+}
+
+///The status a new volume starts with. Same as the HyperBinningMaker - if the
+///content is less than double the minimum, or it is too narrow to split in
+///every binning dimension, it is DONE.
+int HyperBinningMakerOutOfCore::getInitialStatus(const HyperCuboid& cuboid, double sumW) const{
+
+  if (sumW < 2.0*_minimumBinContent) return DONE;
+
+  for (int i = 0; i < _dimension; i++){
+    double width = cuboid.getHighCorner().at(i) - cuboid.getLowCorner().at(i);
+    if ( width >= _minimumEdgeLength.at(i)*2.0 && isValidBinningDimension(i) ) return CONTINUE;
+  }
+
+  return DONE;
+}
+
+///Add a new volume, and return its volume number
+///
+int HyperBinningMakerOutOfCore::addVolume(const HyperCuboid& cuboid, double sumW, double content, double sumW2, Long64_t nPoints, int status){
+
+  _hyperCuboids.push_back(cuboid);
+  _linkedBins  .push_back(std::vector<int>(0,0));
+  _status      .push_back(status);
+  _sumW        .push_back(sumW);
+  _content     .push_back(content);
+  _contentSumW2.push_back(sumW2);
+  _numPoints   .push_back(nPoints);
+
+  _numBins++;
+  return _numHyperVolumes++;
+}
+
+///Write a buffer of points to a scratch file, then empty it. If the
+///file is 0 the points are just discarded.
+void HyperBinningMakerOutOfCore::writeBuffer(std::vector<double>& buffer, std::ofstream* out){
+
+  if (out != 0 && buffer.size() != 0){
+    out->write( reinterpret_cast<const char*>(&buffer.at(0)), buffer.size()*sizeof(double) );
+    _bytesWritten += buffer.size()*sizeof(double);
+  }
+
+  buffer.clear();
+}
+
+///Read the next buffer of points from a scratch file. Returns the
+///number of points read, which is zero at the end of the file.
+Long64_t HyperBinningMakerOutOfCore::readScratchBuffer(std::ifstream& in, std::vector<double>& buffer){
+
+  buffer.resize( Long64_t(getBufferSize())*_recordSize );
+
+  in.read( reinterpret_cast<char*>(&buffer.at(0)), buffer.size()*sizeof(double) );
+
+  Long64_t nBytes = in.gcount();
+  _bytesRead += nBytes;
+
+  return nBytes/(sizeof(double)*_recordSize);
+}
+
+///Read the whole scratch file of a volume into memory
+///
+bool HyperBinningMakerOutOfCore::readScratchFile(int volumeNumber, std::vector<double>& points){
+
+  Long64_t nPoints = _numPoints.at( getIndex(volumeNumber) );
+
+  points.resize( nPoints*_recordSize );
+  if (nPoints == 0) return true;
+
+  std::ifstream in(getScratchFilename(volumeNumber).Data(), std::ios::in | std::ios::binary);
+
+  if (!in){
+    ERROR_LOG << "HyperBinningMakerOutOfCore::readScratchFile - cannot open " << getScratchFilename(volumeNumber) << std::endl;
+    return false;
+  }
+
+  in.read( reinterpret_cast<char*>(&points.at(0)), points.size()*sizeof(double) );
+  _bytesRead += in.gcount();
+
+  if ( Long64_t(in.gcount()) != Long64_t(points.size()*sizeof(double)) ){
+    ERROR_LOG << "HyperBinningMakerOutOfCore::readScratchFile - " << getScratchFilename(volumeNumber) << " is truncated" << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+///Read all the points from the source, and write those inside the binning
+///range to the scratch file of the first volume.
+void HyperBinningMakerOutOfCore::writeInitialScratchFile(HyperPointSetChunkSource& source){
+
+  int bufferSize = getBufferSize();
+
+  HyperPointSetColumns chunk(_dimension, _numWeights);
+  std::vector<double> buffer;
+  buffer.reserve( Long64_t(bufferSize)*_recordSize );
+
+  std::ofstream out(getScratchFilename(0).Data(), std::ios::out | std::ios::binary);
+
+  const HyperPoint& low  = _binningRange.getLowCorner ();
+  const HyperPoint& high = _binningRange.getHighCorner();
+
+  double   sumW    = 0.0;
+  double   content = 0.0;
+  double   sumW2   = 0.0;
+  Long64_t nPoints = 0;
+  Long64_t nRead   = 0;
+
+  int n = 0;
+  while ( (n = source.readChunk(chunk, bufferSize)) > 0 ){
+
+    nRead += n;
+
+    for (int i = 0; i < n; i++){
+
+      bool inRange = true;
+      for (int d = 0; d < _dimension; d++){
+        double x = chunk.value(i, d);
+        if ( x <= low.at(d) || x > high.at(d) ) { inRange = false; break; }
+      }
+      if (inRange == false) continue;
+
+      unsigned start = buffer.size();
+      for (int d = 0; d < _dimension ; d++) buffer.push_back( chunk.value (i, d) );
+      for (int w = 0; w < _numWeights; w++) buffer.push_back( chunk.weight(i, w) );
+
+      const double* point = &buffer.at(start);
+      double weight = getWeight(point);
+      sumW    += getSplitWeight(point);
+      content += weight;
+      sumW2   += weight*weight;
+      nPoints++;
+
+      if ( buffer.size() >= buffer.capacity() ) writeBuffer(buffer, &out);
+    }
+
+  }
+
+  writeBuffer(buffer, &out);
+  out.close();
+
+  INFO_LOG << "Before filtering there are " << nRead << " events" << std::endl;
+  INFO_LOG << "After filtering there are " << nPoints << " events" << std::endl;
+
+  addVolume(_binningRange, sumW, content, sumW2, nPoints, CONTINUE);
+
+}
+
+///Histogram the points in a volume according to where they fall
+///relative to a sorted list of split coordinates. Entry j gets the
+///points with splitCoords[j-1] < x <= splitCoords[j], and the last
+///entry gets everything above the last split coordinate.
+void HyperBinningMakerOutOfCore::fillSplitHistogram(const double* points, Long64_t nPoints, int dimension,
+    const std::vector<double>& splitCoords, std::vector<double>& sumW,
+    std::vector<double>& content, std::vector<double>& sumW2, std::vector<Long64_t>& numPoints) const{
+
+  for (Long64_t i = 0; i < nPoints; i++){
+    const double* point = points + i*_recordSize;
+
+    int bin = std::lower_bound(splitCoords.begin(), splitCoords.end(), point[dimension]) - splitCoords.begin();
+
+    double weight = getWeight(point);
+    sumW     .at(bin) += getSplitWeight(point);
+    content  .at(bin) += weight;
+    sumW2    .at(bin) += weight*weight;
+    numPoints.at(bin) += 1;
+  }
+
+}
+
+///Send each point to the scratch file of the lower (x <= splitCoord) or
+///upper new volume. A 0 file means that volume doesn't need its points.
+void HyperBinningMakerOutOfCore::partitionPoints(const double* points, Long64_t nPoints, int dimension, double splitCoord,
+    std::vector<double>& buffer1, std::vector<double>& buffer2, std::ofstream* out1, std::ofstream* out2){
+
+  Long64_t bufferSize = Long64_t(getBufferSize())*_recordSize;
+
+  for (Long64_t i = 0; i < nPoints; i++){
+    const double* point = points + i*_recordSize;
+
+    bool below = point[dimension] <= splitCoord;
+
+    std::ofstream*       out    = below ? out1     : out2;
+    std::vector<double>& buffer = below ? buffer1  : buffer2;
+
+    if (out == 0) continue;
+
+    buffer.insert(buffer.end(), point, point + _recordSize);
+    if ( Long64_t(buffer.size()) >= bufferSize ) writeBuffer(buffer, out);
+  }
+
+}
+
+/**
+  Split a volume in the given dimension. This makes exactly the same
+  decision as HyperBinningMaker::split (MINT) or
+  HyperBinningMaker::smartSplit (SMART), but from at most two
+  sequential reads of the scratch file.
+
+  The SMART split point is found by bisection (starting at 0.5 and
+  halving the step until it is below 0.001), so it is always a
+  multiple of 1/512. The number of events below each of these 513
+  candidates is found in a single pass, and the bisection is then
+  done on these counts.
+*/
+int HyperBinningMakerOutOfCore::split(int volumeNumber, int dimension){
+
+  if (isValidBinningDimension(dimension) == false) return 0;
+
+  int index = getIndex(volumeNumber);
+
+  HyperCuboid cuboid = _hyperCuboids.at(index);
+  double low  = cuboid.getLowCorner ().at(dimension);
+  double high = cuboid.getHighCorner().at(dimension);
+  double minEdgeLength = _minimumEdgeLength.at(dimension);
+
+  int nCandidates = (_alg == HyperBinningAlgorithms::MINT) ? 1 : 513;
+
+  std::vector<double> splitCoords(nCandidates);
+  for (int j = 0; j < nCandidates; j++){
+    double splitPoint = (nCandidates == 1) ? 0.5 : double(j)/512.0;
+    splitCoords.at(j) = low + (high - low)*splitPoint;
+  }
+
+  //For MINT the split point is known already, so check the
+  //edge lengths before reading anything
+  if (nCandidates == 1){
+    if (splitCoords.at(0) - low < minEdgeLength || high - splitCoords.at(0) < minEdgeLength){
+      VERBOSE_LOG << "Tired to split bin but one of the resulting bins is too small... hopefully spliting in another dim will help."<<std::endl;
+      return 0;
+    }
+  }
+
+  //If the points fit in memory, only read the scratch file once
+
+  Long64_t nPoints = _numPoints.at(index);
+  bool inMemory = double(nPoints)*_recordSize*sizeof(double) <= 0.5*_memoryBudget;
+
+  std::vector<double> points;
+  std::vector<double> buffer;
+  std::ifstream in;
+
+  if (inMemory){
+    if ( readScratchFile(volumeNumber, points) == false ) return 0;
+  }
+  else{
+    in.open(getScratchFilename(volumeNumber).Data(), std::ios::in | std::ios::binary);
+    if (!in){
+      ERROR_LOG << "HyperBinningMakerOutOfCore::split - cannot open " << getScratchFilename(volumeNumber) << std::endl;
+      return 0;
+    }
+  }
+
+  //First pass - count the events below each candidate split point
+
+  std::vector<double>   sumWBelow    (nCandidates + 1, 0.0);
+  std::vector<double>   contentBelow (nCandidates + 1, 0.0);
+  std::vector<double>   sumW2Below   (nCandidates + 1, 0.0);
+  std::vector<Long64_t> nPointsBelow (nCandidates + 1, 0  );
+
+  if (inMemory){
+    if (nPoints != 0) fillSplitHistogram(&points.at(0), nPoints, dimension, splitCoords, sumWBelow, contentBelow, sumW2Below, nPointsBelow);
+  }
+  else{
+    Long64_t n = 0;
+    while ( (n = readScratchBuffer(in, buffer)) > 0 ){
+      fillSplitHistogram(&buffer.at(0), n, dimension, splitCoords, sumWBelow, contentBelow, sumW2Below, nPointsBelow);
+    }
+  }
+
+  for (int j = 1; j < nCandidates; j++){
+    sumWBelow   .at(j) += sumWBelow   .at(j - 1);
+    contentBelow.at(j) += contentBelow.at(j - 1);
+    sumW2Below  .at(j) += sumW2Below  .at(j - 1);
+    nPointsBelow.at(j) += nPointsBelow.at(j - 1);
+  }
+
+  //Choose the split point
+
+  int chosen = 0;
+
+  if (nCandidates != 1){
+    double splitPoint = 0.5;
+    double shift      = 0.25;
+
+    double dataBefore = _sumW.at(index);
+
+    while (shift > 0.001){
+      double dataNow  = sumWBelow.at( int(splitPoint*512.0 + 0.5) );
+      double dataFrac = dataNow/dataBefore;
+
+      if (dataFrac < 0.5) splitPoint += shift;
+      else if (dataFrac > 0.5) splitPoint -= shift;
+      else break;
+
+      shift = shift*0.5;
+    }
+
+    chosen = int(splitPoint*512.0 + 0.5);
+  }
+
+  double splitCoord = splitCoords.at(chosen);
+
+  if (splitCoord - low < minEdgeLength || high - splitCoord < minEdgeLength){
+    VERBOSE_LOG << "Tired to split bin but one of the resulting bins is too small... hopefully spliting in another dim will help."<<std::endl;
+    return 0;
+  }
+
+  double evts1 = sumWBelow.at(chosen);
+  double evts2 = _sumW.at(index) - evts1;
+
+  if ( evts1 < _minimumBinContent || evts2 < _minimumBinContent){
+    VERBOSE_LOG << "Tired to split bin but one half has too little events... hopefully spliting in another dim will help."<<std::endl;
+    return 0;
+  }
+
+  //Add the new volumes
+
+  HyperCuboid cuboid1(cuboid);
+  HyperCuboid cuboid2(cuboid);
+  cuboid1.getHighCorner().at(dimension) = splitCoord;
+  cuboid2.getLowCorner ().at(dimension) = splitCoord;
+
+  int status1 = getInitialStatus(cuboid1, evts1);
+  int status2 = getInitialStatus(cuboid2, evts2);
+
+  int newVolumeNum1 = addVolume(cuboid1, evts1, contentBelow.at(chosen), sumW2Below.at(chosen),
+                                nPointsBelow.at(chosen), status1);
+  int newVolumeNum2 = addVolume(cuboid2, evts2, _content.at(index) - contentBelow.at(chosen), _contentSumW2.at(index) - sumW2Below.at(chosen),
+                                nPoints - nPointsBelow.at(chosen), status2);
+
+  //Second pass - partition the points. Volumes that are DONE
+  //will never be split again, so their points are not needed.
+
+  std::ofstream* out1 = 0;
+  std::ofstream* out2 = 0;
+  if (status1 == CONTINUE) out1 = new std::ofstream(getScratchFilename(newVolumeNum1).Data(), std::ios::out | std::ios::binary);
+  if (status2 == CONTINUE) out2 = new std::ofstream(getScratchFilename(newVolumeNum2).Data(), std::ios::out | std::ios::binary);
+
+  if (out1 != 0 || out2 != 0){
+
+    std::vector<double> buffer1;
+    std::vector<double> buffer2;
+
+    if (inMemory){
+      if (nPoints != 0) partitionPoints(&points.at(0), nPoints, dimension, splitCoord, buffer1, buffer2, out1, out2);
+    }
+    else{
+      in.clear();
+      in.seekg(0, std::ios::beg);
+      Long64_t n = 0;
+      while ( (n = readScratchBuffer(in, buffer)) > 0 ){
+        partitionPoints(&buffer.at(0), n, dimension, splitCoord, buffer1, buffer2, out1, out2);
+      }
+    }
+
+    writeBuffer(buffer1, out1);
+    writeBuffer(buffer2, out2);
+  }
+
+  delete out1;
+  delete out2;
+
+  //Link the old volume to the new ones, and remove its points
+
+  in.close();
+  std::remove( getScratchFilename(volumeNumber).Data() );
+
+  _linkedBins.at(index).push_back(newVolumeNum1);
+  _linkedBins.at(index).push_back(newVolumeNum2);
+  _status    .at(index) = DONE;
+  _numPoints .at(index) = 0;
+  _numBins--;
+
+  return 1;
+}
+
+///Split every volume in the frontier. The frontier is then
+///made up of the volumes that couldn't be split, followed by the
+///new volumes that have the CONTINUE status - it therefore stays
+///in volume order, so volumes are split in the same order as the
+///HyperBinningMaker (which loops over all volumes).
+int HyperBinningMakerOutOfCore::splitAll(int dimension){
+
+  std::vector<int> frontier;
+  std::vector<int> newVolumes;
+  frontier.swap(_frontier);
+
+  int nSplits = 0;
+
+  for (unsigned i = 0; i < frontier.size(); i++){
+    int volumeNumber = frontier.at(i);
+
+    if ( split(volumeNumber, dimension) == 0 ){
+      _frontier.push_back(volumeNumber);
+      continue;
+    }
+
+    nSplits++;
+
+    const std::vector<int>& links = _linkedBins.at( getIndex(volumeNumber) );
+    for (unsigned j = 0; j < links.size(); j++){
+      if ( _status.at( getIndex(links.at(j)) ) == CONTINUE ) newVolumes.push_back( links.at(j) );
+    }
+  }
+
+  _frontier.insert(_frontier.end(), newVolumes.begin(), newVolumes.end());
+
+  writeFinishedVolumes();
+
+  return nSplits;
+}
+
+///Write volumes to the target binning (in volume order) until one
+///is found that might still be split. If 'all' is true, everything
+///is written and any remaining scratch files are removed.
+void HyperBinningMakerOutOfCore::writeFinishedVolumes(bool all){
+
+  while (_hyperCuboids.empty() == false){
+
+    bool isBin    = _linkedBins.front().size() == 0;
+    bool finished = isBin == false || _status.front() == DONE;
+
+    if (finished == false && all == false) break;
+
+    if (isBin){
+      _binContents.push_back( _content     .front() );
+      _binSumW2   .push_back( _contentSumW2.front() );
+    }
+
+    if (isBin && _status.front() == CONTINUE) std::remove( getScratchFilename(_firstVolume).Data() );
+
+    _target->addHyperVolume( HyperVolume(_hyperCuboids.front()), _linkedBins.front() );
+
+    _hyperCuboids.pop_front();
+    _linkedBins  .pop_front();
+    _status      .pop_front();
+    _sumW        .pop_front();
+    _content     .pop_front();
+    _contentSumW2.pop_front();
+    _numPoints   .pop_front();
+    _firstVolume++;
+  }
+
+}
+
+///Save the bin contents to the target file, in the same
+///format as HyperHistogram, so the file can be opened as
+///a HyperHistogram.
+void HyperBinningMakerOutOfCore::writeBinContents(TString targetFilename){
+
+  TFile* file = new TFile(targetFilename, "update");
+
+  if (file == 0 || file->IsZombie()){
+    ERROR_LOG << "HyperBinningMakerOutOfCore::writeBinContents - cannot open " << targetFilename << std::endl;
+    return;
+  }
+
+  HistogramBase histogram( _binContents.size() );
+
+  for (unsigned i = 0; i < _binContents.size(); i++){
+    histogram.setBinContent(i, _binContents.at(i)         );
+    histogram.setBinError  (i, sqrt( _binSumW2.at(i) )    );
+  }
+
+  histogram.saveBase();
+
+  file->Close();
+  delete file;
+
+}
+
+///Make the binning from points provided by a HyperPointSetChunkSource,
+///and save it (along with the bin contents) to targetFilename.
+bool HyperBinningMakerOutOfCore::makeBinning(HyperPointSetChunkSource& source, TString targetFilename){
+
+  if (source.getDimension() != _binningRange.getDimension()){
+    ERROR_LOG << "HyperBinningMakerOutOfCore::makeBinning - the points have a different dimensionality to the binning range" << std::endl;
+    return false;
+  }
+
+  if (_binningDimensions.size() == 0){
+    ERROR_LOG << "HyperBinningMakerOutOfCore::makeBinning - there are no binning dimensions" << std::endl;
+    return false;
+  }
+
+  _dimension  = source.getDimension();
+  _numWeights = source.getNumWeights();
+  _recordSize = _dimension + _numWeights;
+
+  _hyperCuboids.clear();
+  _linkedBins  .clear();
+  _status      .clear();
+  _sumW        .clear();
+  _content     .clear();
+  _contentSumW2.clear();
+  _numPoints   .clear();
+  _frontier    .clear();
+  _binContents .clear();
+  _binSumW2    .clear();
+  _firstVolume     = 0;
+  _numHyperVolumes = 0;
+  _numBins         = 0;
+  _bytesRead       = 0.0;
+  _bytesWritten    = 0.0;
+
+  _target = new HyperBinningDiskRes();
+  _target->load(targetFilename, "RECREATE");
+  _target->addPrimaryVolumeNumber(0);
+
+  writeInitialScratchFile(source);
+  _frontier.push_back(0);
+
+  //Same loop as HyperBinningMakerMint::makeBinning and
+  //HyperBinningMakerSmart::makeBinning
+
+  int dimension = _binningDimensions.size();
+  int maxUnchanged = (_alg == HyperBinningAlgorithms::MINT) ? dimension : dimension + 1;
+
+  int splitDim = _startingDim;
+  if (splitDim >= dimension) splitDim = 0;
+
+  int nBins = 0;
+  int unchanged = 0;
+
+  INFO_LOG << "Splitting all bins in dimension " << _binningDimensions.at(splitDim) << std::endl;
+
+  while ( splitAll(_binningDimensions.at(splitDim)) != 0 ){
+    if (nBins == getNumBins()) unchanged++;
+    else unchanged = 0;
+    if (unchanged >= maxUnchanged) break;
+    nBins = getNumBins();
+    INFO_LOG << "There is now a total of " << nBins << " bins (" << _frontier.size() << " can still be split)" << std::endl;
+    splitDim++;
+    if( splitDim == dimension ) splitDim = 0;
+    INFO_LOG << "Trying to split all bins in dimension " << _binningDimensions.at(splitDim) << std::endl;
+  }
+
+  writeFinishedVolumes(true);
+  _frontier.clear();
+
+  //the destructor writes the trees and closes the file
+  delete _target;
+  _target = 0;
+
+  writeBinContents(targetFilename);
+
+  INFO_LOG << "Out-of-core binning algorithm complete - " << getNumBins() << " bins, " << getNumHyperVolumes() << " HyperVolumes" << std::endl;
+  INFO_LOG << "Scratch file I/O: " << _bytesRead/(1024.0*1024.0) << " MB read, " << _bytesWritten/(1024.0*1024.0) << " MB written" << std::endl;
+
+  return true;
+}
+
+///Make the binning from a HyperPointSet file (either format,
+///see HyperPointSetReader) and save it to targetFilename.
+bool HyperBinningMakerOutOfCore::makeBinning(TString dataFilename, TString targetFilename){
+
+  HyperPointSetReader reader(dataFilename);
+
+  if (reader.isOpen() == false){
+    ERROR_LOG << "HyperBinningMakerOutOfCore::makeBinning - cannot read points from " << dataFilename << std::endl;
+    return false;
+  }
+
+  return makeBinning(reader, targetFilename);
+}
+
+///Destructor
+///
+HyperBinningMakerOutOfCore::~HyperBinningMakerOutOfCore(){
+  if (_target != 0) delete _target;
+  GOODBYE_LOG << "Goodbye from the HyperBinningMakerOutOfCore() Destructor";
+}
+
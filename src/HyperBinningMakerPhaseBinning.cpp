@@ -13,7 +13,8 @@ HyperBinningMakerPhaseBinning::HyperBinningMakerPhaseBinning(const HyperCuboid&
   _numWalkers      (5),
   _walkSizeFrac  (0.12),
   _numberOfSystematicSplits(0),
-  _numberOfGradientSplits  (0)
+  _numberOfGradientSplits  (0),
+  _funcCache(func, binningRange)
 {
   setNumBinPairs(3);
   setHyperFunction(func);
@@ -51,22 +52,38 @@ void HyperBinningMakerPhaseBinning::makeBinning(){
   }
 
   if (s_printBinning == true) INFO_LOG << "Mint binning algorithm complete " <<std::endl;
+  if (s_printBinning == true) _funcCache.printStatistics();
 
 } 
 
+///Get the function value at a point. Values are cached, so
+///points shared between HyperVolumes are only evaluated once.
+double HyperBinningMakerPhaseBinning::getFuncVal(const HyperPoint& point){
+  _funcCache.setFunction(_func);
+  return _funcCache.getVal(point);
+}
+
+///Get the function values at a set of points. Values are cached, so
+///points shared between HyperVolumes are only evaluated once.
+std::vector<double> HyperBinningMakerPhaseBinning::getFuncVals(const HyperPointSet& points){
+  _funcCache.setFunction(_func);
+  return _funcCache.getVals(points);
+}
+
 
 int HyperBinningMakerPhaseBinning::gradientSplitAll(){
   
   VERBOSE_LOG <<  "HyperBinningMakerPhaseBinning::gradientSplitAll( )" << std::endl;
 
-  int initialSize = _hyperCuboids.size();
+  std::vector<int> frontier = getFrontier();
   int nSplits = 0;
 
   int splittable = getNumContinueBins();
   LoadingBar loadingbar(splittable);
   int splittableDone = 0;
 
-  for (int i = 0; i < initialSize; i++){
+  for (unsigned j = 0; j < frontier.size(); j++){
+    int i = frontier.at(j);
     if (getGlobalVolumeStatus(i) == VolumeStatus::CONTINUE) {
            
       loadingbar.update(splittableDone);
@@ -196,7 +213,7 @@ double HyperBinningMakerPhaseBinning::closestBinBoundary(double val){
 
 int HyperBinningMakerPhaseBinning::getBinNumFromFunc(HyperPoint& point) {
   
-  return getBinNumFromFuncVal(_func->getVal(point));
+  return getBinNumFromFuncVal(getFuncVal(point));
   
 }
 
@@ -207,6 +224,10 @@ HyperPoint HyperBinningMakerPhaseBinning::getGrad(HyperPoint& point){
   
   HyperPoint grad(nDims, 0.0);
 
+  //get all the function values in one go
+
+  HyperPointSet steps(nDims);
+
   for (int i = 0; i < nBinningDims; i++){
     int dim = _binningDimensions.at(i);
     double stepsize = _minimumEdgeLength.at(dim)*0.5;
@@ -215,9 +236,19 @@ HyperPoint HyperBinningMakerPhaseBinning::getGrad(HyperPoint& point){
     HyperPoint high(point);
     low .at(i) -= stepsize;
     high.at(i) += stepsize;
+
+    steps.push_back(low );
+    steps.push_back(high);
+  }
+
+  std::vector<double> vals = getFuncVals(steps);
+
+  for (int i = 0; i < nBinningDims; i++){
+    int dim = _binningDimensions.at(i);
+    double stepsize = _minimumEdgeLength.at(dim)*0.5;
     
-    double valLow  = _func->getVal(low );
-    double valHigh = _func->getVal(high);
+    double valLow  = vals.at(2*i    );
+    double valHigh = vals.at(2*i + 1);
     
     std::complex<double> compLow (cos(valLow ), sin(valLow ));
     std::complex<double> compHigh(cos(valHigh), sin(valHigh));
@@ -234,14 +265,27 @@ HyperPoint HyperBinningMakerPhaseBinning::getGradPos(HyperPoint& point, double f
   
   HyperPoint grad(nDims, 0.0);
 
+  //get all the function values in one go
+
+  HyperPointSet steps(nDims);
+
   for (int i = 0; i < nBinningDims; i++){
     int dim = _binningDimensions.at(i);
     double stepsize = _minimumEdgeLength.at(dim)*0.5;
     
     HyperPoint high(point);
     high.at(i) += stepsize;
+
+    steps.push_back(high);
+  }
+
+  std::vector<double> vals = getFuncVals(steps);
+
+  for (int i = 0; i < nBinningDims; i++){
+    int dim = _binningDimensions.at(i);
+    double stepsize = _minimumEdgeLength.at(dim)*0.5;
     
-    double valHigh = _func->getVal(high);
+    double valHigh = vals.at(i);
     
     std::complex<double> compVal (cos(funcValAtPoint ), sin(funcValAtPoint ));
     std::complex<double> compHigh(cos(valHigh), sin(valHigh));
@@ -265,9 +309,11 @@ double HyperBinningMakerPhaseBinning::getSecondDerivative(HyperPoint& point, Hyp
     HyperPoint low  = point - normVector*stepLength; 
     HyperPoint high = point + normVector*stepLength; 
   
+    std::vector<double> vals = getFuncVals( HyperPointSet(low, high) );
+
     double val     = funcValAtPoint;
-    double lowVal  = _func->getVal(low  );
-    double highVal = _func->getVal(high );
+    double lowVal  = vals.at(0);
+    double highVal = vals.at(1);
   
     double h = (high - low).norm()*0.5;
     
@@ -279,9 +325,12 @@ double HyperBinningMakerPhaseBinning::getSecondDerivative(HyperPoint& point, Hyp
   HyperPoint high1 = point + normVector*stepLength; 
   HyperPoint high2 = point + normVector*stepLength*2.0; 
   
-  double val      = _func->getVal(point  );
-  double high1Val = _func->getVal(high1  );
-  double high2Val = _func->getVal(high2  );
+  HyperPointSet steps(point, high1, high2);
+  std::vector<double> vals = getFuncVals(steps);
+
+  double val      = vals.at(0);
+  double high1Val = vals.at(1);
+  double high2Val = vals.at(2);
   
   double h = (high1 - high2).norm();
     
@@ -580,8 +629,16 @@ HyperPoint HyperBinningMakerPhaseBinning::orderAndTestSplitPoints(HyperPointSet&
   //Each time we evaluate the function at a corner, we can see how good
   //our predictions are, and set an error.
 
+  //The vertices are evaluated in blocks of one per thread of the
+  //function, so the loop rarely evaluates a vertex it doesn't reach
+  //(and never does with a single thread).
+
   double uncertaintySum = 0.0;
   int uncertainiesAdded = 0;
+
+  int blockSize = _func->getNumThreads() < 1 ? 1 : _func->getNumThreads();
+  std::vector<double> vertexVals;
+  HyperPointSet block(points.getDimension());
     
   for (unsigned i = 0; i < points.size(); i++){
 
@@ -600,7 +657,14 @@ HyperPoint HyperBinningMakerPhaseBinning::orderAndTestSplitPoints(HyperPointSet&
       //std::cout << "Breaking loop at " << i << "; fom est = " <<  fom << " ± " << estimateUncert << std::endl;
       break; 
     }
-    double valHere = _func->getVal(points.at(vtxNum));
+    if (i == vertexVals.size()){
+      block.clear();
+      for (unsigned j = i; j < points.size() && j < i + blockSize; j++) block.push_back( points.at(index.at(j)) );
+      std::vector<double> blockVals = getFuncVals(block);
+      vertexVals.insert(vertexVals.end(), blockVals.begin(), blockVals.end());
+    }
+
+    double valHere = vertexVals.at(i);
     int binHere    = getBinNumFromFuncVal(valHere);
     
     std::complex<double> cEst(cos(estimate), sin(estimate));
@@ -715,7 +779,7 @@ int HyperBinningMakerPhaseBinning::gradientSplit(int volumeNumber, int& dimensio
   //'bin number' from this. Also find out which bin boundary
   //is closest to us. 
 
-  double valCenter    = _func->getVal(binCenter);
+  double valCenter    = getFuncVal(binCenter);
   int    binNumber    = getBinNumFromFuncVal(valCenter);
   double closestBound = closestBinBoundary(valCenter);
   
@@ -861,7 +925,7 @@ int HyperBinningMakerPhaseBinning::gradientSplit(int volumeNumber, int& dimensio
   }
 
   //See what the function and the bin number is at the new point
-  double valNew    = _func->getVal(refinedSplitPointExtended);
+  double valNew    = getFuncVal(refinedSplitPointExtended);
   int    binNew    = getBinNumFromFuncVal(valNew);    
  
   //As a cross check we can see how the extrapolation agrees with the real value.
@@ -870,8 +934,8 @@ int HyperBinningMakerPhaseBinning::gradientSplit(int volumeNumber, int& dimensio
   
   if (crossCheck3 == true){
 
-    double valReal     = _func->getVal(       splitPoint);
-    double valRealRef  = _func->getVal(refinedSplitPoint);
+    double valReal     = getFuncVal(       splitPoint);
+    double valRealRef  = getFuncVal(refinedSplitPoint);
     double valExtrap   = closestBound;
 
     std::complex<double> cValReal   (cos(valReal)   ,  sin(valReal)  );
@@ -2,7 +2,9 @@
 
 
 ///The only constructor
-HyperBinningMemRes::HyperBinningMemRes() 
+HyperBinningMemRes::HyperBinningMemRes() :
+  _cuboidOffsets(1, 0),
+  _linkOffsets  (1, 0)
 {
   WELCOME_LOG << "Hello from the HyperBinningMemRes() Constructor";
 }
@@ -21,9 +23,22 @@ void HyperBinningMemRes::setDimension(int dim){
 }
 
 
+///Get the volume numbers linked to a HyperVolume
+///
 std::vector<int> HyperBinningMemRes::getLinkedHyperVolumes( int volumeNumber ) const{
 
-  return _linkedHyperVolumes.at(volumeNumber);
+  int first = _linkOffsets.at(volumeNumber    );
+  int last  = _linkOffsets.at(volumeNumber + 1);
+
+  return std::vector<int>(_linkedHyperVolumes.begin() + first, _linkedHyperVolumes.begin() + last);
+
+}
+
+///Get the number of volumes linked to a HyperVolume (without
+///copying them)
+int HyperBinningMemRes::getNumLinkedHyperVolumes( int volumeNumber ) const{
+
+  return _linkOffsets.at(volumeNumber + 1) - _linkOffsets.at(volumeNumber);
 
 }
 
@@ -47,7 +62,7 @@ void HyperBinningMemRes::addPrimaryVolumeNumber(int volumeNumber){
 ///get the number of HyperVolumes
 ///
 int HyperBinningMemRes::getNumHyperVolumes() const{
-  return _hyperVolumes.size();
+  return _cuboidOffsets.size() - 1;
 }  
 
 
@@ -65,13 +80,17 @@ int HyperBinningMemRes::getPrimaryVolumeNumber(int i) const{
 bool HyperBinningMemRes::addHyperVolume(const HyperVolume& hyperVolume, std::vector<int> linkedVolumes){
   
   //If this is the first volume that has been added, use it to set the dimension
-  if (_hyperVolumes.size() == 0){
+  if (getNumHyperVolumes() == 0){
     setDimension( hyperVolume.getDimension() );
   }
 
   if (hyperVolume.getDimension() == getDimension()) {
-    _hyperVolumes.push_back(hyperVolume); 
-    _linkedHyperVolumes.push_back(linkedVolumes);
+    for (int i = 0; i < hyperVolume.size(); i++){
+      const HyperCuboid& cuboid = hyperVolume.at(i);
+      addCuboidCorners( &cuboid.getLowCorner().at(0), &cuboid.getHighCorner().at(0) );
+    }
+    _cuboidOffsets.push_back( _corners.size()/(2*getDimension()) );
+    addLinks(linkedVolumes);
     updateCash();
     return true;
   }
@@ -83,6 +102,20 @@ bool HyperBinningMemRes::addHyperVolume(const HyperVolume& hyperVolume, std::vec
 
 
 
+///Append the corners of one HyperCuboid to the arena. The
+///HyperVolume it belongs to is closed by pushing back
+///_cuboidOffsets.
+void HyperBinningMemRes::addCuboidCorners(const double* lowCorner, const double* highCorner){
+  _corners.insert(_corners.end(), lowCorner , lowCorner  + getDimension());
+  _corners.insert(_corners.end(), highCorner, highCorner + getDimension());
+}
+
+///Append the links of one HyperVolume
+///
+void HyperBinningMemRes::addLinks(const std::vector<int>& linkedVolumes){
+  _linkedHyperVolumes.insert(_linkedHyperVolumes.end(), linkedVolumes.begin(), linkedVolumes.end());
+  _linkOffsets.push_back( _linkedHyperVolumes.size() );
+}
 
 ///Save the list of Primary Volume Numbers to the open (and in scope) TFile.
 ///
@@ -124,8 +157,54 @@ void HyperBinningMemRes::setBranchAddresses(TTree* tree, int* binNumber, double*
 }
 
 
+///Get one of the HyperVolumes. This is built from the
+///stored corners each time it is called, so use isInHyperVolume
+///if you only want to know if a HyperPoint is inside it.
 HyperVolume HyperBinningMemRes::getHyperVolume(int volumeNumber) const{
-  return _hyperVolumes.at(volumeNumber);
+
+  int dim   = getDimension();
+  int first = _cuboidOffsets.at(volumeNumber    );
+  int last  = _cuboidOffsets.at(volumeNumber + 1);
+
+  HyperVolume volume(dim);
+
+  HyperPoint lowCorner (dim);
+  HyperPoint highCorner(dim);
+
+  for (int c = first; c < last; c++){
+    const double* corners = &_corners.at(2*dim*c);
+    for (int i = 0; i < dim; i++){
+      lowCorner .at(i) = corners[i];
+      highCorner.at(i) = corners[dim + i];
+    }
+    volume.addHyperCuboid(lowCorner, highCorner);
+  }
+
+  return volume;
+}
+
+///Is a HyperPoint inside one of the HyperVolumes. Tests the
+///stored corners directly, using the same convention as 
+///HyperCuboid::inVolume (low < x <= high).
+bool HyperBinningMemRes::isInHyperVolume(int volumeNumber, const HyperPoint& coords) const{
+
+  int dim   = getDimension();
+  int first = _cuboidOffsets.at(volumeNumber    );
+  int last  = _cuboidOffsets.at(volumeNumber + 1);
+
+  for (int c = first; c < last; c++){
+    const double* low  = &_corners[2*dim*c];
+    const double* high = low + dim;
+
+    bool inCuboid = true;
+    for (int i = 0; i < dim; i++){
+      double x = coords.at(i);
+      if ( (low[i] < x && x <= high[i]) == false ) { inCuboid = false; break; }
+    }
+    if (inCuboid) return true;
+  }
+
+  return false;
 }
 
 
@@ -154,6 +233,14 @@ void HyperBinningMemRes::load(TString filename, TString option){
 
   loadPrimaryVolumeNumbers(file);
 
+  //files saved using HyperBinning::saveCompact()
+  if (file->Get("HyperBinningCompact") != 0){
+    loadCompact(file, filename);
+    file->Close();
+    loadCache(filename);
+    return;
+  }
+
   TTree* tree = (TTree*)file->Get("HyperBinning");
 
   if (tree == 0){
@@ -164,88 +251,341 @@ void HyperBinningMemRes::load(TString filename, TString option){
   //Figure out how many dimensions there are from the tree
   setDimension( getHyperBinningDimFromTree(tree) );
 
-  //Create branch addresses and link them to TTree
+  file->Close();
+
+  int dim = getDimension();
+  if (dim == 0) return;
+
+  //Each entry in the TTree is one HyperCuboid, so the corner
+  //branches can be read straight into their place in _corners 
+  //(the low corner of each HyperCuboid is followed by the high
+  //corner). The branches are read in parallel.
+
+  BulkTreeReader reader(filename, "HyperBinning");
+
+  if (reader.isOpen() == false) return;
+
+  int nEntries    = reader.getNumEntries();
+  int firstCuboid = _corners.size()/(2*dim);
+
+  std::vector<int> binNumbers(nEntries, -1);
+
+  _corners.resize( _corners.size() + 2*dim*nEntries );
+
+  if (nEntries > 0){
+    double* corners = &_corners.at(2*dim*firstCuboid);
+
+    reader.addColumn("binNumber", &binNumbers.at(0));
+    for (int i = 0; i < dim; i++){
+      TString lowCornerName  = "lowCorner_" ; lowCornerName  += i;
+      TString highCornerName = "highCorner_"; highCornerName += i;
+      reader.addColumn(lowCornerName , corners       + i, 2*dim);
+      reader.addColumn(highCornerName, corners + dim + i, 2*dim);
+    }
+  }
+
+  if (reader.read() == false){
+    ERROR_LOG << "HyperBinningMemRes::load - failed to read " << filename << std::endl;
+    _corners.resize(2*dim*firstCuboid);
+    return;
+  }
+
+  //Consecutive entries with the same bin number belong to the
+  //same HyperVolume. The links are stored with every HyperCuboid, 
+  //so only read them for the first one in each HyperVolume.
+
+  std::vector<Long64_t> firstEntries;
+  firstEntries.reserve(nEntries);
+
+  for (int ent = 0; ent < nEntries; ent++){
+    if (ent != 0 && binNumbers[ent] == binNumbers[ent - 1]) continue;
+    if (ent != 0) _cuboidOffsets.push_back(firstCuboid + ent);
+    firstEntries.push_back(ent);
+  }
+
+  //close the final HyperVolume
+  if (nEntries > 0) _cuboidOffsets.push_back(firstCuboid + nEntries);
+
+  std::vector<int> links;
+  std::vector<int> linkOffsets;
+
+  if (reader.readVectorColumn("linkedBins", firstEntries, links, linkOffsets) == false){
+    ERROR_LOG << "HyperBinningMemRes::load - failed to read the linked volumes from " << filename << std::endl;
+    linkOffsets.assign(firstEntries.size() + 1, 0);
+  }
+
+  int firstLink = _linkedHyperVolumes.size();
+  _linkedHyperVolumes.insert(_linkedHyperVolumes.end(), links.begin(), links.end());
+  for (unsigned i = 1; i < linkOffsets.size(); i++){
+    _linkOffsets.push_back(firstLink + linkOffsets.at(i));
+  }
+  
+  VERBOSE_LOG << "Binning loaded";
+
+  updateCash();
+
+  //the limits and bin numbering, if they were saved
+  loadCache(filename);
+
+}
+
+///Load the HyperVolumes from a file saved using 
+///HyperBinning::saveCompact(). The HyperVolumes that were saved in 
+///full are read first, then the corners of every other HyperVolume
+///are found by following the splits down from these.
+void HyperBinningMemRes::loadCompact(TFile* file, TString filename){
+
+  TTree* compactTree  = (TTree*)file->Get("HyperBinningCompact"   );
+  TTree* flagTree     = (TTree*)file->Get("HyperBinningSplitFlags");
+  TTree* explicitTree = (TTree*)file->Get("HyperBinningExplicit"  );
+
+  if (compactTree == 0 || flagTree == 0 || explicitTree == 0){
+    ERROR_LOG << "Could not open TTrees in HyperBinningMemRes::loadCompact()";
+    return;
+  }
+
+  setDimension( getHyperBinningDimFromTree(explicitTree) );
+
+  int dim = getDimension();
+
+  if (dim == 0) return;
+
+  //Read the HyperVolumes that were saved in full. Every HyperVolume
+  //is either saved in full, or is one of the two made by a split.
+
+  std::vector<int>    explicitVolumes;   //volume number of each entry
+  std::vector<double> explicitCorners;
+  std::vector< std::vector<int> > explicitVolumeLinks;
+
   int binNumber = -1;
-  double* lowCorner  = new double [getDimension()];
-  double* highCorner = new double [getDimension()];  
+  double* lowCorner  = new double [dim];
+  double* highCorner = new double [dim];
   std::vector<int>* linkedBins = new std::vector<int>();
 
-  setBranchAddresses(tree, &binNumber, lowCorner, highCorner, &linkedBins);
-  
+  setBranchAddresses(explicitTree, &binNumber, lowCorner, highCorner, &linkedBins);
 
-  //Loop over the TTree and fill the HyperBinningMemRes
-  int nEntries = tree->GetEntries();
+  int nEntries = explicitTree->GetEntries();
+  explicitVolumes.reserve(nEntries);
+  explicitCorners.reserve(2*dim*nEntries);
 
-  int currentBinNumber = -1;
-  HyperVolume* currentHyperVolume = new HyperVolume(getDimension());
-  std::vector<int> currentLinkedVolumes;
+  int nExplicit = 0;
 
-  //_verbose = true;
+  for (int ent = 0; ent < nEntries; ent++){
+    explicitTree->GetEntry(ent);
 
-  for(int ent = 0; ent < nEntries; ent++){
-    tree->GetEntry(ent);
-    
-    //If the bin number hasn't changed, need to
-    //add HyperCube to previous HyperVolume
-    if(ent == 0 || currentBinNumber == binNumber){
-      currentBinNumber = binNumber;
-      currentLinkedVolumes = *linkedBins;
-      HyperPoint lowCornerVect (getDimension());
-      HyperPoint highCornerVect(getDimension());
-      for (int i = 0; i < getDimension(); i++){
-        lowCornerVect .at(i) = lowCorner [i];
-        highCornerVect.at(i) = highCorner[i];
+    //the HyperCuboids of one HyperVolume are saved consecutively
+    if (ent == 0 || binNumber != explicitVolumes.back()){
+      explicitVolumeLinks.push_back(*linkedBins);
+      nExplicit++;
+    }
+
+    explicitVolumes.push_back(binNumber);
+    explicitCorners.insert(explicitCorners.end(), lowCorner , lowCorner  + dim);
+    explicitCorners.insert(explicitCorners.end(), highCorner, highCorner + dim);
+  }
+
+  delete[] lowCorner;
+  delete[] highCorner;
+  delete linkedBins;
+
+  //Read the splits, and which HyperVolumes they belong to
+
+  int nSplits  = compactTree->GetEntries();
+  int nVolumes = nExplicit + 2*nSplits;
+
+  std::vector<Char_t> storedDims  (nSplits, -1 );
+  std::vector<double> storedValues(nSplits, 0.0);
+  std::vector<Char_t> splitFlags  (flagTree->GetEntries(), 0);
+
+  if (int(splitFlags.size()) != (nVolumes + 7)/8){
+    ERROR_LOG << "HyperBinningMemRes::loadCompact - the split flags don't match the number of HyperVolumes in " << filename << std::endl;
+    return;
+  }
+
+  if (nSplits > 0){
+    BulkTreeReader reader(filename, "HyperBinningCompact");
+    reader.addColumn("splitDim"  , &storedDims  .at(0));
+    reader.addColumn("splitValue", &storedValues.at(0));
+
+    BulkTreeReader flagReader(filename, "HyperBinningSplitFlags");
+    flagReader.addColumn("splitFlags", &splitFlags.at(0));
+
+    if (reader.read() == false || flagReader.read() == false){
+      ERROR_LOG << "HyperBinningMemRes::loadCompact - failed to read " << filename << std::endl;
+      return;
+    }
+  }
+
+  std::vector<int> explicitCuboids   (nVolumes, -1);   //first HyperCuboid of each explicit volume
+  std::vector<int> explicitNumCuboids(nVolumes, 0 );
+  std::vector<int> explicitLinkIndex (nVolumes, -1);   //index in explicitVolumeLinks
+
+  int linkIndex = -1;
+
+  for (int ent = 0; ent < nEntries; ent++){
+    int vol = explicitVolumes.at(ent);
+
+    if (vol < 0 || vol >= nVolumes){
+      ERROR_LOG << "HyperBinningMemRes::loadCompact - volume number " << vol << " is out of range" << std::endl;
+      return;
+    }
+
+    if (ent == 0 || vol != explicitVolumes.at(ent - 1)){
+      linkIndex++;
+
+      if (explicitNumCuboids.at(vol) != 0){
+        ERROR_LOG << "HyperBinningMemRes::loadCompact - volume " << vol << " is saved more than once" << std::endl;
+        return;
       }
-      VERBOSE_LOG << "Adding cuboid to volume";
-      currentHyperVolume->addHyperCuboid(lowCornerVect, highCornerVect);
+
+      explicitCuboids  .at(vol) = ent;
+      explicitLinkIndex.at(vol) = linkIndex;
+    }
+    explicitNumCuboids.at(vol)++;
+  }
+
+  //The k-th split made the (2k)-th and (2k+1)-th HyperVolumes that
+  //weren't saved in full
+
+  std::vector<int>    splitDims   (nVolumes, -1 );
+  std::vector<double> splitValues (nVolumes, 0.0);
+  std::vector<int>    lowChildren (nVolumes, -1 );
+  std::vector<int>    highChildren(nVolumes, -1 );
+
+  std::vector<int> derivedVolumes;
+  derivedVolumes.reserve(2*nSplits);
+
+  for (int vol = 0; vol < nVolumes; vol++){
+    if (explicitNumCuboids.at(vol) == 0) derivedVolumes.push_back(vol);
+  }
+
+  int split = 0;
+
+  for (int vol = 0; vol < nVolumes; vol++){
+    if ((splitFlags.at(vol/8) & (1 << (vol % 8))) == 0) continue;
+
+    if (split >= nSplits || derivedVolumes.at(2*split + 1) != derivedVolumes.at(2*split) + 1){
+      ERROR_LOG << "HyperBinningMemRes::loadCompact - the splits in " << filename << " are inconsistent" << std::endl;
+      return;
     }
 
-    //if the bin number has changed, need to add
-    //previous HyperVolume to HyperBinningMemRes
-    //and start a new HyperVolume
-    else {
-      VERBOSE_LOG << "Adding volume to binning";
-      this->addHyperVolume(*currentHyperVolume, currentLinkedVolumes);
-      delete currentHyperVolume;
-      currentHyperVolume = new HyperVolume(getDimension());
-      currentLinkedVolumes = *linkedBins;
-      currentBinNumber = binNumber;
-      HyperPoint lowCornerVect (getDimension());
-      HyperPoint highCornerVect(getDimension());
-      for (int i = 0; i < getDimension(); i++){
-        lowCornerVect .at(i) = lowCorner [i];
-        highCornerVect.at(i) = highCorner[i];
+    splitDims   .at(vol) = storedDims  .at(split);
+    splitValues .at(vol) = storedValues.at(split);
+    lowChildren .at(vol) = derivedVolumes.at(2*split    );
+    highChildren.at(vol) = derivedVolumes.at(2*split + 1);
+    split++;
+  }
+
+  if (split != nSplits){
+    ERROR_LOG << "HyperBinningMemRes::loadCompact - the splits in " << filename << " are inconsistent" << std::endl;
+    return;
+  }
+
+  //Find the corners of every other HyperVolume by splitting 
+  //its parent. These all have a single HyperCuboid.
+
+  std::vector<double> derivedCorners(2*dim*nVolumes, 0.0);
+  std::vector<bool>   known(nVolumes, false);
+  std::vector<int>    toSplit;
+
+  for (int vol = 0; vol < nVolumes; vol++){
+    if (explicitNumCuboids.at(vol) != 1) continue;
+    const double* corners = &explicitCorners.at(2*dim*explicitCuboids.at(vol));
+    std::copy(corners, corners + 2*dim, derivedCorners.begin() + 2*dim*vol);
+    known.at(vol) = true;
+    toSplit.push_back(vol);
+  }
+
+  while (toSplit.size() != 0){
+    
+    int parent = toSplit.back();
+    toSplit.pop_back();
+
+    int splitDimension = splitDims.at(parent);
+    if (splitDimension < 0) continue;
+
+    if (splitDimension >= dim){
+      ERROR_LOG << "HyperBinningMemRes::loadCompact - invalid split dimension " << splitDimension << std::endl;
+      continue;
+    }
+
+    int children[2] = {lowChildren.at(parent), highChildren.at(parent)};
+
+    for (int i = 0; i < 2; i++){
+      int child = children[i];
+
+      if (child < 0 || child >= nVolumes){
+        ERROR_LOG << "HyperBinningMemRes::loadCompact - volume number " << child << " is out of range" << std::endl;
+        continue;
       }
-      VERBOSE_LOG << "Adding cuboid to volume";
-      currentHyperVolume->addHyperCuboid(lowCornerVect, highCornerVect);
-      VERBOSE_LOG << "Adding linked volumes";
+
+      //HyperVolumes that were saved in full take priority
+      if (known.at(child) || explicitNumCuboids.at(child) != 0) continue;
+
+      std::copy(derivedCorners.begin() + 2*dim*parent, derivedCorners.begin() + 2*dim*(parent + 1), 
+                derivedCorners.begin() + 2*dim*child);
       
-    }
+      //the low child takes the high corner from the split,
+      //and the high child takes the low corner
+      if (i == 0) derivedCorners.at(2*dim*child + dim + splitDimension) = splitValues.at(parent);
+      else        derivedCorners.at(2*dim*child       + splitDimension) = splitValues.at(parent);
 
-    //if it's the final iteration, need to add the final HyperVolume
-    if (ent == nEntries - 1) {
-      this->addHyperVolume(*currentHyperVolume);
+      known.at(child) = true;
+      toSplit.push_back(child);
     }
   }
-  
-  VERBOSE_LOG << "Binning loaded";
 
-  //_verbose = false;
+  //Fill the HyperBinningMemRes
 
-  delete currentHyperVolume;
-  delete lowCorner;
-  delete highCorner;
-  delete linkedBins;
+  _corners           .reserve( _corners           .size() + derivedCorners.size() );
+  _cuboidOffsets     .reserve( _cuboidOffsets     .size() + nVolumes );
+  _linkOffsets       .reserve( _linkOffsets       .size() + nVolumes );
+  _linkedHyperVolumes.reserve( _linkedHyperVolumes.size() + 2*nVolumes );
 
-  updateCash();
+  std::vector<int> links;
 
-  file->Close();
+  for (int vol = 0; vol < nVolumes; vol++){
+
+    if (explicitNumCuboids.at(vol) != 0){
+      for (int c = 0; c < explicitNumCuboids.at(vol); c++){
+        const double* corners = &explicitCorners.at(2*dim*(explicitCuboids.at(vol) + c));
+        addCuboidCorners(corners, corners + dim);
+      }
+    }
+    else if (known.at(vol)){
+      const double* corners = &derivedCorners.at(2*dim*vol);
+      addCuboidCorners(corners, corners + dim);
+    }
+    else{
+      ERROR_LOG << "HyperBinningMemRes::loadCompact - could not find the corners of volume " << vol << std::endl;
+    }
+
+    _cuboidOffsets.push_back( _corners.size()/(2*dim) );
+
+    links.clear();
+    if (splitDims.at(vol) >= 0){
+      links.push_back( lowChildren .at(vol) );
+      links.push_back( highChildren.at(vol) );
+    }
+    else if (explicitLinkIndex.at(vol) >= 0){
+      links = explicitVolumeLinks.at( explicitLinkIndex.at(vol) );
+    }
+    addLinks(links);
+  }
+
+  VERBOSE_LOG << "Binning loaded";
+
+  updateCash();
 
 }
 
+///Reserve space for nElements HyperVolumes. Assumes that each
+///has one HyperCuboid and (roughly) one link.
 void HyperBinningMemRes::reserveCapacity(int nElements){
   HyperBinning::reserveCapacity(nElements);
-  _hyperVolumes      .reserve(nElements);
+  _cuboidOffsets     .reserve(nElements + 1);
+  _linkOffsets       .reserve(nElements + 1);
+  _corners           .reserve(nElements*2*getDimension());
   _linkedHyperVolumes.reserve(nElements);  
 }
 
@@ -1,5 +1,9 @@
 #include "HyperBinningPainter2D.h"
 
+int HyperBinningPainter2D::s_maxVectorBins = 20000;
+int HyperBinningPainter2D::s_rasterWidth   = 500;
+int HyperBinningPainter2D::s_rasterHeight  = 500;
+
 /** Construct a 2D HyperBinningPainter for a given HyperVolumeBinning and HyperPointSet.
 This option will draw the HyperPointSet as dots over the binning scheme
 */
@@ -85,9 +89,18 @@ void HyperBinningPainter2D::drawBinEdge(RootPlotter2D* plotter, HyperCuboid* bin
 }
 
 
-/** draw edges between bins with different contents */
+/** draw edges between bins with different contents. If the binning 
+is a HyperBinning, its adjacency graph is used to find the neighbours
+of each bin. Otherwise, the bins just outside each edge are looked up */
 void HyperBinningPainter2D::drawBinEdges2(RootPlotter2D* plotter){
 
+  const HyperBinning* hyperBinning = dynamic_cast<const HyperBinning*>( &getBinning() );
+
+  if (hyperBinning != 0){
+    drawBinEdges2(plotter, hyperBinning->getAdjacency());
+    return;
+  }
+
   double minBinWidthX = 10e50;
   double minBinWidthY = 10e50;
 
@@ -102,6 +115,51 @@ void HyperBinningPainter2D::drawBinEdges2(RootPlotter2D* plotter){
   for(int i = 0; i < getBinning().getNumBins(); i++) drawBinEdge2(plotter, i, minBinWidthX, minBinWidthY);
 }
 
+/** draw edges between bins with different contents, using the 
+adjacency graph. Each face is only drawn once, and only where 
+the two bins overlap. */
+void HyperBinningPainter2D::drawBinEdges2(RootPlotter2D* plotter, const HyperBinningAdjacency& adjacency){
+
+  int nBins = getBinning().getNumBins();
+
+  std::vector<HyperCuboid> limits;
+  limits.reserve(nBins);
+  for(int i = 0; i < nBins; i++) limits.push_back( getBinning().getBinHyperVolume(i).getLimits() );
+
+  for(int bin = 0; bin < nBins; bin++){
+
+    double binContent = _histogram->getBinContent(bin);
+    const HyperCuboid& binLimits = limits.at(bin);
+
+    for (int e = adjacency.getFirstNeighbour(bin); e < adjacency.getFirstNeighbour(bin + 1); e++){
+
+      int neighbour = adjacency.getNeighbour(e);
+      if (neighbour < bin) continue;
+      if (_histogram->getBinContent(neighbour) == binContent) continue;
+
+      const HyperCuboid& neighbourLimits = limits.at(neighbour);
+
+      int faceDim  = adjacency.getFaceDimension(e);
+      int otherDim = 1 - faceDim;
+
+      double position = adjacency.getFaceSide(e) > 0 ? binLimits.getHighCorner().at(faceDim) : binLimits.getLowCorner().at(faceDim);
+      double low  = std::max(binLimits.getLowCorner ().at(otherDim), neighbourLimits.getLowCorner ().at(otherDim));
+      double high = std::min(binLimits.getHighCorner().at(otherDim), neighbourLimits.getHighCorner().at(otherDim));
+
+      TLine* line = 0;
+      if (faceDim == 0) line = new TLine(position, low, position, high);
+      else              line = new TLine(low, position, high, position);
+
+      line  ->SetLineWidth(1);
+      line  ->SetLineColor(kBlack);
+      line  ->SetLineStyle(1);
+
+      plotter->addObject(line);
+    }
+  }
+
+}
+
 /** draw edges between bins with different contents */
 void HyperBinningPainter2D::drawBinEdge2(RootPlotter2D* plotter, int bin, double minWidX, double minWidY){
   
@@ -313,6 +371,49 @@ void HyperBinningPainter2D::drawFilledBins(RootPlotter2D* plotter, bool hashNeg
   for(int i = 0; i < getBinning().getNumBins(); i++) drawFilledBin(plotter, i, hashNeg);
 }
 
+/** add filled bins to the Plotter, following the HyperBinning hierarchy
+down from the top. Any HyperVolume in the hierarchy that's smaller than a 
+pixel (see s_rasterWidth and s_rasterHeight) is drawn as a single box, 
+filled with the average content (or density) of the bins inside it */
+void HyperBinningPainter2D::drawFilledBinsLOD(RootPlotter2D* plotter, const HyperBinningAggregates& aggregates, bool hashNeg){
+
+  double pixelX = (getBinning().getMax(0) - getBinning().getMin(0))/s_rasterWidth;
+  double pixelY = (getBinning().getMax(1) - getBinning().getMin(1))/s_rasterHeight;
+
+  const std::vector<int>& roots = aggregates.getRoots();
+  std::vector<int> stack(roots.rbegin(), roots.rend());
+
+  while (stack.empty() == false){
+
+    int vol = stack.back();
+    stack.pop_back();
+
+    if (aggregates.getNumBins(vol) == 0) continue;
+
+    int bin = aggregates.getBinNumber(vol);
+
+    if (bin != -1){
+      drawFilledBin(plotter, bin, hashNeg);
+      continue;
+    }
+
+    double widthX = aggregates.getHighEdge(vol, 0) - aggregates.getLowEdge(vol, 0);
+    double widthY = aggregates.getHighEdge(vol, 1) - aggregates.getLowEdge(vol, 1);
+
+    if (widthX < pixelX && widthY < pixelY){
+      double content = _density ? aggregates.getDensity(vol) : aggregates.getAverageContent(vol);
+      if (hashNeg == true && content < 0.0) content = -content;
+      HyperCuboid limits = aggregates.getLimits(vol);
+      drawFilledBin(plotter, &limits, content);
+      continue;
+    }
+
+    for (int c = aggregates.getNumChildren(vol) - 1; c >= 0; c--) stack.push_back(aggregates.getChild(vol, c));
+
+  }
+
+}
+
 /** add filled bins to the Plotter (for all HyperVolumes) */
 void HyperBinningPainter2D::drawFilledBin(RootPlotter2D* plotter, int bin, bool hashNeg){
   
@@ -366,14 +467,196 @@ void HyperBinningPainter2D::addHyperPoints(TH2D* histogram){
   }  
 }
 
-/** Draw the HyperBinningHistogram  */
+/** Get the range of the z axis - the smallest and largest bin
+content (or density). If negative bins are hashed, they are drawn
+using their absolute value */
+void HyperBinningPainter2D::getContentRange(double& min, double& max, bool hashNeg){
+
+  min = _histogram->getMin();
+  max = _histogram->getMax();
+  if (_density == true){
+    min = _histogram->getMinDensity();
+    max = _histogram->getMaxDensity();
+  }
+  
+  if (hashNeg){
+    min = min<0.0?0.0:min;
+    max = fabs(max)>fabs(min)?fabs(max):fabs(min);
+  }
+
+}
+
+/** Find which bin each pixel of the raster is in (-1 if none). Each 
+HyperCuboid is filled one row of pixels at a time, and a pixel belongs 
+to the HyperCuboid its centre lies in, so this takes O(bins + pixels) */
+void HyperBinningPainter2D::rasterise(TH2D* raster, std::vector<int>& pixelBins){
+
+  int    nx    = raster->GetNbinsX();
+  int    ny    = raster->GetNbinsY();
+  double x_min = raster->GetXaxis()->GetXmin();
+  double y_min = raster->GetYaxis()->GetXmin();
+  double widX  = raster->GetXaxis()->GetBinWidth(1);
+  double widY  = raster->GetYaxis()->GetBinWidth(1);
+
+  pixelBins.assign(nx*ny, -1);
+
+  for(int bin = 0; bin < getBinning().getNumBins(); bin++){
+
+    HyperVolume volume = getBinning().getBinHyperVolume(bin);
+
+    for (int i = 0; i < volume.size(); i++){
+      const HyperCuboid& cuboid = volume.at(i);
+
+      //the pixels with centres in (low, high]
+      int lowX  = (int)floor( (cuboid.getLowCorner ().at(0) - x_min)/widX - 0.5 ) + 1;
+      int highX = (int)floor( (cuboid.getHighCorner().at(0) - x_min)/widX - 0.5 );
+      int lowY  = (int)floor( (cuboid.getLowCorner ().at(1) - y_min)/widY - 0.5 ) + 1;
+      int highY = (int)floor( (cuboid.getHighCorner().at(1) - y_min)/widY - 0.5 );
+
+      if (lowX  < 0     ) lowX  = 0;
+      if (lowY  < 0     ) lowY  = 0;
+      if (highX > nx - 1) highX = nx - 1;
+      if (highY > ny - 1) highY = ny - 1;
+
+      for (int iy = lowY; iy <= highY; iy++){
+        int* row = &pixelBins[iy*nx];
+        for (int ix = lowX; ix <= highX; ix++) row[ix] = bin;
+      }
+    }
+
+  }
+
+}
+
+/** Blank out the pixels on the edges between bins, so they're drawn in
+the background colour. If contentEdges is true, only the edges between 
+bins with different contents are drawn (like Edges2), otherwise every
+edge is (like Edges1) */
+void HyperBinningPainter2D::rasteriseEdges(TH2D* raster, const std::vector<int>& pixelBins, bool contentEdges, double blank){
+
+  int nx = raster->GetNbinsX();
+  int ny = raster->GetNbinsY();
+
+  for (int iy = 0; iy < ny; iy++){
+    for (int ix = 0; ix < nx; ix++){
+
+      int bin = pixelBins[iy*nx + ix];
+      if (bin == -1) continue;
+
+      bool edge = false;
+
+      //compare to the pixels to the right and above
+      for (int n = 0; n < 2 && edge == false; n++){
+        int jx = ix + (n == 0 ? 1 : 0);
+        int jy = iy + (n == 1 ? 1 : 0);
+        if (jx >= nx || jy >= ny) continue;
+
+        int other = pixelBins[jy*nx + jx];
+        if (other == bin || other == -1) continue;
+
+        if (contentEdges == false) edge = true;
+        else edge = _histogram->getBinContent(other) != _histogram->getBinContent(bin);
+      }
+
+      if (edge) raster->SetBinContent(ix + 1, iy + 1, blank);
+    }
+  }
+
+}
+
+/** Draw the HyperBinningHistogram as a raster of s_rasterWidth x s_rasterHeight
+pixels, rather than a TBox for every bin, so the time and size of the plot 
+don't grow with the number of bins. Pixels outside the binning, and on 
+the edges between bins (for Edges1 and Edges2), are set below the minimum
+of the z axis so they aren't drawn. HashNeg draws negative bins using 
+their absolute value, but they aren't hashed. */
+void HyperBinningPainter2D::drawRaster(TString path, TString option){
+
+  bool drawBinEd1     = option.Contains("Edges1" );
+  bool drawBinEd2     = option.Contains("Edges2" );
+  bool drawBinNums    = option.Contains("BinNums");
+  bool drawHashedNeg  = option.Contains("HashNeg");
+  bool drawBinContOp  = option.Contains("Text");
+
+  double x_min = getBinning().getMin(0);
+  double x_max = getBinning().getMax(0);
+  double y_min = getBinning().getMin(1);
+  double y_max = getBinning().getMax(1);
+
+  TString xtitle =  _histogram->getNames().getAxisString(0);
+  TString ytitle =  _histogram->getNames().getAxisString(1);
+
+  TH2D* raster = new TH2D("2DHyperBinningRaster", "2DHyperBinningRaster", s_rasterWidth, x_min, x_max, s_rasterHeight, y_min, y_max);
+  raster->GetXaxis()->SetTitle( xtitle );
+  raster->GetYaxis()->SetTitle( ytitle );
+
+  double min = 0.0;
+  double max = 0.0;
+  getContentRange(min, max, drawHashedNeg);
+
+  //anything below the minimum isn't drawn
+  double blank = min - 1.0 - fabs(max - min);
+
+  std::vector<int> pixelBins;
+  rasterise(raster, pixelBins);
+
+  int nBins = getBinning().getNumBins();
+  std::vector<double> binContents(nBins);
+
+  for(int bin = 0; bin < nBins; bin++){
+    double binContent = _histogram->getBinContent(bin);
+    if (_density == true ) binContent = _histogram->getFrequencyDensity(bin);
+    if (drawHashedNeg == true && binContent < 0.0) binContent = -binContent;
+    binContents[bin] = binContent;
+  }
+
+  int nx = raster->GetNbinsX();
+  int ny = raster->GetNbinsY();
+
+  for (int iy = 0; iy < ny; iy++){
+    for (int ix = 0; ix < nx; ix++){
+      int bin = pixelBins[iy*nx + ix];
+      raster->SetBinContent(ix + 1, iy + 1, bin == -1 ? blank : binContents[bin]);
+    }
+  }
+
+  if (drawBinEd1 || drawBinEd2) rasteriseEdges(raster, pixelBins, drawBinEd1 == false, blank);
+
+  raster->SetMaximum(max);
+  raster->SetMinimum(min);
+  raster->SetContour(gStyle->GetNumberContours());
+
+  RootPlotter2D plotter(raster);
+
+  if (drawBinNums   ) drawBinNumbers(&plotter);
+  if (drawBinContOp ) drawBinCont   (&plotter);
+
+  plotter.plot(path, "COLZ");
+
+  delete raster;
+}
+
+/** Draw the HyperBinningHistogram. Binnings with more than s_maxVectorBins
+bins are rasterised (see drawRaster) unless the "Vector" option is given.
+The "Raster" option always rasterises. With the "LOD" option, parts of a 
+HyperBinning hierarchy smaller than a pixel are drawn as one box (see 
+drawFilledBinsLOD) */
 void HyperBinningPainter2D::draw(TString path, TString option){
   
+  bool raster = option.Contains("Raster");
+  if (option.Contains("Vector") == false && getBinning().getNumBins() > s_maxVectorBins) raster = true;
+
+  if (_histogram != 0 && raster){
+    drawRaster(path, option);
+    return;
+  }
+
   bool drawBinEd1     = option.Contains("Edges1" );
   bool drawBinEd2     = option.Contains("Edges2" );
   bool drawBinNums    = option.Contains("BinNums");
   bool drawHashedNeg  = option.Contains("HashNeg");
   bool drawBinContOp  = option.Contains("Text");
+  bool drawLOD        = option.Contains("LOD");
 
   double x_min = getBinning().getMin(0);
   double x_max = getBinning().getMax(0);
@@ -387,17 +670,9 @@ void HyperBinningPainter2D::draw(TString path, TString option){
   histogram->GetXaxis()->SetTitle( xtitle );
   histogram->GetYaxis()->SetTitle( ytitle );
 
-  double min = _histogram->getMin();
-  double max = _histogram->getMax();
-  if (_density == true){
-    min = _histogram->getMinDensity();
-    max = _histogram->getMaxDensity();
-  }
-  
-  if (drawHashedNeg){
-    min = min<0.0?0.0:min;
-    max = fabs(max)>fabs(min)?fabs(max):fabs(min);
-  }
+  double min = 0.0;
+  double max = 0.0;
+  if (_histogram   != 0) getContentRange(min, max, drawHashedNeg);
 
   if (_histogram   != 0){
     //if you want the scale to be correct on the zaxis, we need to fill the
@@ -419,7 +694,9 @@ void HyperBinningPainter2D::draw(TString path, TString option){
     box->SetFillColor( 0 );
     box->SetLineWidth(0.0);
     plotter.addObject(box)  ;
-    drawFilledBins(&plotter, drawHashedNeg);
+    const HyperBinningAggregates* aggregates = drawLOD ? _histogram->getAggregates() : 0;
+    if (aggregates != 0) drawFilledBinsLOD(&plotter, *aggregates, drawHashedNeg);
+    else                 drawFilledBins   (&plotter, drawHashedNeg);
     if (drawBinEd1    ) drawBinEdges  (&plotter);
     if (drawBinEd2    ) drawBinEdges2 (&plotter);
     if (drawBinNums   ) drawBinNumbers(&plotter);
@@ -1,8 +1,12 @@
 #include "HyperFunction.h"
 
+// std includes
+#include <thread>
+
 
 HyperFunction::HyperFunction() :
-  _limits(HyperPoint(0), HyperPoint(0))
+  _limits(HyperPoint(0), HyperPoint(0)),
+  _numThreads(1)
 {
 
 
@@ -11,11 +15,73 @@ HyperFunction::HyperFunction() :
 }
 
 HyperFunction::HyperFunction(const HyperCuboid& limits) :
-  _limits(limits)
+  _limits(limits),
+  _numThreads(1)
 {
 
 }
 
+///Evaluate the function at points first to first + nPoints - 1,
+///and put the results in vals[0] to vals[nPoints - 1]. This just
+///calls getVal for each point, but can be overridden by functions
+///that are quicker to evaluate a block at a time.
+void HyperFunction::getValBlock(const HyperPointSet& points, int first, int nPoints, double* vals) const{
+
+  for (int i = 0; i < nPoints; i++){
+    vals[i] = getVal( points.at(first + i) );
+  }
+
+}
+
+///Evaluate the function at every point in the HyperPointSet, and put
+///the results in vals (which must have space for points.size() values).
+///If setNumThreads has been used, the points are split into one block
+///per thread.
+void HyperFunction::getVals(const HyperPointSet& points, double* vals) const{
+
+  int nPoints  = points.size();
+  int nThreads = _numThreads < nPoints ? _numThreads : nPoints;
+
+  if (nThreads <= 1){
+    if (nPoints > 0) getValBlock(points, 0, nPoints, vals);
+    return;
+  }
+
+  std::vector<std::thread> threads;
+
+  for (int t = 0; t < nThreads; t++){
+    int first = (int)( (Long64_t)nPoints*t      /nThreads );
+    int last  = (int)( (Long64_t)nPoints*(t + 1)/nThreads );
+    threads.push_back( std::thread( [this, &points, vals, first, last](){
+      getValBlock(points, first, last - first, vals + first);
+    } ) );
+  }
+
+  for (unsigned t = 0; t < threads.size(); t++) threads.at(t).join();
+
+}
+
+///Evaluate the function at every point in the HyperPointSet
+///
+std::vector<double> HyperFunction::getVals(const HyperPointSet& points) const{
+
+  std::vector<double> vals(points.size(), 0.0);
+  if (vals.empty() == false) getVals(points, &vals.at(0));
+  return vals;
+
+}
+
+///Set the number of threads getVals uses. Only use more than one
+///if the function is safe to evaluate from several threads at once.
+///If nThreads is 0, there's one thread per core.
+void HyperFunction::setNumThreads(int nThreads){
+
+  if (nThreads < 1) nThreads = std::thread::hardware_concurrency();
+  if (nThreads < 1) nThreads = 1;
+  _numThreads = nThreads;
+
+}
+
 
 ///Reweight a HyperPointSet by the HyperFunction. If weights already
 ///exist, the existing weights are mulitplied by the HyperFunction
@@ -24,12 +90,14 @@ HyperFunction::HyperFunction(const HyperCuboid& limits) :
 void HyperFunction::reweightDataset(HyperPointSet& points){
 
   int npoints = points.size(); 
+
+  std::vector<double> vals = getVals(points);
  
   for (int i = 0; i < npoints; i++){
 
     HyperPoint& point = points.at(i);
 
-    double val = this->getVal(point);
+    double val = vals.at(i);
 
     int nW = point.numWeights();
 
@@ -70,16 +138,27 @@ TH2D HyperFunction::make2DFuncSlice   (TString name, int sliceDimX, int sliceDim
   double maxY = _limits.getHighCorner().at(sliceDimY);
 
   TH2D hist(name, name, nbins, minX, maxX, nbins, minY, maxY);
+
+  //evaluate the whole slice in one go
+
+  HyperPointSet points(slicePoint.getDimension());
+  points.reserve(nbins*nbins);
+
+  HyperPoint point(slicePoint);
+
+  for (int i = 1; i <= nbins; i++){
+    for (int j = 1; j <= nbins; j++){
+      point.at(sliceDimX) = hist.GetXaxis()->GetBinCenter(i);
+      point.at(sliceDimY) = hist.GetYaxis()->GetBinCenter(j);
+      points.push_back(point);
+    }
+  }
+
+  std::vector<double> vals = getVals(points);
   
   for (int i = 1; i <= nbins; i++){
     for (int j = 1; j <= nbins; j++){
-      double x = hist.GetXaxis()->GetBinCenter(i);
-      double y = hist.GetYaxis()->GetBinCenter(j);
-      HyperPoint point(slicePoint);
-      point.at(sliceDimX) = x;
-      point.at(sliceDimY) = y;
-      double val = getVal(point);
-      hist.SetBinContent(i,j,val);
+      hist.SetBinContent(i, j, vals.at( (i - 1)*nbins + (j - 1) ));
     }
   }
   
@@ -95,6 +174,32 @@ void HyperFunction::draw2DFuncSlice   (TString path, int sliceDimX, int sliceDim
 
 }
 
+///Evaluates and draws a set of function slices in a RenderPool
+///
+class FuncSliceDrawJob : public RenderJob {
+
+  const HyperFunction&        _func;
+  int                         _sliceDimX;
+  int                         _sliceDimY;
+  const HyperPointSet&        _slicePoints;
+  const std::vector<TString>& _paths;
+  int                         _nbins;
+
+  public:
+
+  FuncSliceDrawJob(const HyperFunction& func, int sliceDimX, int sliceDimY, const HyperPointSet& slicePoints, const std::vector<TString>& paths, int nbins) :
+    _func(func), _sliceDimX(sliceDimX), _sliceDimY(sliceDimY), _slicePoints(slicePoints), _paths(paths), _nbins(nbins)
+  {}
+
+  void render(int i){ _func.draw2DFuncSlice(_paths.at(i), _sliceDimX, _sliceDimY, _slicePoints.at(i), _nbins); }
+
+  bool canFork() const{ return _func.isDiskResident() == false; }
+
+};
+
+///Draw nSlices 2D slices of the function, spread evenly along sliceSetDim.
+///Each slice is evaluated and drawn by a RenderPool, so several can be
+///done at once (see RenderPool::s_numWorkers).
 void HyperFunction::draw2DFuncSliceSet(TString path, int sliceDimX, int sliceDimY, int sliceSetDim, int nSlices, const HyperPoint& slicePoint, int nbins) const{
 
   if (_limits.getDimension() == 0){
@@ -113,6 +218,9 @@ void HyperFunction::draw2DFuncSliceSet(TString path, int sliceDimX, int sliceDim
   double max = _limits.getHighCorner().at(sliceSetDim);
   double width = (max - min)/double(nSlices);
   
+  HyperPointSet slicePoints(slicePoint.getDimension());
+  std::vector<TString> paths;
+
   for (int i = 0; i < nSlices; i++){
     double val = min + width*(i + 0.5);
     slicePointCp.at(sliceSetDim) = val;
@@ -120,9 +228,14 @@ void HyperFunction::draw2DFuncSliceSet(TString path, int sliceDimX, int sliceDim
     TString uniquePath = path;
     uniquePath += "_sliceNum";
     uniquePath +=  i;
-    draw2DFuncSlice(uniquePath, sliceDimX, sliceDimY, slicePointCp, nbins);
 
+    slicePoints.push_back(slicePointCp);
+    paths.push_back(uniquePath);
   }
+
+  FuncSliceDrawJob job(*this, sliceDimX, sliceDimY, slicePoints, paths, nbins);
+  RenderPool pool;
+  pool.run(nSlices, job);
   
 
 }
@@ -180,10 +293,11 @@ double HyperFunction::getDifference(const HyperFunction& other, const HyperPoint
 
 void HyperFunction::fillCorrelations(TH2D& hist, const HyperFunction& other, const HyperPointSet& points){
 
+  std::vector<double> vals      =       getVals(points);
+  std::vector<double> valsother = other.getVals(points);
+
   for (unsigned i = 0; i < points.size(); i++){
-    double val      =       getVal(points.at(i));
-    double valother = other.getVal(points.at(i));
-    hist.Fill( val, valother, points.at(i).getWeight() );    
+    hist.Fill( vals.at(i), valsother.at(i), points.at(i).getWeight() );    
   }
   
   int nBinsX = hist.GetXaxis()->GetNbins();
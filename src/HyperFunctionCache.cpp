@@ -0,0 +1,179 @@
+#include "HyperFunctionCache.h"
+
+#include <cmath>
+
+///Constructor that takes the function to cache, and the range
+///it will be evaluated in. Two points are treated as the same if
+///they are within relativeResolution*(range width) of each other
+///in every dimension.
+HyperFunctionCache::HyperFunctionCache(const HyperFunction* func, const HyperCuboid& range, double relativeResolution) :
+  HyperFunction(range),
+  _func      (func),
+  _origin    (range.getLowCorner()),
+  _resolution(range.getDimension()),
+  _maxEntries(10000000),
+  _key       (range.getDimension(), 0),
+  _numCalls  (0),
+  _numHits   (0)
+{
+  WELCOME_LOG << "Hello from the HyperFunctionCache() Constructor";
+
+  for (int i = 0; i < range.getDimension(); i++){
+    double width = range.getHighCorner().at(i) - range.getLowCorner().at(i);
+    if (width <= 0.0) width = 1.0;
+    _resolution.at(i) = width*relativeResolution;
+  }
+
+}
+
+///Change the function being cached. If it is different
+///to the current one, all stored values are removed.
+void HyperFunctionCache::setFunction(const HyperFunction* func){
+  if (func == _func) return;
+  _func = func;
+  clear();
+}
+
+///Round the coordinates of a point to the grid, and
+///store them in _key
+void HyperFunctionCache::fillKey(const HyperPoint& point) const{
+
+  int dim = _origin.getDimension();
+
+  if (point.getDimension() != dim){
+    ERROR_LOG << "HyperFunctionCache::fillKey - HyperPoint has the wrong dimensionality" << std::endl;
+  }
+
+  for (int i = 0; i < dim; i++){
+    _key.at(i) = Long64_t( floor( (point.at(i) - _origin.at(i))/_resolution.at(i) + 0.5 ) );
+  }
+
+}
+
+///Evaluate the function and store the result (the key
+///must already have been filled)
+double HyperFunctionCache::evaluate(const HyperPoint& point) const{
+
+  if (_func == 0){
+    ERROR_LOG << "HyperFunctionCache::evaluate - no HyperFunction has been given" << std::endl;
+    return 0.0;
+  }
+
+  if ( Long64_t(_cache.size()) >= _maxEntries ) _cache.clear();
+
+  double val = _func->getVal(point);
+  _cache[_key] = val;
+  return val;
+}
+
+///Get the function value at a point - only evaluates the
+///function if the point hasn't been seen before.
+double HyperFunctionCache::getVal(const HyperPoint& point) const{
+
+  _numCalls++;
+  fillKey(point);
+
+  std::map< std::vector<Long64_t>, double >::const_iterator it = _cache.find(_key);
+
+  if (it != _cache.end()){
+    _numHits++;
+    return it->second;
+  }
+
+  return evaluate(point);
+}
+
+///Get the function values for a block of points. Points that are
+///already in the cache (or appear more than once in the block) are
+///only evaluated once, and the rest are evaluated together.
+void HyperFunctionCache::getValBlock(const HyperPointSet& points, int first, int nPoints, double* vals) const{
+
+  if (_func == 0){
+    ERROR_LOG << "HyperFunctionCache::getValBlock - no HyperFunction has been given" << std::endl;
+    for (int i = 0; i < nPoints; i++) vals[i] = 0.0;
+    return;
+  }
+
+  HyperPointSet misses(points.getDimension());
+  std::vector< std::vector<Long64_t> > missKeys;
+  std::map< std::vector<Long64_t>, int > missNumber; //position of each key in misses
+  std::vector<int> missOfPoint(nPoints, -1);
+
+  for (int i = 0; i < nPoints; i++){
+
+    const HyperPoint& point = points.at(first + i);
+
+    _numCalls++;
+    fillKey(point);
+
+    std::map< std::vector<Long64_t>, double >::const_iterator it = _cache.find(_key);
+
+    if (it != _cache.end()){
+      _numHits++;
+      vals[i] = it->second;
+      continue;
+    }
+
+    std::map< std::vector<Long64_t>, int >::const_iterator missIt = missNumber.find(_key);
+
+    if (missIt != missNumber.end()){
+      _numHits++;
+      missOfPoint.at(i) = missIt->second;
+      continue;
+    }
+
+    missOfPoint.at(i) = misses.size();
+    missNumber[_key] = misses.size();
+    missKeys.push_back(_key);
+    misses.push_back(point);
+  }
+
+  if (misses.size() == 0) return;
+
+  std::vector<double> missVals = _func->getVals(misses);
+
+  if ( Long64_t(_cache.size() + missVals.size()) > _maxEntries ) _cache.clear();
+
+  for (unsigned i = 0; i < missVals.size(); i++){
+    _cache[missKeys.at(i)] = missVals.at(i);
+  }
+
+  for (int i = 0; i < nPoints; i++){
+    if (missOfPoint.at(i) != -1) vals[i] = missVals.at( missOfPoint.at(i) );
+  }
+
+}
+
+///Remove all stored values
+///
+void HyperFunctionCache::clear(){
+  _cache.clear();
+}
+
+///Reset the number of calls and hits
+///
+void HyperFunctionCache::resetStatistics(){
+  _numCalls = 0;
+  _numHits  = 0;
+}
+
+///Fraction of calls that were found in the cache
+///
+double HyperFunctionCache::getHitRate() const{
+  if (_numCalls == 0) return 0.0;
+  return double(_numHits)/double(_numCalls);
+}
+
+///Print the number of calls, function evaluations and hit rate
+///
+void HyperFunctionCache::printStatistics() const{
+  INFO_LOG << "HyperFunctionCache: " << getNumCalls() << " calls, " << getNumEvaluations() << " function evaluations";
+  INFO_LOG << " (hit rate " << getHitRate()*100.0 << "%, " << size() << " values stored)" << std::endl;
+}
+
+///Destructor
+///
+HyperFunctionCache::~HyperFunctionCache(){
+  GOODBYE_LOG << "Goodbye from the HyperFunctionCache() Destructor";
+}
+
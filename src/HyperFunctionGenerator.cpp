@@ -0,0 +1,334 @@
+#include "HyperFunctionGenerator.h"
+
+// std includes
+#include <thread>
+#include <algorithm>
+
+double HyperFunctionGenerator::s_safetyFactor        = 1.2;
+double HyperFunctionGenerator::s_minEnvelopeFraction = 1e-3;
+double HyperFunctionGenerator::s_buildPointsPerBin   = 50.0;
+
+
+///Build the envelope for a HyperFunction, using nBuildPoints
+///function evaluations. By default (nThreads = -1) the function is 
+///evaluated with func.getNumThreads() threads - usually one, since 
+///most functions aren't thread safe. If nThreads is 0, there's one 
+///thread per core.
+HyperFunctionGenerator::HyperFunctionGenerator(const HyperFunction& func, int nBuildPoints, UInt_t seed, int nThreads) :
+  _func(func),
+  _seed(seed),
+  _numThreads(nThreads),
+  _numGenerateCalls(0),
+  _binning(0),
+  _envelopeGenerator(0),
+  _numBuildEvaluations(0),
+  _numEvaluations(0),
+  _numAccepted(0),
+  _numViolations(0)
+{
+  WELCOME_LOG << "Good day from the HyperFunctionGenerator() Constructor";
+
+  if (_numThreads <  0) _numThreads = func.getNumThreads();
+  if (_numThreads == 0) _numThreads = std::thread::hardware_concurrency();
+  if (_numThreads <  1) _numThreads = 1;
+
+  buildEnvelope(nBuildPoints);
+}
+
+///Evaluate the function at every point, splitting the points
+///between the threads
+std::vector<double> HyperFunctionGenerator::evaluate(const HyperPointSet& points) const{
+
+  int nPoints = points.size();
+  std::vector<double> vals(nPoints, 0.0);
+
+  int nThreads = _numThreads < nPoints ? _numThreads : 1;
+
+  std::vector<std::thread> threads;
+
+  for (int t = 0; t < nThreads; t++){
+    int first = (int)( (Long64_t)nPoints*t      /nThreads );
+    int last  = (int)( (Long64_t)nPoints*(t + 1)/nThreads );
+    threads.push_back( std::thread( [this, &points, &vals, first, last](){
+      if (last > first) _func.getValBlock(points, first, last - first, &vals.at(first));
+    } ) );
+  }
+
+  for (unsigned t = 0; t < threads.size(); t++) threads.at(t).join();
+
+  return vals;
+
+}
+
+///Evaluate the function at random points, make an adaptive binning
+///of them (weighted by the function), and set the envelope in each
+///bin from the largest function value seen there (including at the
+///centre of the bin).
+void HyperFunctionGenerator::buildEnvelope(int nBuildPoints){
+
+  HyperCuboid limits = _func.getFuncLimits();
+
+  if (limits.getDimension() == 0){
+    ERROR_LOG << "HyperFunctionGenerator - you need to set the domain of the function with setFuncLimits(const HyperCuboid& limits)" << std::endl;
+    return;
+  }
+  if (nBuildPoints < 1){
+    ERROR_LOG << "HyperFunctionGenerator - at least one build point is needed" << std::endl;
+    return;
+  }
+
+  TRandom3 random(_seed);
+  HyperPointSet points = limits.getRandomPoints(nBuildPoints, &random);
+
+  std::vector<double> vals = evaluate(points);
+  _numBuildEvaluations = nBuildPoints;
+
+  double sumW = 0.0;
+  for (int i = 0; i < nBuildPoints; i++){
+    double weight = vals.at(i) > 0.0 ? vals.at(i) : 0.0;
+    points.at(i).addWeight(weight);
+    sumW += weight;
+  }
+
+  if (sumW <= 0.0){
+    ERROR_LOG << "HyperFunctionGenerator - the function wasn't positive at any of the build points" << std::endl;
+    return;
+  }
+
+  double minBinContent = sumW*s_buildPointsPerBin/double(nBuildPoints);
+
+  HyperHistogram histogram(limits, points, HyperBinningAlgorithms::SMART,
+                           AlgOption::MinBinContent(minBinContent),
+                           AlgOption::UseWeights(true)             );
+
+  _binning = histogram.getBinning().clone();
+
+  int nBins = _binning->getNumBins();
+
+  _envelope  .assign(nBins, 0.0);
+  _binVolumes.assign(nBins, 0.0);
+
+  std::vector<int> binNumbers = _binning->getBinNum(points);
+
+  for (int i = 0; i < nBuildPoints; i++){
+    int bin = binNumbers.at(i);
+    if (bin < 0 || bin >= nBins) continue;
+    _envelope.at(bin) = std::max(_envelope.at(bin), vals.at(i));
+  }
+
+  HyperPointSet centres(limits.getDimension());
+  for (int bin = 0; bin < nBins; bin++){
+    HyperVolume volume = _binning->getBinHyperVolume(bin);
+    _binVolumes.at(bin) = volume.volume();
+    centres.push_back( volume.getAverageCenter() );
+  }
+
+  std::vector<double> centreVals = evaluate(centres);
+  _numBuildEvaluations += nBins;
+
+  double maxEnvelope = 0.0;
+  for (int bin = 0; bin < nBins; bin++){
+    _envelope.at(bin) = s_safetyFactor*std::max(_envelope.at(bin), centreVals.at(bin));
+    maxEnvelope = std::max(maxEnvelope, _envelope.at(bin));
+  }
+
+  for (int bin = 0; bin < nBins; bin++){
+    _envelope.at(bin) = std::max(_envelope.at(bin), s_minEnvelopeFraction*maxEnvelope);
+  }
+
+  updateEnvelopeGenerator();
+
+  INFO_LOG << "HyperFunctionGenerator - built an envelope with " << nBins << " bins from " << _numBuildEvaluations << " function evaluations" << std::endl;
+
+}
+
+///Give the envelope generator the integral of the envelope in
+///each bin
+void HyperFunctionGenerator::updateEnvelopeGenerator(){
+
+  int nBins = _envelope.size();
+
+  std::vector<double> integrals(nBins);
+  for (int bin = 0; bin < nBins; bin++) integrals.at(bin) = _envelope.at(bin)*_binVolumes.at(bin);
+
+  if (_envelopeGenerator != 0) {
+    _envelopeGenerator->setBinContents(integrals);
+    return;
+  }
+
+  HistogramBase contents(nBins);
+  for (int bin = 0; bin < nBins; bin++) contents.setBinContent(bin, integrals.at(bin));
+
+  _envelopeGenerator = new HyperHistogramGenerator(*_binning, contents);
+
+}
+
+///Fill every point in points (which should already be the size
+///wanted) with events distributed like the function. Any weights
+///are set to one.
+void HyperFunctionGenerator::generate(HyperPointSetColumns& points){
+
+  if (_envelopeGenerator == 0){
+    ERROR_LOG << "HyperFunctionGenerator::generate - there's no envelope to generate events from" << std::endl;
+    return;
+  }
+
+  int dim     = _binning->getDimension();
+  int nEvents = points.size();
+
+  if (points.getDimension() != dim){
+    ERROR_LOG << "HyperFunctionGenerator::generate - the points have a different dimension to the function" << std::endl;
+    return;
+  }
+
+  int nThreads = _numThreads;
+
+  std::vector<TRandom3*> randoms(nThreads);
+  for (int t = 0; t < nThreads; t++) randoms.at(t) = new TRandom3(_seed + 1 + t + 65536*(_numGenerateCalls + 1));
+  _numGenerateCalls++;
+
+  std::vector< std::vector<double> > accepted  (nThreads); //flat coordinates of the accepted events
+  std::vector< std::vector<int>    > violatedBins(nThreads);
+  std::vector< std::vector<double> > violatedVals(nThreads);
+
+  Long64_t evaluationsBefore = _numEvaluations;
+  Long64_t acceptedBefore    = _numAccepted;
+
+  int nFilled = 0;
+
+  while (nFilled < nEvents){
+
+    //enough candidates (per thread) that this round should finish the job
+
+    double efficiency = _numAccepted > 0 ? double(_numAccepted)/double(_numEvaluations) : 0.1;
+    double needed     = 1.1*(nEvents - nFilled)/efficiency/nThreads;
+    int    perThread  = (int)std::min(1e6, std::max(1000.0, needed));
+
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < nThreads; t++){
+      threads.push_back( std::thread( [this, t, dim, perThread, &randoms, &accepted, &violatedBins, &violatedVals](){
+
+        TRandom* random = randoms.at(t);
+        HyperPoint point(dim);
+
+        accepted    .at(t).clear();
+        violatedBins.at(t).clear();
+        violatedVals.at(t).clear();
+
+        //the candidates are evaluated a block at a time (see HyperFunction::getValBlock)
+
+        const int blockSize = 1024;
+
+        HyperPointSet    block(dim);
+        std::vector<int>    bins(blockSize);
+        std::vector<double> vals(blockSize);
+
+        for (int done = 0; done < perThread; done += blockSize){
+
+          int nBlock = std::min(blockSize, perThread - done);
+
+          block.clear();
+          for (int i = 0; i < nBlock; i++){
+            bins[i] = _envelopeGenerator->generateBin(random);
+            _envelopeGenerator->generatePoint(bins[i], random, &point.at(0));
+            block.push_back(point);
+          }
+
+          _func.getValBlock(block, 0, nBlock, &vals.at(0));
+
+          for (int i = 0; i < nBlock; i++){
+
+            double val      = vals[i];
+            double envelope = _envelope[bins[i]];
+
+            if (val > envelope){
+              violatedBins.at(t).push_back(bins[i]);
+              violatedVals.at(t).push_back(val);
+            }
+
+            if (random->Rndm()*envelope < val){
+              for (int d = 0; d < dim; d++) accepted.at(t).push_back(block.at(i).at(d));
+            }
+          }
+        }
+
+      } ) );
+    }
+
+    for (unsigned t = 0; t < threads.size(); t++) threads.at(t).join();
+
+    //copy the accepted events in thread order
+
+    _numEvaluations += (Long64_t)perThread*nThreads;
+
+    for (int t = 0; t < nThreads; t++){
+      int nAccepted = accepted.at(t).size()/dim;
+      _numAccepted += nAccepted;
+      for (int i = 0; i < nAccepted && nFilled < nEvents; i++){
+        for (int d = 0; d < dim; d++) points.getColumn(d)[nFilled] = accepted.at(t)[i*dim + d];
+        nFilled++;
+      }
+    }
+
+    //raise the envelope wherever the function was found above it
+
+    bool raised = false;
+
+    for (int t = 0; t < nThreads; t++){
+      for (unsigned i = 0; i < violatedBins.at(t).size(); i++){
+        int    bin = violatedBins.at(t).at(i);
+        double val = violatedVals.at(t).at(i)*s_safetyFactor;
+        if (val <= _envelope.at(bin)) continue;
+        _envelope.at(bin) = val;
+        _numViolations++;
+        raised = true;
+      }
+    }
+
+    if (raised) updateEnvelopeGenerator();
+
+  }
+
+  for (int w = 0; w < points.getNumWeights(); w++){
+    std::vector<double>& weights = points.getWeightColumn(w);
+    std::fill(weights.begin(), weights.end(), 1.0);
+  }
+
+  for (int t = 0; t < nThreads; t++) delete randoms.at(t);
+
+  Long64_t evaluations = _numEvaluations - evaluationsBefore;
+  Long64_t nAccepted   = _numAccepted    - acceptedBefore;
+
+  INFO_LOG << "HyperFunctionGenerator::generate - accepted " << nAccepted << " of " << evaluations << " candidates (efficiency "
+           << (evaluations > 0 ? double(nAccepted)/double(evaluations) : 0.0) << "), raised the envelope " << _numViolations << " times so far" << std::endl;
+
+}
+
+///Generate nEvents into a new HyperPointSetColumns
+///
+HyperPointSetColumns HyperFunctionGenerator::generate(int nEvents){
+
+  int dim = _binning != 0 ? _binning->getDimension() : _func.getFuncLimits().getDimension();
+
+  HyperPointSetColumns points(dim);
+  points.resize(nEvents);
+  generate(points);
+  return points;
+
+}
+
+///The fraction of function evaluations (made while generating,
+///not building the envelope) that gave an event
+double HyperFunctionGenerator::getEfficiency() const{
+  if (_numEvaluations == 0) return 0.0;
+  return double(_numAccepted)/double(_numEvaluations);
+}
+
+///Destructor
+///
+HyperFunctionGenerator::~HyperFunctionGenerator(){
+  delete _envelopeGenerator;
+  delete _binning;
+  GOODBYE_LOG << "Goodbye from the HyperFunctionGenerator() Destructor";
+}
@@ -0,0 +1,222 @@
+#include "HyperFunctionIntegrator.h"
+
+// std includes
+#include <thread>
+#include <cmath>
+
+int HyperFunctionIntegrator::s_numShifts = 16;
+int HyperFunctionIntegrator::s_minPoints = 8;
+
+
+///Constructor - precision is the target error relative to each
+///integral, and maxPoints the most points used for each integral
+///(i.e. each HyperCuboid or HyperVolume passed to integrate)
+HyperFunctionIntegrator::HyperFunctionIntegrator(const HyperFunction& func, double precision, int maxPoints, UInt_t seed) :
+  _func(func),
+  _precision(precision),
+  _maxPoints(maxPoints),
+  _seed(seed),
+  _numEvaluations(0),
+  _numImprecise(0)
+{
+  WELCOME_LOG << "Good day from the HyperFunctionIntegrator() Constructor";
+}
+
+///The index'th number of the van der Corput sequence in the given base
+///(i.e. the digits of index, reflected about the decimal point)
+double HyperFunctionIntegrator::radicalInverse(unsigned index, int base){
+
+  double inverse  = 0.0;
+  double fraction = 1.0/double(base);
+
+  while (index > 0){
+    inverse  += fraction*double(index % base);
+    index    /= base;
+    fraction /= double(base);
+  }
+
+  return inverse;
+
+}
+
+///Integrate the function over a HyperCuboid, and put the error in error.
+///The random shifts of the Halton sequence are taken from random.
+double HyperFunctionIntegrator::integrate(const HyperCuboid& cuboid, double& error, TRandom* random) const{
+  return integrate(cuboid, error, random, _maxPoints);
+}
+
+///Integrate the function over a HyperCuboid using at most maxPoints
+///points (apart from the first round, which is always done)
+double HyperFunctionIntegrator::integrate(const HyperCuboid& cuboid, double& error, TRandom* random, int maxPoints) const{
+
+  static const int primes[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53,
+                               59, 61, 67, 71, 73, 79, 83, 89, 97, 101, 103, 107, 109, 113, 127, 131};
+  static const int maxDim = sizeof(primes)/sizeof(int);
+
+  error = 0.0;
+
+  int dim = cuboid.getDimension();
+
+  if (dim > maxDim){
+    ERROR_LOG << "HyperFunctionIntegrator::integrate - can only integrate in up to " << maxDim << " dimensions" << std::endl;
+    return 0.0;
+  }
+
+  double volume = cuboid.volume();
+  if (volume <= 0.0) return 0.0;
+
+  int nShifts = s_numShifts < 2 ? 2 : s_numShifts;
+
+  const HyperPoint& low = cuboid.getLowCorner();
+  std::vector<double> width(dim);
+  for (int d = 0; d < dim; d++) width.at(d) = cuboid.getWidth(d);
+
+  std::vector<double> shifts(nShifts*dim);
+  for (unsigned i = 0; i < shifts.size(); i++) shifts.at(i) = random->Rndm();
+
+  std::vector<double> sums(nShifts, 0.0);
+  std::vector<double> vals;
+  std::vector<double> halton(dim);
+
+  //the points are overwritten each round, so they're only allocated once
+  HyperPointSet points(dim);
+  HyperPoint    point(dim);
+
+  int nDone = 0;
+  int nNext = s_minPoints < 1 ? 1 : s_minPoints;
+
+  double integral = 0.0;
+
+  while (true){
+
+    //add Halton points nDone to nNext - 1 to every shifted sequence
+
+    int nNew    = nNext - nDone;
+    int nPoints = nNew*nShifts;
+
+    while ((int)points.size() < nPoints) points.push_back(point);
+
+    for (int i = nDone; i < nNext; i++){
+      for (int d = 0; d < dim; d++) halton.at(d) = radicalInverse(i + 1, primes[d]);
+
+      for (int s = 0; s < nShifts; s++){
+        HyperPoint& shifted = points.at( (i - nDone)*nShifts + s );
+        for (int d = 0; d < dim; d++){
+          double u = halton.at(d) + shifts.at(s*dim + d);
+          if (u >= 1.0) u -= 1.0;
+          shifted.at(d) = low.at(d) + width.at(d)*u;
+        }
+      }
+    }
+
+    vals.resize(nPoints);
+    _func.getValBlock(points, 0, nPoints, &vals.at(0));
+    _numEvaluations += nPoints;
+
+    for (int i = 0; i < nNew; i++){
+      for (int s = 0; s < nShifts; s++) sums.at(s) += vals.at(i*nShifts + s);
+    }
+
+    nDone = nNext;
+
+    //each shifted sequence gives an independent estimate
+
+    double sumEst  = 0.0;
+    double sumEst2 = 0.0;
+    for (int s = 0; s < nShifts; s++){
+      double estimate = volume*sums.at(s)/double(nDone);
+      sumEst  += estimate;
+      sumEst2 += estimate*estimate;
+    }
+
+    integral = sumEst/double(nShifts);
+    double variance = (sumEst2/double(nShifts) - integral*integral)*double(nShifts)/double(nShifts - 1);
+    error = variance > 0.0 ? sqrt(variance/double(nShifts)) : 0.0;
+
+    if (error <= _precision*fabs(integral)) break;
+
+    if ( (Long64_t)2*nDone*nShifts > maxPoints ){
+      _numImprecise++;
+      break;
+    }
+
+    nNext = 2*nDone;
+  }
+
+  return integral;
+
+}
+
+///Integrate the function over a HyperVolume (the sum of the integrals
+///over its HyperCuboids), and put the error in error. The maximum
+///number of points is shared between the HyperCuboids in proportion
+///to their volume, so it applies to the whole HyperVolume.
+double HyperFunctionIntegrator::integrate(const HyperVolume& volume, double& error, TRandom* random) const{
+
+  double integral = 0.0;
+  double error2   = 0.0;
+
+  double totalVolume = 0.0;
+  for (int i = 0; i < volume.size(); i++) totalVolume += volume.at(i).volume();
+
+  for (int i = 0; i < volume.size(); i++){
+    double fraction = totalVolume > 0.0 ? volume.at(i).volume()/totalVolume : 1.0;
+    double cuboidError = 0.0;
+    integral += integrate(volume.at(i), cuboidError, random, int(fraction*double(_maxPoints)));
+    error2   += cuboidError*cuboidError;
+  }
+
+  error = sqrt(error2);
+  return integral;
+
+}
+
+///Integrate the function over every HyperVolume, using
+///HyperFunction::getNumThreads() threads. The random shifts used for
+///volume i come from a TRandom3 seeded with seed + i + 1.
+void HyperFunctionIntegrator::integrate(const std::vector<HyperVolume>& volumes, std::vector<double>& integrals, std::vector<double>& errors) const{
+
+  int nVolumes = volumes.size();
+
+  integrals.assign(nVolumes, 0.0);
+  errors   .assign(nVolumes, 0.0);
+
+  int nThreads = _func.getNumThreads();
+  if (nThreads > nVolumes) nThreads = nVolumes < 1 ? 1 : nVolumes;
+
+  Long64_t evaluationsBefore = _numEvaluations;
+  int      impreciseBefore   = _numImprecise;
+
+  //threads take the next volume from a shared counter
+
+  std::atomic<int> nextVolume(0);
+
+  auto work = [this, &volumes, &integrals, &errors, &nextVolume, nVolumes](){
+    TRandom3 random;
+    while (true){
+      int i = nextVolume.fetch_add(1);
+      if (i >= nVolumes) break;
+      random.SetSeed(_seed + i + 1);
+      integrals.at(i) = integrate(volumes.at(i), errors.at(i), &random);
+    }
+  };
+
+  if (nThreads <= 1){
+    work();
+  }
+  else{
+    std::vector<std::thread> threads;
+    for (int t = 0; t < nThreads; t++) threads.push_back( std::thread(work) );
+    for (unsigned t = 0; t < threads.size(); t++) threads.at(t).join();
+  }
+
+  INFO_LOG << "HyperFunctionIntegrator::integrate - integrated " << nVolumes << " volumes with " << _numEvaluations - evaluationsBefore
+           << " function evaluations (" << _numImprecise - impreciseBefore << " cuboids didn't reach the target precision)" << std::endl;
+
+}
+
+///Destructor
+///
+HyperFunctionIntegrator::~HyperFunctionIntegrator(){
+  GOODBYE_LOG << "Goodbye from the HyperFunctionIntegrator() Destructor";
+}
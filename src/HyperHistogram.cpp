@@ -1,6 +1,15 @@
 #include "HyperHistogram.h"
 #include "HyperBinningPainter1D.h"
 #include "HyperBinningPainter2D.h"
+#include "HyperPointSetReader.h"
+#include "HyperFunctionIntegrator.h"
+
+// Root includes
+#include "TROOT.h"
+
+// std includes
+#include <future>
+#include <chrono>
 
 
 /**
@@ -142,10 +151,7 @@ HyperHistogram::HyperHistogram(std::vector<TString> filename) :
   INFO_LOG << "Loading HyperHistogram at: " << filename.at(0) << std::endl;
   load(filename.at(0), "MEMRES");
 
-  for (int i = 1; i < nFiles; i++){
-    INFO_LOG << "Loading and merging HyperHistogram at: " << filename.at(i) << std::endl;
-    merge(filename.at(i));
-  }
+  merge( std::vector<TString>(filename.begin() + 1, filename.end()) );
   
   //This inherets from a HyperFunction. Although non-essential, it's useful for
   //the function to have some limits for it's domain.
@@ -262,7 +268,7 @@ Fill the HyperHistogram with a HyperPoint and aspecified weight
 int HyperHistogram::fill(const HyperPoint& coords, double weight){
 
   int binNumber = _binning->getBinNum(coords);
-  this->fillBase(binNumber, weight);
+  fillWithAggregates(binNumber, weight);
   return binNumber;
 }
 
@@ -273,10 +279,99 @@ HyperPoint has a weight, use it.
 int HyperHistogram::fill(const HyperPoint& coords){
 
   int binNumber = _binning->getBinNum(coords);
-  this->fillBase(binNumber, coords.getWeight(0));
+  fillWithAggregates(binNumber, coords.getWeight(0));
   return binNumber;
 }
 
+/**
+Fill a bin. If the hierarchy aggregates (see getAggregates) are up 
+to date, they're kept up to date, otherwise they'll be rebuilt the
+next time they're needed.
+*/
+void HyperHistogram::fillWithAggregates(int binNumber, double weight){
+
+  bool aggregatesUpToDate = _aggregates.isUpToDate(*this);
+
+  this->fillBase(binNumber, weight);
+
+  if (aggregatesUpToDate){
+    _aggregates.fill(binNumber, weight);
+    _aggregates.setContentsVersion( getContentsVersion() );
+  }
+
+}
+
+/**
+Get the contents of the HyperHistogram summed up the HyperBinning 
+hierarchy (see HyperBinningAggregates). These are rebuilt if the
+contents have changed since they were last used. Returns 0 if the
+binning isn't a HyperBinning, as there's no hierarchy to sum up.
+*/
+const HyperBinningAggregates* HyperHistogram::getAggregates() const{
+
+  const HyperBinning* hyperBinning = dynamic_cast<const HyperBinning*>(_binning);
+  if (hyperBinning == 0) return 0;
+
+  std::lock_guard<CacheMutex> lock(_aggregatesMutex);
+  if (_aggregates.isUpToDate(*this) == false) _aggregates.build(*hyperBinning, *this);
+
+  return &_aggregates;
+
+}
+
+/**
+Integrate the HyperHistogram over a region. Bins that are partly inside
+the region contribute the fraction of their volume that's inside. For
+a HyperBinning, the hierarchy aggregates are used, so only the bins on 
+the boundary of the region are visited.
+*/
+double HyperHistogram::integral(const HyperCuboid& region) const{
+
+  double sumW2 = 0.0;
+  return integral(region, sumW2);
+
+}
+
+/**
+Get the error on the integral over a region (see integral)
+*/
+double HyperHistogram::integralError(const HyperCuboid& region) const{
+
+  double sumW2 = 0.0;
+  integral(region, sumW2);
+  return sqrt(sumW2);
+
+}
+
+/**
+Integrate the HyperHistogram over a region, also summing the sumW2
+(see integral)
+*/
+double HyperHistogram::integral(const HyperCuboid& region, double& sumW2) const{
+
+  sumW2 = 0.0;
+
+  if (region.getDimension() != getDimension()){
+    ERROR_LOG << "HyperHistogram::integral - the region has a different dimensionality to the HyperHistogram" << std::endl;
+    return 0.0;
+  }
+
+  const HyperBinningAggregates* aggregates = getAggregates();
+  if (aggregates != 0) return aggregates->integral(region, *_binning, sumW2);
+
+  double integral = 0.0;
+
+  for (int bin = 0; bin < getNBins(); bin++){
+    double fraction = HyperBinningAggregates::getFractionInside(_binning->getBinHyperVolume(bin), region);
+    if (fraction == 0.0) continue;
+    integral += fraction*getBinContent(bin);
+    sumW2    += fraction*fraction*getBinError(bin)*getBinError(bin);
+  }
+
+  return integral;
+
+}
+
 /**
 Get the bin content where the given HyperPoint lies
 */
@@ -320,6 +415,109 @@ void HyperHistogram::fill(const HyperPointSet& points){
 
 }
 
+/**
+Fill the HyperHistogram with every HyperPoint provided by a 
+HyperPointSetChunkSource, chunkSize points at a time. Only two chunks
+are ever held in memory, so the source can be much larger than
+the available RAM. Each chunk is sorted into bins with the batched 
+BinningBase::getBinNum(const HyperPointSet&), which is much faster than
+one lookup per point for disk resident binnings. If overlapIO is true,
+the next chunk is read on a separate thread while the current one
+is being sorted into bins. Weight 0 of each point is used.
+*/
+void HyperHistogram::fill(HyperPointSetChunkSource& source, int chunkSize, bool overlapIO){
+
+  if (source.getDimension() != getDimension()){
+    ERROR_LOG << "HyperHistogram::fill - the chunk source has a different dimensionality to the HyperHistogram" << std::endl;
+    return;
+  }
+  if (chunkSize <= 0){
+    ERROR_LOG << "HyperHistogram::fill - the chunk size must be positive" << std::endl;
+    return;
+  }
+
+  //The reading thread does ROOT I/O while this one may also
+  //be reading (from a disk resident binning)
+  if (overlapIO) ROOT::EnableThreadSafety();
+
+  typedef std::chrono::steady_clock Clock;
+  Clock::time_point start = Clock::now();
+  double ioWaitSeconds = 0.0;
+
+  HyperPointSetColumns chunkA(source.getDimension(), source.getNumWeights());
+  HyperPointSetColumns chunkB(source.getDimension(), source.getNumWeights());
+  chunkA.reserve(chunkSize);
+  chunkB.reserve(chunkSize);
+
+  HyperPointSetColumns* current = &chunkA;
+  HyperPointSetColumns* next    = &chunkB;
+
+  HyperPointSet points(getDimension());
+  points.reserve(chunkSize);
+
+  Long64_t nTotal  = source.getNumEntries();
+  Long64_t nFilled = 0;
+  int      nChunks = 0;
+
+  //only show progress if the source knows how many points it has
+  int nChunksTotal = nTotal > 0 ? int( (nTotal + chunkSize - 1)/chunkSize ) : 1;
+  LoadingBar loadingbar(nChunksTotal);
+
+  int nRead = source.readChunk(*current, chunkSize);
+
+  while (nRead != 0){
+
+    std::future<int> nextRead;
+    if (overlapIO) {
+      nextRead = std::async(std::launch::async, &HyperPointSetChunkSource::readChunk, &source, std::ref(*next), chunkSize);
+    }
+
+    points.clear();
+    current->appendTo(points);
+
+    std::vector<int> binNums = _binning->getBinNum(points);
+
+    for (int i = 0; i < nRead; i++){
+      this->fillBase(binNums.at(i), current->weight(i, 0));
+    }
+
+    nFilled += nRead;
+    nChunks++;
+
+    Clock::time_point waitStart = Clock::now();
+    if (overlapIO) nRead = nextRead.get();
+    else           nRead = source.readChunk(*next, chunkSize);
+    ioWaitSeconds += std::chrono::duration<double>(Clock::now() - waitStart).count();
+
+    std::swap(current, next);
+
+    if (nTotal > 0 && nChunks <= nChunksTotal) loadingbar.update(nChunks - 1);
+
+  }
+
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+  INFO_LOG << "Streamed " << nFilled << " HyperPoints into the HyperHistogram in " << seconds << "s";
+  if (seconds > 0.0) INFO_LOG << " (" << nFilled/seconds << " HyperPoints/s)";
+  INFO_LOG << std::endl;
+  INFO_LOG << "Time spent waiting for chunks to be read: " << ioWaitSeconds << "s" << std::endl;
+
+}
+
+/**
+Fill the HyperHistogram from a HyperPointSet file (either the
+columnar or the original format) without loading the whole file
+into memory. See fill(HyperPointSetChunkSource&, int, bool).
+*/
+void HyperHistogram::fillFromFile(TString filename, int chunkSize, bool overlapIO){
+
+  HyperPointSetReader reader(filename);
+  if (reader.isOpen() == false) return;
+
+  fill(reader, chunkSize, overlapIO);
+
+}
+
 
 /**
 Get the limits of the histogram
@@ -344,6 +542,12 @@ void HyperHistogram::merge( const HistogramBase& other ){
     return;    
   }
 
+  //if the binnings are identical, just add up the contents
+  if ( hasSameBinning(*histOther) ){
+    mergeContents(*histOther);
+    return;
+  }
+
   _binning->mergeBinnings( histOther->getBinning() );
   HistogramBase::merge( other );
   
@@ -370,31 +574,130 @@ Merge this histogram with another in a file
 */
 void HyperHistogram::merge( TString filenameother ){
 
+  //if the binning saved in the file has the same fingerprint,
+  //only the bin contents need to be read
+
+  ULong64_t fingerprint = HyperBinning::readFingerprint(filenameother);
+
+  if (fingerprint != 0 && fingerprint == _binning->getFingerprint()){
+    addBase(filenameother);
+    return;
+  }
+
   HyperHistogram other(filenameother, "DISK");
   merge( other );
 
 }
 
+/**
+Merge this histogram with others in several files, one at a time.
+Files whose binning is identical to this one's (see hasSameBinning)
+only have their bin contents read, so merging many job outputs that
+share a binning never loads the binning again.
+*/
+void HyperHistogram::merge( const std::vector<TString>& filenames ){
+
+  for (unsigned i = 0; i < filenames.size(); i++){
+    INFO_LOG << "Loading and merging HyperHistogram at: " << filenames.at(i) << std::endl;
+    merge( filenames.at(i) );
+  }
+
+}
+
+/**
+Are the binnings of the two histograms identical? This compares
+the binning fingerprints (see HyperBinning::getFingerprint), which
+are saved with the binning, so this is usually quick.
+*/
+bool HyperHistogram::hasSameBinning(const HyperHistogram& other) const{
+
+  if (_binning == other._binning) return true;
+  if (getNBins() != other.getNBins()) return false;
+
+  ULong64_t fingerprint = _binning->getFingerprint();
+
+  return fingerprint != 0 && fingerprint == other._binning->getFingerprint();
+
+}
+
+/**
+Add the bin contents (and sumW2) of a histogram with an identical
+binning to this one's. The binning is left as it is.
+*/
+void HyperHistogram::mergeContents(const HyperHistogram& other){
+
+  if (hasSameBinning(other) == false){
+    ERROR_LOG << "HyperHistogram::mergeContents - the histograms don't have the same binning. Doing nothing." << std::endl;
+    return;
+  }
+
+  add(other);
+
+}
+
 
 /**
 Set the bin contents of the histogram using parsed function.
 Will set bin errors to zero and use bin centers for evaluating
-function
+function. The function is evaluated at all the bin centers
+in one go (see HyperFunction::getVals)
 */
 void HyperHistogram::setContentsFromFunc(const HyperFunction& func){
   
   int nbins = getNBins();
+
+  HyperPointSet binCenters( getDimension() );
+  binCenters.reserve(nbins);
+
+  for (int i = 0; i < nbins; i++){
+    binCenters.push_back( _binning->getBinHyperVolume(i).getAverageCenter() );
+  }
+
+  std::vector<double> funcVals = func.getVals(binCenters);
   
   for (int i = 0; i < nbins; i++){
-    HyperPoint binCenter = _binning->getBinHyperVolume(i).getAverageCenter();
-    double funcVal = func.getVal(binCenter);
-    setBinContent(i, funcVal);
+    setBinContent(i, funcVals.at(i));
     setBinError  (i, 0  );
   }
   
 
 }
 
+/**
+Set the bin contents of the histogram to the integral of the parsed
+function over each bin, and the bin errors to the uncertainty on each
+integral. The integrals are found with randomised quasi-Monte-Carlo
+(see HyperFunctionIntegrator), adding points until the error is less
+than precision times the integral, or maxPointsPerBin is reached.
+The limit is for the whole bin - a bin made of several HyperCuboids 
+shares it between them by volume (though each HyperCuboid always gets 
+the first HyperFunctionIntegrator::s_minPoints points of each shift).
+Bins are integrated in parallel if func.getNumThreads() is more than one.
+*/
+void HyperHistogram::setContentsFromFuncIntegral(const HyperFunction& func, double precision, int maxPointsPerBin, UInt_t seed){
+  
+  int nbins = getNBins();
+
+  std::vector<HyperVolume> binVolumes;
+  binVolumes.reserve(nbins);
+
+  for (int i = 0; i < nbins; i++){
+    binVolumes.push_back( _binning->getBinHyperVolume(i) );
+  }
+
+  HyperFunctionIntegrator integrator(func, precision, maxPointsPerBin, seed);
+
+  std::vector<double> integrals;
+  std::vector<double> errors;
+  integrator.integrate(binVolumes, integrals, errors);
+  
+  for (int i = 0; i < nbins; i++){
+    setBinContent(i, integrals.at(i));
+    setBinError  (i, errors   .at(i));
+  }
+
+}
+
 
 
 
@@ -686,6 +989,47 @@ void HyperHistogram::project(TH1D* histogram, const HyperCuboid& cuboid, double
 
 }
 
+/**
+Project the HyperHistogram using the hierarchy aggregates. Any HyperVolume
+that lies inside a single bin of the TH1D is added in one go, so only the 
+bins that straddle the TH1D bin edges are projected one by one. This gives 
+the same bin contents as projecting every bin, but fewer calls to TH1D::Fill,
+so the number of entries (and the sum of weights^2, if the TH1D keeps it) 
+are different - project() sets the errors to zero either way.
+*/
+void HyperHistogram::projectAggregates(TH1D* histogram, const HyperBinningAggregates& aggregates, int dimension) const{
+
+  const std::vector<int>& roots = aggregates.getRoots();
+  std::vector<int> stack(roots.rbegin(), roots.rend());
+
+  while (stack.empty() == false){
+
+    int vol = stack.back();
+    stack.pop_back();
+
+    if (aggregates.getNumBins(vol) == 0) continue;
+
+    double lowEdge  = aggregates.getLowEdge (vol, dimension);
+    double highEdge = aggregates.getHighEdge(vol, dimension);
+
+    if (histogram->GetXaxis()->FindFixBin(lowEdge) == histogram->GetXaxis()->FindFixBin(highEdge)){
+      histogram->Fill(lowEdge, aggregates.getContent(vol));
+      continue;
+    }
+
+    int bin = aggregates.getBinNumber(vol);
+
+    if (bin != -1){
+      project(histogram, _binning->getBinHyperVolume(bin), this->getBinContent(bin), dimension);
+      continue;
+    }
+
+    for (int c = aggregates.getNumChildren(vol) - 1; c >= 0; c--) stack.push_back(aggregates.getChild(vol, c));
+
+  }
+
+}
+
 /**
  \todo remember how this works
 */
@@ -858,6 +1202,37 @@ void HyperHistogram::drawRandom2DSlice(TString path, TRandom* random, TString op
 
 }
 
+/**
+Draws a set of slices (already taken) in a RenderPool
+*/
+class SliceDrawJob : public RenderJob {
+
+  std::vector<HyperHistogram>& _hists;
+  const std::vector<TString>&  _paths;
+  TString _options;
+
+  public:
+
+  SliceDrawJob(std::vector<HyperHistogram>& hists, const std::vector<TString>& paths, TString options) :
+    _hists(hists), _paths(paths), _options(options)
+  {}
+
+  void render(int i){ _hists.at(i).draw(_paths.at(i), _options); }
+
+  bool canFork() const{
+    for (unsigned i = 0; i < _hists.size(); i++){
+      if (_hists.at(i).isDiskResident()) return false;
+    }
+    return true;
+  }
+
+};
+
+/**
+Draw nSlices 2D slices, in sliceDimX and sliceDimY, spread evenly along 
+sliceSetDim. The slices are all taken first, then drawn by a RenderPool 
+so several can be drawn at once (see RenderPool::s_numWorkers).
+*/
 void HyperHistogram::draw2DSliceSet(TString path, int sliceDimX, int sliceDimY, int sliceSetDim, int nSlices, const HyperPoint& slicePoint, TString options) const{
 
   std::vector<int   > _sliceDims;
@@ -895,9 +1270,9 @@ void HyperHistogram::draw2DSliceSet(TString path, int sliceDimX, int sliceDimY,
   
   std::vector<HyperHistogram> hists = slice(_sliceDims, slicePoints);
   
-  for (unsigned i = 0; i < hists.size(); i++){
-    hists.at(i).draw(paths.at(i), options);
-  }
+  SliceDrawJob job(hists, paths, options);
+  RenderPool pool;
+  pool.run(hists.size(), job);
 
 }
 
@@ -951,9 +1326,9 @@ void HyperHistogram::draw2DSliceSet(TString path, int sliceDimX, int sliceDimY,
   
   std::vector<HyperHistogram> hists = slice(sliceDims, slicePoints);
   
-  for (unsigned i = 0; i < hists.size(); i++){
-    hists.at(i).draw(paths.at(i), options);
-  }
+  SliceDrawJob job(hists, paths, options);
+  RenderPool pool;
+  pool.run(hists.size(), job);
 
   
   
@@ -994,8 +1369,15 @@ TH1D HyperHistogram::project(int dim, int bins, TString name) const{
   TH1D projection(name, name, bins, lowEdge, highEdge);
   projection.GetXaxis()->SetTitle(_binning->getNames().at(dim));
 
-  for(int i = 0; i < _binning->getNumBins(); i++){
-    project(&projection, _binning->getBinHyperVolume(i), this->getBinContent(i), dim);
+  const HyperBinningAggregates* aggregates = getAggregates();
+
+  if (aggregates != 0) {
+    projectAggregates(&projection, *aggregates, dim);
+  }
+  else{
+    for(int i = 0; i < _binning->getNumBins(); i++){
+      project(&projection, _binning->getBinHyperVolume(i), this->getBinContent(i), dim);
+    }
   }
   
   for (int i = 1; i <= projection.GetNbinsX(); i++){
@@ -1074,6 +1456,35 @@ void HyperHistogram::save(TString filename){
 
 }
 
+/**
+Save the HyperHistogram to a TFile, using the compact
+format for the binning (see HyperBinning::saveCompact)
+*/
+void HyperHistogram::saveCompact(TString filename){
+
+  if ( _binning->getBinningType() != "HyperBinning" ){
+    ERROR_LOG << "It is only possible to saveCompact when using HyperBinning. Saving normally." << std::endl;
+    save(filename);
+    return;
+  }
+
+  TFile* file = new TFile(filename, "RECREATE");
+
+  if (file == 0){
+    ERROR_LOG << "Could not open TFile in HyperHistogram::saveCompact(" << filename << ")";
+    return;
+  }
+
+  //save the bin contents
+  this->saveBase();
+  //save the binning
+  dynamic_cast<const HyperBinning*>(_binning)->saveCompact();
+
+  file->Write();
+  file->Close();
+
+}
+
 /**
 Save the HyperHistogram to a .txt file
 */
@@ -1200,6 +1611,13 @@ TString HyperHistogram::getBinningType(TString filename){
     return "HyperBinning";
   }
 
+  TTree* compactTree = (TTree*)file->Get("HyperBinningCompact");
+
+  if (compactTree != 0){
+    file->Close();
+    return "HyperBinningCompact";
+  }
+
   file->Close();
   return "";
 
@@ -1222,6 +1640,12 @@ void HyperHistogram::load(TString filename, TString option){
       _binning = 0;
     }
 
+    //files saved with saveCompact can only be memory resident
+    if (option.Contains("DISK") && binningType == "HyperBinningCompact"){
+      INFO_LOG << "HyperHistogram::load - " << filename << " uses the compact format, so loading it into memory" << std::endl;
+      option = "MEMRES";
+    }
+
     if (option.Contains("DISK")) _binning = new HyperBinningDiskRes();
     else{
       _binning = new HyperBinningMemRes();
@@ -0,0 +1,279 @@
+#include "HyperHistogramGenerator.h"
+
+// std includes
+#include <thread>
+#include <algorithm>
+
+
+///Build a generator for the contents of a HyperHistogram
+///
+HyperHistogramGenerator::HyperHistogramGenerator(const HyperHistogram& histogram) :
+  _dimension(histogram.getBinning().getDimension()),
+  _numBins(histogram.getBinning().getNumBins())
+{
+  WELCOME_LOG << "Good day from the HyperHistogramGenerator() Constructor";
+
+  std::vector<double> probs(_numBins);
+  for (int bin = 0; bin < _numBins; bin++) probs.at(bin) = histogram.getBinContent(bin);
+
+  buildAliasTable(probs);
+  copyBins(histogram.getBinning());
+}
+
+///Build a generator for bin contents given separately from
+///the binning (they must have the same number of bins)
+HyperHistogramGenerator::HyperHistogramGenerator(const BinningBase& binning, const HistogramBase& contents) :
+  _dimension(binning.getDimension()),
+  _numBins(binning.getNumBins())
+{
+  WELCOME_LOG << "Good day from the HyperHistogramGenerator() Constructor";
+
+  if (contents.getNBins() != _numBins){
+    ERROR_LOG << "HyperHistogramGenerator - the binning and contents have different numbers of bins" << std::endl;
+    _numBins = 0;
+  }
+
+  std::vector<double> probs(_numBins);
+  for (int bin = 0; bin < _numBins; bin++) probs.at(bin) = contents.getBinContent(bin);
+
+  buildAliasTable(probs);
+  copyBins(binning);
+}
+
+///Build the alias table (using Vose's method). The bins are split
+///into those with more, and less, than the average probability. Each
+///small bin is topped up by a large one, which becomes its alias.
+///Negative bin contents are treated as zero.
+void HyperHistogramGenerator::buildAliasTable(const std::vector<double>& probs){
+
+  int n = probs.size();
+
+  double total = 0.0;
+  bool   negative = false;
+  for (int i = 0; i < n; i++){
+    if (probs.at(i) > 0.0) total += probs.at(i);
+    else if (probs.at(i) < 0.0) negative = true;
+  }
+
+  if (negative){
+    ERROR_LOG << "HyperHistogramGenerator - bins with negative contents will never be generated" << std::endl;
+  }
+
+  if (total <= 0.0){
+    ERROR_LOG << "HyperHistogramGenerator - the histogram is empty, so no events can be generated" << std::endl;
+    _numBins = 0;
+    _aliasProb.clear();
+    _alias    .clear();
+    return;
+  }
+
+  _aliasProb.assign(n, 0.0);
+  _alias    .assign(n, 0);
+
+  std::vector<double> scaled(n);
+  std::vector<int>    small;
+  std::vector<int>    large;
+
+  for (int i = 0; i < n; i++){
+    scaled.at(i) = probs.at(i) > 0.0 ? probs.at(i)*n/total : 0.0;
+    if (scaled.at(i) < 1.0) small.push_back(i);
+    else                    large.push_back(i);
+  }
+
+  while (small.empty() == false && large.empty() == false){
+    int s = small.back(); small.pop_back();
+    int l = large.back();
+
+    _aliasProb.at(s) = scaled.at(s);
+    _alias    .at(s) = l;
+
+    scaled.at(l) -= 1.0 - scaled.at(s);
+    if (scaled.at(l) < 1.0){
+      large.pop_back();
+      small.push_back(l);
+    }
+  }
+
+  //anything left over is (up to rounding) exactly average
+
+  for (unsigned i = 0; i < large.size(); i++) { _aliasProb.at(large.at(i)) = 1.0; _alias.at(large.at(i)) = large.at(i); }
+  for (unsigned i = 0; i < small.size(); i++) { _aliasProb.at(small.at(i)) = 1.0; _alias.at(small.at(i)) = small.at(i); }
+
+}
+
+///Copy the corners of every HyperCuboid in every bin, and find how
+///much of its bin's volume each one holds
+void HyperHistogramGenerator::copyBins(const BinningBase& binning){
+
+  _cuboidOffsets.assign(1, 0);
+  _cuboidCdf.clear();
+  _low      .clear();
+  _width    .clear();
+
+  for (int bin = 0; bin < _numBins; bin++){
+
+    HyperVolume volume = binning.getBinHyperVolume(bin);
+
+    double binVolume = volume.volume();
+    double cumulative = 0.0;
+
+    for (int i = 0; i < volume.size(); i++){
+      const HyperCuboid& cuboid = volume.at(i);
+      for (int d = 0; d < _dimension; d++){
+        _low  .push_back(cuboid.getLowCorner().at(d));
+        _width.push_back(cuboid.getWidth(d));
+      }
+      cumulative += cuboid.volume();
+      _cuboidCdf.push_back(binVolume > 0.0 ? cumulative/binVolume : 1.0);
+    }
+
+    _cuboidOffsets.push_back(_cuboidCdf.size());
+  }
+
+}
+
+///Change the bin contents that events are generated from (the bins
+///themselves stay the same). Only the alias table is rebuilt.
+void HyperHistogramGenerator::setBinContents(const std::vector<double>& contents){
+
+  int nBins = _cuboidOffsets.size() - 1;
+
+  if ((int)contents.size() != nBins){
+    ERROR_LOG << "HyperHistogramGenerator::setBinContents - expected " << nBins << " bin contents, not " << contents.size() << std::endl;
+    return;
+  }
+
+  _numBins = nBins;
+  buildAliasTable(contents);
+
+}
+
+///Pick a bin, with a probability proportional to its content.
+///This takes the same time however many bins there are.
+int HyperHistogramGenerator::generateBin(TRandom* random) const{
+
+  int bin = random->Integer(_numBins);
+  if (random->Rndm() < _aliasProb[bin]) return bin;
+  return _alias[bin];
+
+}
+
+///Pick a point uniformly within a bin, and put its coordinates
+///in coords (which must have space for getDimension() values)
+void HyperHistogramGenerator::generatePoint(int bin, TRandom* random, double* coords) const{
+
+  int first = _cuboidOffsets[bin];
+  int last  = _cuboidOffsets[bin + 1] - 1;
+  int cuboid = first;
+
+  if (last > first){
+    double r = random->Rndm();
+    while (cuboid < last && r > _cuboidCdf[cuboid]) cuboid++;
+  }
+
+  const double* low   = &_low  [cuboid*_dimension];
+  const double* width = &_width[cuboid*_dimension];
+
+  for (int d = 0; d < _dimension; d++) coords[d] = low[d] + width[d]*random->Rndm();
+
+}
+
+///Generate nEvents, and write them into points first to first + nEvents - 1,
+///which must already exist (see HyperPointSetColumns::resize). Any weights
+///are set to one.
+void HyperHistogramGenerator::generate(HyperPointSetColumns& points, int first, int nEvents, TRandom* random) const{
+
+  if (points.getDimension() != _dimension){
+    ERROR_LOG << "HyperHistogramGenerator::generate - the points have a different dimension to the histogram" << std::endl;
+    return;
+  }
+  if (first < 0 || nEvents < 0 || first + nEvents > points.size()){
+    ERROR_LOG << "HyperHistogramGenerator::generate - there isn't space for " << nEvents << " events from " << first << std::endl;
+    return;
+  }
+  if (_numBins == 0 || nEvents == 0) return;
+
+  std::vector<double*> columns(_dimension);
+  for (int d = 0; d < _dimension; d++) columns.at(d) = &points.getColumn(d).at(0);
+
+  std::vector<double> coords(_dimension);
+
+  for (int i = first; i < first + nEvents; i++){
+    generatePoint(generateBin(random), random, &coords.at(0));
+    for (int d = 0; d < _dimension; d++) columns[d][i] = coords[d];
+  }
+
+  for (int w = 0; w < points.getNumWeights(); w++){
+    std::vector<double>& weights = points.getWeightColumn(w);
+    std::fill(weights.begin() + first, weights.begin() + first + nEvents, 1.0);
+  }
+
+}
+
+///Generate nEvents, and add them to the end of a HyperPointSet
+///
+void HyperHistogramGenerator::generate(HyperPointSet& points, int nEvents, TRandom* random) const{
+
+  if (points.getDimension() != _dimension){
+    ERROR_LOG << "HyperHistogramGenerator::generate - the points have a different dimension to the histogram" << std::endl;
+    return;
+  }
+  if (_numBins == 0) return;
+
+  points.reserve(points.size() + nEvents);
+
+  HyperPoint point(_dimension);
+
+  for (int i = 0; i < nEvents; i++){
+    generatePoint(generateBin(random), random, &point.at(0));
+    points.push_back(point);
+  }
+
+}
+
+///Generate nEvents into a new HyperPointSetColumns
+///
+HyperPointSetColumns HyperHistogramGenerator::generate(int nEvents, TRandom* random) const{
+
+  HyperPointSetColumns points(_dimension);
+  points.resize(nEvents);
+  generate(points, 0, nEvents, random);
+  return points;
+
+}
+
+///Fill every point in points (which should already be the size
+///wanted) using several threads. The points are split into one
+///block per thread, and thread t uses its own TRandom3 seeded with
+///seed + t + 1, so the result only depends on the seed and number
+///of threads. If nThreads is 0, there's one thread per core.
+void HyperHistogramGenerator::generateParallel(HyperPointSetColumns& points, int nThreads, UInt_t seed) const{
+
+  if (nThreads < 1) nThreads = std::thread::hardware_concurrency();
+  if (nThreads < 1) nThreads = 1;
+
+  int nEvents = points.size();
+  if (nThreads > nEvents) nThreads = nEvents < 1 ? 1 : nEvents;
+
+  std::vector<std::thread> threads;
+
+  for (int t = 0; t < nThreads; t++){
+
+    int first = (int)( (Long64_t)nEvents*t      /nThreads );
+    int last  = (int)( (Long64_t)nEvents*(t + 1)/nThreads );
+
+    threads.push_back( std::thread( [this, &points, first, last, seed, t](){
+      TRandom3 random(seed + t + 1);
+      generate(points, first, last - first, &random);
+    } ) );
+  }
+
+  for (unsigned t = 0; t < threads.size(); t++) threads.at(t).join();
+
+}
+
+///Destructor
+///
+HyperHistogramGenerator::~HyperHistogramGenerator(){
+  GOODBYE_LOG << "Goodbye from the HyperHistogramGenerator() Destructor";
+}
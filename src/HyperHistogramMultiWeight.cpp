@@ -0,0 +1,378 @@
+#include "HyperHistogramMultiWeight.h"
+#include "HyperPointSetReader.h"
+#include "BulkTreeReader.h"
+
+// Root includes
+#include "TFile.h"
+#include "TTree.h"
+
+// std includes
+#include <cmath>
+
+
+///Make an empty histogram with numWeights sets of contents
+///over the binning given (which is copied)
+HyperHistogramMultiWeight::HyperHistogramMultiWeight(const BinningBase& binning, int numWeights) :
+  _binning(binning.clone()),
+  _nBins(binning.getNumBins()),
+  _numWeights(numWeights)
+{
+  WELCOME_LOG << "Good day from the HyperHistogramMultiWeight() Constructor";
+
+  if (_numWeights < 1){
+    ERROR_LOG << "HyperHistogramMultiWeight - there must be at least one weight" << std::endl;
+    _numWeights = 1;
+  }
+
+  clear();
+}
+
+///Load a histogram saved with save(TString filename)
+///
+HyperHistogramMultiWeight::HyperHistogramMultiWeight(TString filename) :
+  _binning(0),
+  _nBins(0),
+  _numWeights(1)
+{
+  WELCOME_LOG << "Good day from the HyperHistogramMultiWeight() Constructor";
+
+  load(filename);
+}
+
+///Check if it's a valid bin number, if not
+///return the overflow/underflow bin
+int HyperHistogramMultiWeight::checkBinNumber(int bin) const{
+  if (bin == -1) return _nBins;
+  if (bin > _nBins || bin < 0){
+    ERROR_LOG << "Bin " << bin << " does not exist! Adding to underflow/overflow bin " << _nBins << std::endl;
+    return _nBins;
+  }
+  return bin;
+}
+
+///Add one event to a bin - weights must hold getNumWeights()
+///values, one for each set of contents
+void HyperHistogramMultiWeight::fillBin(int bin, const double* weights){
+
+  bin = checkBinNumber(bin);
+
+  double* contents = &_binContents[bin*_numWeights];
+  double* sumW2    = &_sumW2      [bin*_numWeights];
+
+  for (int w = 0; w < _numWeights; w++){
+    contents[w] += weights[w];
+    sumW2   [w] += weights[w]*weights[w];
+  }
+
+}
+
+///Fill with a HyperPoint, using weights 0 to getNumWeights() - 1.
+///A HyperPoint without any weights adds one to every set of contents.
+int HyperHistogramMultiWeight::fill(const HyperPoint& coords){
+
+  int nW = coords.numWeights();
+
+  std::vector<double> weights(_numWeights, 1.0);
+
+  if (nW != 0 && nW < _numWeights){
+    ERROR_LOG << "HyperHistogramMultiWeight::fill - the HyperPoint only has " << nW << " of the " << _numWeights << " weights needed" << std::endl;
+    return -1;
+  }
+
+  for (int w = 0; w < _numWeights && nW != 0; w++) weights.at(w) = coords.getWeight(w);
+
+  int binNumber = _binning->getBinNum(coords);
+  fillBin(binNumber, &weights.at(0));
+  return binNumber;
+}
+
+///Fill with every HyperPoint in a HyperPointSet. The bin numbers
+///are all found at once (see BinningBase::getBinNum(const HyperPointSet&)).
+void HyperHistogramMultiWeight::fill(const HyperPointSet& points){
+
+  int nPoints = points.size();
+  if (nPoints == 0) return;
+
+  std::vector<int> binNums = _binning->getBinNum(points);
+
+  std::vector<double> weights(_numWeights, 1.0);
+
+  for (int i = 0; i < nPoints; i++){
+
+    const HyperPoint& point = points.at(i);
+    int nW = point.numWeights();
+
+    if (nW != 0 && nW < _numWeights){
+      ERROR_LOG << "HyperHistogramMultiWeight::fill - HyperPoint " << i << " only has " << nW << " of the " << _numWeights << " weights needed" << std::endl;
+      continue;
+    }
+
+    for (int w = 0; w < _numWeights; w++) weights[w] = nW == 0 ? 1.0 : point.getWeight(w);
+
+    fillBin(binNums.at(i), &weights.at(0));
+  }
+
+}
+
+///Fill with every point in a HyperPointSetColumns, which must
+///have at least getNumWeights() weights (or none at all)
+void HyperHistogramMultiWeight::fill(const HyperPointSetColumns& points){
+
+  int nPoints = points.size();
+  int nW      = points.getNumWeights();
+
+  if (nPoints == 0) return;
+
+  if (nW != 0 && nW < _numWeights){
+    ERROR_LOG << "HyperHistogramMultiWeight::fill - the points only have " << nW << " of the " << _numWeights << " weights needed" << std::endl;
+    return;
+  }
+
+  std::vector<int> binNums = _binning->getBinNum(points);
+
+  std::vector<const double*> columns(_numWeights, 0);
+  for (int w = 0; w < _numWeights && nW != 0; w++) columns.at(w) = &points.getWeightColumn(w).at(0);
+
+  std::vector<double> weights(_numWeights, 1.0);
+
+  for (int i = 0; i < nPoints; i++){
+    if (nW != 0){
+      for (int w = 0; w < _numWeights; w++) weights[w] = columns[w][i];
+    }
+    fillBin(binNums.at(i), &weights.at(0));
+  }
+
+}
+
+///Fill with every point provided by a HyperPointSetChunkSource,
+///chunkSize points at a time, so the source can be much larger
+///than the available RAM
+void HyperHistogramMultiWeight::fill(HyperPointSetChunkSource& source, int chunkSize){
+
+  if (source.getDimension() != _binning->getDimension()){
+    ERROR_LOG << "HyperHistogramMultiWeight::fill - the chunk source has a different dimensionality to the histogram" << std::endl;
+    return;
+  }
+  if (chunkSize <= 0){
+    ERROR_LOG << "HyperHistogramMultiWeight::fill - the chunk size must be positive" << std::endl;
+    return;
+  }
+
+  HyperPointSetColumns chunk(source.getDimension(), source.getNumWeights());
+  chunk.reserve(chunkSize);
+
+  Long64_t nFilled = 0;
+
+  while (source.readChunk(chunk, chunkSize) != 0){
+    fill(chunk);
+    nFilled += chunk.size();
+  }
+
+  INFO_LOG << "Filled the HyperHistogramMultiWeight with " << nFilled << " HyperPoints" << std::endl;
+
+}
+
+///Fill from a HyperPointSet file (either the columnar or the
+///original format) without loading the whole file into memory
+void HyperHistogramMultiWeight::fillFromFile(TString filename, int chunkSize){
+
+  HyperPointSetReader reader(filename);
+  if (reader.isOpen() == false) return;
+
+  fill(reader, chunkSize);
+
+}
+
+///Get the content of a bin, for one of the weights
+///
+double HyperHistogramMultiWeight::getBinContent(int bin, int weight) const{
+  if (weight < 0 || weight >= _numWeights){
+    ERROR_LOG << "HyperHistogramMultiWeight::getBinContent - there is no weight " << weight << std::endl;
+    return 0.0;
+  }
+  return _binContents.at(checkBinNumber(bin)*_numWeights + weight);
+}
+
+///Get the error on a bin (sqrt of the sum of weights^2), for
+///one of the weights
+double HyperHistogramMultiWeight::getBinError(int bin, int weight) const{
+  if (weight < 0 || weight >= _numWeights){
+    ERROR_LOG << "HyperHistogramMultiWeight::getBinError - there is no weight " << weight << std::endl;
+    return 0.0;
+  }
+  return sqrt( _sumW2.at(checkBinNumber(bin)*_numWeights + weight) );
+}
+
+///Set every bin content and sum of weights^2 to zero
+///
+void HyperHistogramMultiWeight::clear(){
+  _binContents.assign( (_nBins + 1)*_numWeights, 0.0 );
+  _sumW2      .assign( (_nBins + 1)*_numWeights, 0.0 );
+}
+
+///Copy the contents for one weight into a HyperHistogram
+///(with a copy of the binning). This is a copy, not a view - changing
+///it doesn't change this histogram until it's passed to setVariation.
+HyperHistogram HyperHistogramMultiWeight::getVariation(int weight) const{
+
+  HyperHistogram hist(*_binning);
+
+  if (weight < 0 || weight >= _numWeights){
+    ERROR_LOG << "HyperHistogramMultiWeight::getVariation - there is no weight " << weight << std::endl;
+    return hist;
+  }
+
+  for (int bin = 0; bin <= _nBins; bin++){
+    hist.setBinContent(bin, _binContents.at(bin*_numWeights + weight));
+    hist.setBinError  (bin, sqrt( _sumW2.at(bin*_numWeights + weight) ));
+  }
+
+  return hist;
+
+}
+
+///Replace the contents for one weight with those of a histogram
+///with the same number of bins (e.g. one from getVariation)
+void HyperHistogramMultiWeight::setVariation(int weight, const HistogramBase& hist){
+
+  if (weight < 0 || weight >= _numWeights){
+    ERROR_LOG << "HyperHistogramMultiWeight::setVariation - there is no weight " << weight << std::endl;
+    return;
+  }
+  if (hist.getNBins() != _nBins){
+    ERROR_LOG << "HyperHistogramMultiWeight::setVariation - the histogram has " << hist.getNBins() << " bins, not " << _nBins << std::endl;
+    return;
+  }
+
+  for (int bin = 0; bin <= _nBins; bin++){
+    double error = hist.getBinError(bin);
+    _binContents.at(bin*_numWeights + weight) = hist.getBinContent(bin);
+    _sumW2      .at(bin*_numWeights + weight) = error*error;
+  }
+
+}
+
+///Save to a TFile. The contents for weight 0 are saved like a
+///HyperHistogram's, and every set of contents is saved in the TTree
+///"HyperHistogramMultiWeight" (branches binContent_w and sumW2_w).
+void HyperHistogramMultiWeight::save(TString filename) const{
+
+  TFile* file = new TFile(filename, "RECREATE");
+
+  if (file == 0){
+    ERROR_LOG << "Could not open TFile in HyperHistogramMultiWeight::save(" << filename << ")";
+    return;
+  }
+
+  //weight 0 as a normal HyperHistogram
+  HistogramBase nominal(_nBins);
+  for (int bin = 0; bin <= _nBins; bin++){
+    nominal.setBinContent(bin, _binContents.at(bin*_numWeights));
+    nominal.setBinError  (bin, sqrt( _sumW2.at(bin*_numWeights) ));
+  }
+  nominal.saveBase();
+
+  TTree tree("HyperHistogramMultiWeight", "HyperHistogramMultiWeight");
+
+  int binNumber = -1;
+  std::vector<double> contents(_numWeights, 0.0);
+  std::vector<double> sumW2   (_numWeights, 0.0);
+
+  tree.Branch("binNumber", &binNumber);
+
+  for (int w = 0; w < _numWeights; w++){
+    TString contentName = "binContent_"; contentName += w;
+    TString sumW2Name   = "sumW2_"     ; sumW2Name   += w;
+    tree.Branch(contentName, &contents.at(w));
+    tree.Branch(sumW2Name  , &sumW2   .at(w));
+  }
+
+  for (int bin = 0; bin <= _nBins; bin++){
+    binNumber = bin;
+    for (int w = 0; w < _numWeights; w++){
+      contents.at(w) = _binContents.at(bin*_numWeights + w);
+      sumW2   .at(w) = _sumW2      .at(bin*_numWeights + w);
+    }
+    tree.Fill();
+  }
+
+  tree.Write();
+
+  _binning->save();
+
+  file->Write();
+  file->Close();
+
+}
+
+///Load from a TFile written by save(TString filename). The binning
+///is loaded into memory, and the contents read in bulk (see BulkTreeReader).
+void HyperHistogramMultiWeight::load(TString filename){
+
+  HyperHistogram nominal(filename, "MEMRES READ");
+
+  delete _binning;
+  _binning = nominal.getBinning().clone();
+  _nBins   = _binning->getNumBins();
+
+  //count the weights saved
+
+  TFile* file = new TFile(filename, "READ");
+
+  if (file == 0 || file->IsZombie()){
+    ERROR_LOG << "Could not open TFile in HyperHistogramMultiWeight::load(" << filename << ")";
+    return;
+  }
+
+  TTree* tree = dynamic_cast<TTree*>( file->Get("HyperHistogramMultiWeight") );
+
+  int numWeights = 0;
+  if (tree != 0){
+    while (true){
+      TString contentName = "binContent_"; contentName += numWeights;
+      if (tree->GetBranch(contentName) == 0) break;
+      numWeights++;
+    }
+  }
+
+  file->Close();
+
+  if (numWeights == 0){
+    ERROR_LOG << "HyperHistogramMultiWeight::load - " << filename << " has no HyperHistogramMultiWeight contents, so only using its HyperHistogram contents" << std::endl;
+    _numWeights = 1;
+    clear();
+    setVariation(0, nominal);
+    return;
+  }
+
+  _numWeights = numWeights;
+  clear();
+
+  BulkTreeReader reader(filename, "HyperHistogramMultiWeight");
+
+  if (reader.getNumEntries() != _nBins + 1){
+    ERROR_LOG << "HyperHistogramMultiWeight::load - " << filename << " has " << reader.getNumEntries() << " bins saved, not " << _nBins + 1 << std::endl;
+    return;
+  }
+
+  //the bins are saved in order, so read each weight straight into place
+
+  for (int w = 0; w < _numWeights; w++){
+    TString contentName = "binContent_"; contentName += w;
+    TString sumW2Name   = "sumW2_"     ; sumW2Name   += w;
+    reader.addColumn(contentName, &_binContents.at(w), _numWeights);
+    reader.addColumn(sumW2Name  , &_sumW2      .at(w), _numWeights);
+  }
+
+  if (reader.read() == false){
+    ERROR_LOG << "HyperHistogramMultiWeight::load - could not load the bin contents from " << filename << std::endl;
+  }
+
+}
+
+///Destructor
+///
+HyperHistogramMultiWeight::~HyperHistogramMultiWeight(){
+  delete _binning;
+  GOODBYE_LOG << "Goodbye from the HyperHistogramMultiWeight() Destructor";
+}
@@ -1,4 +1,5 @@
 #include "HyperPointSet.h"
+#include "HyperPointSetReader.h"
 
 ///Standard constuctor where only the dimensionality is given
 ///
@@ -92,6 +93,18 @@ void HyperPointSet::push_back(const HyperPoint& point){
   _points.push_back(point); 
 } 
 
+///Reserve space for npoints HyperPoints in the HyperPointSet
+///
+void HyperPointSet::reserve(unsigned int npoints){ 
+  _points.reserve(npoints); 
+} 
+
+///Remove all HyperPoints from the HyperPointSet (the
+///dimensionality and the reserved space are kept)
+void HyperPointSet::clear(){ 
+  _points.clear(); 
+} 
+
 
 ///Find the Sum of weights for all HyperPoints in the HyperPointSet
 ///
@@ -355,46 +368,49 @@ void HyperPointSet::save(){
 
 }
 
+///Save the HyperPointSet to a file (opened with RECREATE) using
+///the columnar format - one branch for each dimension and each
+///weight. All HyperPoints must have the same number of weights.
+///This is much faster to read back than the format used by save().
+void HyperPointSet::saveColumnar(TString path) const{
+
+  HyperPointSetColumns columns(*this);
+  columns.save(path);
+
+}
+
 ///Load exisiting HyperPointSet from a file.
 ///HyperPoints are appended to the end of the
-//HyperPointSet, so multiple files can be loaded
+//HyperPointSet, so multiple files can be loaded.
+//Either the columnar format or the original format
+//can be loaded - the file is read in chunks. In the
+//original format each point keeps its own weights,
+//even if they have different numbers of them.
 void HyperPointSet::load(TString path){
   
-  TFile* file = new TFile(path, "READ");
-  if (file == 0) {
-    ERROR_LOG << "Cannot open file at " << path;
+  HyperPointSetReader reader(path);
+  if (reader.isOpen() == false) return;
+  if (reader.getNumEntries() == 0) return;
+
+  if (_dimension == -1) _dimension = reader.getDimension();
+  if (reader.getDimension() != _dimension) {
+    ERROR_LOG << "You are loading HyperPoints that do not have the correct dimensionality for this HyperPointSet";
     return;
   }
 
-  TTree* tree = (TTree*)file->Get("HyperPointSet");
-  if (tree == 0) {
-    ERROR_LOG << "Cannot open tree";
+  reserve( size() + reader.getNumEntries() );
+
+  if (reader.isColumnar() == false){
+    while ( reader.readPoints(*this, 100000) != 0 );
     return;
   }
-  
-  std::vector<double>*  values  = 0;
-  std::vector<double>*  weights = 0;
 
-  tree->SetBranchAddress("values" , &values );
-  tree->SetBranchAddress("weights", &weights);
-  
-  int nEntries = tree->GetEntries();
-
-  for(int i = 0; i < nEntries; i++ ){
-    tree->GetEntry(i);
-    
-    if (_dimension == -1) _dimension = values->size();
-    if ( int(values->size()) != _dimension) ERROR_LOG << "You are loading HyperPoints that do not have the correct dimensionality for this HyperPointSet";
+  HyperPointSetColumns chunk(reader.getDimension(), reader.getNumWeights());
+  chunk.reserve(100000);
 
-    HyperPoint point(*values);
-    for(unsigned w = 0; w < weights->size(); w++){
-      point.addWeight(weights->at(w));
-    }
-    this->push_back(point);
+  while ( reader.readChunk(chunk, 100000) != 0 ){
+    chunk.appendTo(*this);
   }
-  
-  tree->ResetBranchAddresses();
-  file->Close();
 
 }
 
@@ -0,0 +1,189 @@
+#include "HyperPointSetColumns.h"
+
+///Constructor for an empty set of columns with a given
+///dimensionality and number of weights per point
+HyperPointSetColumns::HyperPointSetColumns(int dimension, int numWeights) :
+  _dimension (dimension),
+  _numWeights(numWeights),
+  _size      (0),
+  _values    (dimension ),
+  _weights   (numWeights)
+{
+  WELCOME_LOG << "Hello from the HyperPointSetColumns() Constructor";
+}
+
+///Constructor that copies a HyperPointSet into columns. All
+///HyperPoints must have the same number of weights (taken from
+///the first HyperPoint).
+HyperPointSetColumns::HyperPointSetColumns(const HyperPointSet& points) :
+  _dimension (points.getDimension()),
+  _numWeights(points.size() == 0 ? 0 : points.at(0).numWeights()),
+  _size      (0),
+  _values    (_dimension ),
+  _weights   (_numWeights)
+{
+  WELCOME_LOG << "Hello from the HyperPointSetColumns() Constructor";
+
+  reserve(points.size());
+  for (unsigned i = 0; i < points.size(); i++) push_back(points.at(i));
+}
+
+///Reserve space in every column for npoints
+///
+void HyperPointSetColumns::reserve(int npoints){
+  for (int i = 0; i < _dimension ; i++) _values .at(i).reserve(npoints);
+  for (int i = 0; i < _numWeights; i++) _weights.at(i).reserve(npoints);
+}
+
+///Resize every column to hold npoints. Memory is only ever
+///allocated when npoints exceeds the current capacity, so
+///repeatedly resizing a chunk buffer does not reallocate.
+void HyperPointSetColumns::resize(int npoints){
+  for (int i = 0; i < _dimension ; i++) _values .at(i).resize(npoints);
+  for (int i = 0; i < _numWeights; i++) _weights.at(i).resize(npoints);
+  _size = npoints;
+}
+
+///Remove all points (the capacity of the columns is kept)
+///
+void HyperPointSetColumns::clear(){
+  resize(0);
+}
+
+///Get weight w of a point. If no weights are stored, 1.0
+///is returned for w = 0 (the same convention as Weights).
+double HyperPointSetColumns::weight(int point, int w) const{
+  if (_numWeights == 0 && w == 0) return 1.0;
+  return _weights.at(w).at(point);
+}
+
+///Add a HyperPoint to the end of the columns
+///
+void HyperPointSetColumns::push_back(const HyperPoint& point){
+
+  if (point.getDimension() != _dimension){
+    ERROR_LOG << "HyperPointSetColumns::push_back - this HyperPoint has the wrong dimensionality" << std::endl;
+    return;
+  }
+  if (point.numWeights() != _numWeights){
+    ERROR_LOG << "HyperPointSetColumns::push_back - this HyperPoint has " << point.numWeights();
+    ERROR_LOG << " weights, but I am storing " << _numWeights << std::endl;
+    return;
+  }
+
+  for (int i = 0; i < _dimension ; i++) _values .at(i).push_back( point.at(i)        );
+  for (int i = 0; i < _numWeights; i++) _weights.at(i).push_back( point.getWeight(i) );
+  _size++;
+
+}
+
+///Fill a HyperPoint with point i. The HyperPoint passed must
+///have the correct dimensionality - this saves constructing
+///a new HyperPoint each time.
+void HyperPointSetColumns::getHyperPoint(int i, HyperPoint& point) const{
+  for (int d = 0; d < _dimension ; d++) point.at(d) = _values.at(d).at(i);
+  for (int w = 0; w < _numWeights; w++) point.setWeight(w, _weights.at(w).at(i));
+}
+
+///Get point i as a HyperPoint
+///
+HyperPoint HyperPointSetColumns::getHyperPoint(int i) const{
+  HyperPoint point(_dimension);
+  getHyperPoint(i, point);
+  return point;
+}
+
+///Append all points to the end of a HyperPointSet
+///
+void HyperPointSetColumns::appendTo(HyperPointSet& points) const{
+
+  if (points.getDimension() != _dimension){
+    ERROR_LOG << "HyperPointSetColumns::appendTo - the HyperPointSet has the wrong dimensionality" << std::endl;
+    return;
+  }
+
+  HyperPoint point(_dimension);
+  for (int i = 0; i < _size; i++){
+    getHyperPoint(i, point);
+    points.push_back(point);
+  }
+
+}
+
+///Get the name of the branch that holds coordinate dim
+///
+TString HyperPointSetColumns::getValueBranchName(int dim){
+  TString name = "value_";
+  name += dim;
+  return name;
+}
+
+///Get the name of the branch that holds weight w
+///
+TString HyperPointSetColumns::getWeightBranchName(int w){
+  TString name = "weight_";
+  name += w;
+  return name;
+}
+
+///Save the columns to a file (opened with RECREATE)
+///
+void HyperPointSetColumns::save(TString path) const{
+
+  TFile* file = new TFile(path, "RECREATE");
+
+  if (file == 0) {
+    ERROR_LOG << "Cannot open file at " << path;
+    return;
+  }
+
+  save();
+
+  file->Write();
+  file->Close();
+
+}
+
+///Save the columns to the file currently in scope. There
+///is one fixed size branch of doubles for each dimension and
+///each weight, so no std::vector needs to be streamed for
+///each entry when reading back.
+void HyperPointSetColumns::save() const{
+
+  TTree* tree = new TTree(getTreeName(), getTreeName());
+
+  if (tree == 0) {
+    ERROR_LOG << "Cannot create tree";
+    return;
+  }
+
+  std::vector<double> values (_dimension , 0.0);
+  std::vector<double> weights(_numWeights, 0.0);
+
+  for (int i = 0; i < _dimension; i++){
+    TString name = getValueBranchName(i);
+    tree->Branch(name, &values.at(i), name + "/D");
+  }
+  for (int i = 0; i < _numWeights; i++){
+    TString name = getWeightBranchName(i);
+    tree->Branch(name, &weights.at(i), name + "/D");
+  }
+
+  for (int p = 0; p < _size; p++){
+    for (int i = 0; i < _dimension ; i++) values .at(i) = _values .at(i).at(p);
+    for (int i = 0; i < _numWeights; i++) weights.at(i) = _weights.at(i).at(p);
+    tree->Fill();
+  }
+
+  tree->ResetBranchAddresses();
+
+  tree->Write();
+
+}
+
+///Destructor
+///
+HyperPointSetColumns::~HyperPointSetColumns(){
+  GOODBYE_LOG << "Goodbye from the HyperPointSetColumns() Destructor";
+}
+
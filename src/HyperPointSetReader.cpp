@@ -0,0 +1,235 @@
+#include "HyperPointSetReader.h"
+
+///Open a HyperPointSet file for reading. If the file contains
+///a columnar tree this is used, otherwise the original
+///HyperPointSet tree is used.
+HyperPointSetReader::HyperPointSetReader(TString path) :
+  _file        (0),
+  _tree        (0),
+  _columnar    (false),
+  _dimension   (-1),
+  _numWeights  (0),
+  _numEntries  (0),
+  _currentEntry(0),
+  _values      (0),
+  _weights     (0),
+  _ignoredWeights(false)
+{
+  WELCOME_LOG << "Hello from the HyperPointSetReader() Constructor";
+
+  _file = new TFile(path, "READ");
+  if (_file == 0 || _file->IsZombie()) {
+    ERROR_LOG << "Cannot open file at " << path;
+    return;
+  }
+
+  _tree = (TTree*)_file->Get(HyperPointSetColumns::getTreeName());
+  if (_tree != 0){
+    _columnar = true;
+    openColumnar();
+  }
+  else {
+    _tree = (TTree*)_file->Get("HyperPointSet");
+    if (_tree == 0) {
+      ERROR_LOG << "Cannot open tree";
+      return;
+    }
+    openVector();
+  }
+
+  //The TTreeCache makes ROOT read the baskets of each branch
+  //in a few large reads rather than one small read per entry
+  _tree->SetCacheSize(32*1024*1024);
+  _tree->AddBranchToCache("*", true);
+
+}
+
+///Find out the dimensionality and number of weights by counting
+///the branches, then set up one scalar address per branch
+void HyperPointSetReader::openColumnar(){
+
+  _numEntries = _tree->GetEntries();
+
+  _dimension = 0;
+  while ( _tree->GetBranch( HyperPointSetColumns::getValueBranchName(_dimension) ) != 0 ) _dimension++;
+
+  _numWeights = 0;
+  while ( _tree->GetBranch( HyperPointSetColumns::getWeightBranchName(_numWeights) ) != 0 ) _numWeights++;
+
+  _valueBuffer .resize(_dimension , 0.0);
+  _weightBuffer.resize(_numWeights, 0.0);
+
+  for (int i = 0; i < _dimension; i++){
+    TBranch* branch = _tree->GetBranch( HyperPointSetColumns::getValueBranchName(i) );
+    branch->SetAddress(&_valueBuffer.at(i));
+    _valueBranches.push_back(branch);
+  }
+  for (int i = 0; i < _numWeights; i++){
+    TBranch* branch = _tree->GetBranch( HyperPointSetColumns::getWeightBranchName(i) );
+    branch->SetAddress(&_weightBuffer.at(i));
+    _weightBranches.push_back(branch);
+  }
+
+}
+
+///Set up the std::vector addresses for the original format. The
+///dimensionality and number of weights are taken from the first entry.
+void HyperPointSetReader::openVector(){
+
+  _numEntries = _tree->GetEntries();
+
+  _tree->SetBranchAddress("values" , &_values );
+  _tree->SetBranchAddress("weights", &_weights);
+
+  if (_numEntries == 0) return;
+
+  _tree->GetEntry(0);
+  _dimension  = _values ->size();
+  _numWeights = _weights->size();
+
+}
+
+///Go back to the first entry in the file
+///
+void HyperPointSetReader::rewind(){
+  _currentEntry = 0;
+}
+
+///Read the next chunkSize points (or however many are left) into
+///chunk, replacing its contents. Returns the number of points read,
+///which is zero once the end of the file has been reached.
+int HyperPointSetReader::readChunk(HyperPointSetColumns& chunk, int chunkSize){
+
+  if (isOpen() == false) return 0;
+
+  if (chunk.getDimension() != _dimension || chunk.getNumWeights() != _numWeights){
+    ERROR_LOG << "HyperPointSetReader::readChunk - the chunk has a different dimensionality or number of weights to the file" << std::endl;
+    return 0;
+  }
+
+  Long64_t remaining = _numEntries - _currentEntry;
+  int nEntries = remaining < chunkSize ? int(remaining) : chunkSize;
+
+  chunk.resize(nEntries);
+
+  if (nEntries <= 0) return 0;
+
+  if (_columnar) return readChunkColumnar(chunk, nEntries);
+  return readChunkVector(chunk, nEntries);
+
+}
+
+///Columnar format - each branch is read for the whole chunk in
+///turn, so the baskets of one column are decompressed and copied
+///in one go, straight into the contiguous column of the chunk.
+int HyperPointSetReader::readChunkColumnar(HyperPointSetColumns& chunk, int nEntries){
+
+  for (int d = 0; d < _dimension; d++){
+    TBranch* branch = _valueBranches.at(d);
+    double* column  = &chunk.getColumn(d).at(0);
+    for (int i = 0; i < nEntries; i++){
+      branch->GetEntry(_currentEntry + i);
+      column[i] = _valueBuffer[d];
+    }
+  }
+
+  for (int w = 0; w < _numWeights; w++){
+    TBranch* branch = _weightBranches.at(w);
+    double* column  = &chunk.getWeightColumn(w).at(0);
+    for (int i = 0; i < nEntries; i++){
+      branch->GetEntry(_currentEntry + i);
+      column[i] = _weightBuffer[w];
+    }
+  }
+
+  _currentEntry += nEntries;
+
+  return nEntries;
+}
+
+///Original format - each entry has to be read as a whole. The
+///points can have different numbers of weights, but the chunk has
+///the number of the first point - missing weights are set to 1 (as 
+///for an unweighted HyperPoint) and extra ones are ignored. Points 
+///with the wrong dimensionality are skipped, so fewer than nEntries
+///points may be put in the chunk.
+int HyperPointSetReader::readChunkVector(HyperPointSetColumns& chunk, int nEntries){
+
+  int nRead = 0;
+
+  for (int i = 0; i < nEntries; i++){
+    _tree->GetEntry(_currentEntry + i);
+
+    if ( int(_values->size()) != _dimension ){
+      ERROR_LOG << "You are loading HyperPoints that do not have the correct dimensionality for this HyperPointSet" << std::endl;
+      continue;
+    }
+
+    int nWeights = _weights->size();
+    if (nWeights > _numWeights && _ignoredWeights == false){
+      ERROR_LOG << "HyperPointSetReader::readChunk - some points have more weights than the first, and only the first " 
+                << _numWeights << " are kept (use HyperPointSetReader::readPoints to keep them all)" << std::endl;
+      _ignoredWeights = true;
+    }
+
+    for (int d = 0; d < _dimension ; d++) chunk.value (nRead, d) = _values->at(d);
+    for (int w = 0; w < _numWeights; w++) chunk.weight(nRead, w) = w < nWeights ? _weights->at(w) : 1.0;
+    nRead++;
+  }
+
+  _currentEntry += nEntries;
+
+  //zero means the end of the file, so don't return it early
+  if (nRead == 0) return readChunk(chunk, nEntries);
+
+  chunk.resize(nRead);
+
+  return nRead;
+}
+
+///Append the next nPoints points to a HyperPointSet, each with
+///however many weights it was saved with. Returns the number of
+///entries read, which is zero once the end of the file has been
+///reached. Points with the wrong dimensionality aren't added.
+int HyperPointSetReader::readPoints(HyperPointSet& points, int nPoints){
+
+  if (isOpen() == false) return 0;
+
+  Long64_t remaining = _numEntries - _currentEntry;
+  int nEntries = remaining < nPoints ? int(remaining) : nPoints;
+
+  if (nEntries <= 0) return 0;
+
+  if (_columnar){
+    HyperPointSetColumns chunk(_dimension, _numWeights);
+    nEntries = readChunk(chunk, nEntries);
+    chunk.appendTo(points);
+    return nEntries;
+  }
+
+  for (int i = 0; i < nEntries; i++){
+    _tree->GetEntry(_currentEntry + i);
+
+    HyperPoint point(*_values);
+    for (unsigned w = 0; w < _weights->size(); w++) point.addWeight(_weights->at(w));
+    points.push_back(point);
+  }
+
+  _currentEntry += nEntries;
+
+  return nEntries;
+}
+
+///Destructor - closes the file
+///
+HyperPointSetReader::~HyperPointSetReader(){
+
+  if (_tree != 0) _tree->ResetBranchAddresses();
+  if (_file != 0) {
+    _file->Close();
+    delete _file;
+  }
+
+  GOODBYE_LOG << "Goodbye from the HyperPointSetReader() Destructor";
+}
+
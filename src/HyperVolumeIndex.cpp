@@ -0,0 +1,249 @@
+#include "HyperVolumeIndex.h"
+
+#include <algorithm>
+
+///Helper used to sort entries along one dimension by the
+///centre of their bounding box
+struct HyperVolumeIndexCentreLess {
+  const std::vector<double>& _low;
+  const std::vector<double>& _high;
+  int _dimension;
+  int _dim;
+
+  HyperVolumeIndexCentreLess(const std::vector<double>& low, const std::vector<double>& high, int dimension, int dim) :
+    _low(low), _high(high), _dimension(dimension), _dim(dim) {}
+
+  bool operator()(int a, int b) const{
+    return (_low[a*_dimension + _dim] + _high[a*_dimension + _dim]) < (_low[b*_dimension + _dim] + _high[b*_dimension + _dim]);
+  }
+};
+
+///Constructor for an empty index
+///
+HyperVolumeIndex::HyperVolumeIndex(int dimension) :
+  _dimension(dimension)
+{
+  _cuboidStart.push_back(0);
+}
+
+///Remove all volumes, and set the dimensionality
+///
+void HyperVolumeIndex::clear(int dimension){
+  _dimension = dimension;
+  _volumeNumbers.clear();
+  _cuboidStart  .clear();
+  _cuboidLow    .clear();
+  _cuboidHigh   .clear();
+  _entryLow     .clear();
+  _entryHigh    .clear();
+  _order        .clear();
+  _nodeLow      .clear();
+  _nodeHigh     .clear();
+  _nodeFirst    .clear();
+  _nodeCount    .clear();
+  _nodeLeft     .clear();
+  _nodeRight    .clear();
+  _nodeMinEntry .clear();
+  _cuboidStart.push_back(0);
+}
+
+///Add a volume to the index. build() needs to be called
+///once all volumes have been added.
+void HyperVolumeIndex::addVolume(int volumeNumber, const HyperVolume& volume){
+
+  if (volume.getDimension() != _dimension){
+    ERROR_LOG << "HyperVolumeIndex::addVolume - HyperVolume has the wrong dimensionality" << std::endl;
+    return;
+  }
+
+  _volumeNumbers.push_back(volumeNumber);
+
+  for (int d = 0; d < _dimension; d++){
+    _entryLow .push_back(volume.size() == 0 ?  0.0 : volume.getMin(d));
+    _entryHigh.push_back(volume.size() == 0 ? -1.0 : volume.getMax(d));
+  }
+
+  for (int i = 0; i < volume.size(); i++){
+    const HyperCuboid& cuboid = volume.at(i);
+    for (int d = 0; d < _dimension; d++){
+      _cuboidLow .push_back(cuboid.getLowCorner ().at(d));
+      _cuboidHigh.push_back(cuboid.getHighCorner().at(d));
+    }
+  }
+
+  _cuboidStart.push_back( _cuboidLow.size()/(_dimension == 0 ? 1 : _dimension) );
+
+}
+
+///Build the hierarchy. Entries are split in half (at the median
+///centre) along the dimension where their centres are most
+///spread out, until there are at most s_leafSize in each node.
+void HyperVolumeIndex::build(){
+
+  int nEntries = size();
+
+  _order.resize(nEntries);
+  for (int i = 0; i < nEntries; i++) _order.at(i) = i;
+
+  _nodeLow     .clear();
+  _nodeHigh    .clear();
+  _nodeFirst   .clear();
+  _nodeCount   .clear();
+  _nodeLeft    .clear();
+  _nodeRight   .clear();
+  _nodeMinEntry.clear();
+
+  if (nEntries == 0) return;
+
+  buildNode(0, nEntries);
+
+}
+
+///Make a node from the entries _order[first, first + count),
+///and return its node number
+int HyperVolumeIndex::buildNode(int first, int count){
+
+  int node = _nodeFirst.size();
+
+  _nodeFirst   .push_back(first);
+  _nodeCount   .push_back(count);
+  _nodeLeft    .push_back(-1);
+  _nodeRight   .push_back(-1);
+  _nodeMinEntry.push_back(_order.at(first));
+
+  //box around every entry in the node, and the spread of their centres
+
+  std::vector<double> low   (_dimension,  0.0);
+  std::vector<double> high  (_dimension,  0.0);
+  std::vector<double> minCen(_dimension,  0.0);
+  std::vector<double> maxCen(_dimension,  0.0);
+
+  for (int i = 0; i < count; i++){
+    int entry = _order.at(first + i);
+    if (entry < _nodeMinEntry.at(node)) _nodeMinEntry.at(node) = entry;
+
+    for (int d = 0; d < _dimension; d++){
+      double lo  = _entryLow .at(entry*_dimension + d);
+      double hi  = _entryHigh.at(entry*_dimension + d);
+      double cen = lo + hi;
+      if (i == 0 || lo  < low   .at(d)) low   .at(d) = lo;
+      if (i == 0 || hi  > high  .at(d)) high  .at(d) = hi;
+      if (i == 0 || cen < minCen.at(d)) minCen.at(d) = cen;
+      if (i == 0 || cen > maxCen.at(d)) maxCen.at(d) = cen;
+    }
+  }
+
+  _nodeLow .insert(_nodeLow .end(), low .begin(), low .end());
+  _nodeHigh.insert(_nodeHigh.end(), high.begin(), high.end());
+
+  if (count <= s_leafSize) return node;
+
+  int    splitDim = 0;
+  double spread   = -1.0;
+  for (int d = 0; d < _dimension; d++){
+    if (maxCen.at(d) - minCen.at(d) > spread) { spread = maxCen.at(d) - minCen.at(d); splitDim = d; }
+  }
+
+  int half = count/2;
+  std::nth_element(_order.begin() + first, _order.begin() + first + half, _order.begin() + first + count,
+                   HyperVolumeIndexCentreLess(_entryLow, _entryHigh, _dimension, splitDim));
+
+  int left  = buildNode(first       , half        );
+  int right = buildNode(first + half, count - half);
+
+  _nodeLeft .at(node) = left;
+  _nodeRight.at(node) = right;
+
+  return node;
+}
+
+///Is the HyperPoint inside a (closed) box
+///
+bool HyperVolumeIndex::inBox(const double* low, const double* high, const HyperPoint& coords) const{
+  for (int d = 0; d < _dimension; d++){
+    double x = coords.at(d);
+    if ( (low[d] <= x && x <= high[d]) == false ) return false;
+  }
+  return true;
+}
+
+///Is the HyperPoint inside one of the HyperCuboids of an
+///entry. Uses the same convention as HyperCuboid::inVolume
+///(low < x <= high).
+bool HyperVolumeIndex::inEntry(int entry, const HyperPoint& coords) const{
+
+  for (int c = _cuboidStart.at(entry); c < _cuboidStart.at(entry + 1); c++){
+    const double* low  = &_cuboidLow .at(c*_dimension);
+    const double* high = &_cuboidHigh.at(c*_dimension);
+
+    bool inCuboid = true;
+    for (int d = 0; d < _dimension; d++){
+      double x = coords.at(d);
+      if ( (low[d] < x && x <= high[d]) == false ) { inCuboid = false; break; }
+    }
+    if (inCuboid) return true;
+  }
+
+  return false;
+}
+
+///Find the first volume (in the order they were added) that
+///contains the HyperPoint, and return its volume number. Returns
+///-1 if no volume contains it.
+int HyperVolumeIndex::findVolume(const HyperPoint& coords) const{
+
+  if (_nodeFirst.size() == 0) return -1;
+
+  if (coords.getDimension() != _dimension){
+    ERROR_LOG << "HyperVolumeIndex::findVolume - HyperPoint has the wrong dimensionality" << std::endl;
+    return -1;
+  }
+
+  int bestEntry = size();
+
+  int stack[128];
+  int stackSize = 0;
+  stack[stackSize++] = 0;
+
+  while (stackSize > 0){
+
+    int node = stack[--stackSize];
+
+    //nothing in this node can beat what has already been found
+    if (_nodeMinEntry[node] >= bestEntry) continue;
+
+    if ( inBox(&_nodeLow[node*_dimension], &_nodeHigh[node*_dimension], coords) == false ) continue;
+
+    if (_nodeLeft[node] == -1){
+      for (int i = 0; i < _nodeCount[node]; i++){
+        int entry = _order[_nodeFirst[node] + i];
+        if (entry < bestEntry && inEntry(entry, coords)) bestEntry = entry;
+      }
+      continue;
+    }
+
+    //visit the child with the lowest entry first, so the
+    //other can usually be skipped
+    int first  = _nodeLeft [node];
+    int second = _nodeRight[node];
+    if (_nodeMinEntry[second] < _nodeMinEntry[first]) std::swap(first, second);
+
+    if (stackSize + 2 > 128) {
+      ERROR_LOG << "HyperVolumeIndex::findVolume - hierarchy is too deep" << std::endl;
+      return -1;
+    }
+
+    stack[stackSize++] = second;
+    stack[stackSize++] = first;
+  }
+
+  if (bestEntry == size()) return -1;
+  return _volumeNumbers.at(bestEntry);
+}
+
+///Destructor
+///
+HyperVolumeIndex::~HyperVolumeIndex(){
+
+}
+
@@ -1,75 +1,170 @@
 #include "MessageService.h"
 
+// std includes
+#include <cstdlib>
 
-MessageSerivce* MessageSerivce::s_messageService = 0;
+
+std::atomic<bool> MessageSerivce::s_outputOptions[5] = { {false}, {true}, {true}, {false}, {false} };
 
 ///Static function to retrive the MessageSerivce singleton.
-///At the same time, also change the state of the MessageSerivce.
-MessageSerivce& MessageSerivce::getMessageService(ErrorType errorType){
-  
-  //if the singleton doesn't exist, return make it
-  if (s_messageService == 0){
-  	s_messageService = new MessageSerivce();
-  }
+///It's made the first time this is called (which is thread safe)
+///and never deleted, so it can be used from any destructor.
+MessageSerivce& MessageSerivce::getMessageService(){
   
-  //See if we should be printing the error type given.
-  //Set the _printOrNot variable accordingly 
-  s_messageService->_printOrNot = s_messageService->_outputOptions[errorType];
+  static MessageSerivce* messageService = new MessageSerivce();
   
+  //return the singleton
+  return *messageService;
 
+}
 
-  //Set the error type to the one given
-  if ( s_messageService->_printOrNot){
+///Static function to retrive the MessageStream of the calling 
+///thread, after setting the message type to the one given
+MessageStream& MessageSerivce::getMessageStream(ErrorType errorType){
 
-    //if the message type has changed, and no endl was called, then 
-    //force a new line.
-    if (s_messageService->_errorType != errorType && s_messageService->_endlCalled == 0){
-      *s_messageService << std::endl;
-    }
+  static thread_local MessageStream messageStream;
 
-  	s_messageService->_errorType = errorType;
-  }
-  
-  //return the singleton
-  return *s_messageService;
+  messageStream.setErrorType(errorType);
 
-}
- 
-///Static function to retrive the MessageSerivce singleton
-///without altering its message state 
-MessageSerivce& MessageSerivce::getMessageService(){
-  
-  //if the singleton doesn't exist, return make it
-  if (s_messageService == 0){
-  	s_messageService = new MessageSerivce();
-  }
-  
-  //return the singleton
-  return *s_messageService;
+  return messageStream;
 
 }
 
+///Turn printing of a message type on or off
+///
+void MessageSerivce::setOutputOption(ErrorType errorType, bool print){
+  s_outputOptions[errorType].store(print);
+}
 
 ///constuctor
 ///
 MessageSerivce::MessageSerivce() :
+  _bufferSize(0),
+  _writerThread(0),
+  _stopWriter(false),
   _stream(std::cout),
-  _endlCalled(true),
   _errorCount(0)
 {
 
-  _outputOptions[WELCOME] = false;
-  _outputOptions[ERROR  ] = true ;
-  _outputOptions[INFO   ] = true ;
-  _outputOptions[VERBOSE] = false;
-  _outputOptions[GOODBYE] = false;
-
   _outputHeaders[WELCOME] = "HyperPlot Welcome : ";
   _outputHeaders[ERROR  ] = "\033[31mHyperPlot Error : ";
   _outputHeaders[INFO   ] = "\033[32mHyperPlot Info : ";
   _outputHeaders[VERBOSE] = "HyperPlot Verbose : ";
   _outputHeaders[GOODBYE] = "HyperPlot Goodbye : ";
 
+  //the singleton is never deleted, so make sure anything 
+  //left in the buffer is written at the end
+  std::atexit(&MessageSerivce::finalise);
+
+}
+
+///Add some complete lines to the buffer. They are written to the 
+///stream once the buffer is full, or straight away if flushNow is 
+///true (used for errors). When running asynchronously, the writer 
+///thread is woken up instead.
+void MessageSerivce::write(const std::string& lines, bool flushNow){
+
+  bool writeNow = false;
+
+  {
+    std::lock_guard<std::mutex> lock(_bufferMutex);
+    _buffer += lines;
+
+    if (_writerThread != 0){
+      if (flushNow || _buffer.size() >= _bufferSize) _writerCondition.notify_one();
+      return;
+    }
+
+    writeNow = flushNow || _buffer.size() >= _bufferSize;
+  }
+
+  if (writeNow) writeBuffer();
+
+}
+
+///Write everything in the buffer to the stream. The buffer is 
+///swapped out, so other threads can carry on adding to it while
+///this one writes.
+void MessageSerivce::writeBuffer(){
+
+  std::lock_guard<std::mutex> streamLock(_streamMutex);
+
+  std::string lines;
+  {
+    std::lock_guard<std::mutex> lock(_bufferMutex);
+    lines.swap(_buffer);
+  }
+
+  if (lines.size() == 0) return;
+
+  _stream << lines;
+  _stream.flush();
+
+}
+
+///Loop run by the writer thread - waits until there is something
+///to write, then writes it
+void MessageSerivce::writerLoop(){
+
+  while (true){
+
+    {
+      std::unique_lock<std::mutex> lock(_bufferMutex);
+      while (_stopWriter == false && _buffer.size() == 0) _writerCondition.wait(lock);
+      if (_stopWriter == true && _buffer.size() == 0) return;
+    }
+
+    writeBuffer();
+  }
+
+}
+
+///Write anything that's still in the buffer
+///
+void MessageSerivce::flush(){
+  writeBuffer();
+}
+
+///Set how many bytes of messages are collected before they're
+///written to the stream. Zero (the default) writes each line as 
+///soon as it's finished. Errors are always written straight away.
+void MessageSerivce::setBufferSize(size_t nBytes){
+  {
+    std::lock_guard<std::mutex> lock(_bufferMutex);
+    _bufferSize = nBytes;
+  }
+  flush();
+}
+
+///Write the messages from a separate thread, so that the threads
+///producing them never wait for the stream. Turning this off waits
+///for everything in the buffer to be written.
+void MessageSerivce::setAsynchronous(bool asynchronous){
+
+  if (asynchronous == true && _writerThread == 0){
+    std::lock_guard<std::mutex> lock(_bufferMutex);
+    _stopWriter   = false;
+    _writerThread = new std::thread(&MessageSerivce::writerLoop, this);
+  }
+
+  if (asynchronous == false && _writerThread != 0){
+    {
+      std::lock_guard<std::mutex> lock(_bufferMutex);
+      _stopWriter = true;
+    }
+    _writerCondition.notify_one();
+    _writerThread->join();
+    delete _writerThread;
+    _writerThread = 0;
+  }
+
+}
+
+///Called when the program exits - stops the writer thread
+///and writes anything left in the buffer
+void MessageSerivce::finalise(){
+  getMessageService().setAsynchronous(false);
+  getMessageService().flush();
 }
 
 ///print how many errors messages have been sent to the output stream
@@ -79,7 +174,7 @@ void MessageSerivce::printErrorCount(){
   //turns out that it never gets destructed so this doesn't work. Bit of a shame
   if (_errorCount != 0){
   	_errorCount--; //This isn't actually an error, so -1
-  	getMessageService(ERROR) << "There were " << _errorCount << " errors during runtime" << std::endl;
+  	ERROR_LOG << "There were " << _errorCount << " errors during runtime" << std::endl;
   }	
 }
 
@@ -90,9 +185,61 @@ MessageSerivce::~MessageSerivce(){
   //turns out that it never gets destructed so this doesn't work. Bit of a shame
   if (_errorCount != 0){
     _errorCount--;
-  	getMessageService(ERROR) << "There was " << _errorCount << " errors during runtime" << std::endl;
+  	ERROR_LOG << "There was " << _errorCount << " errors during runtime" << std::endl;
+  }
+
+}
+
+
+///constuctor
+///
+MessageStream::MessageStream() :
+  _errorType(MessageSerivce::INFO),
+  _endlCalled(true)
+{
+
+}
+
+///Set the message type. If the message type has changed, and 
+///no endl was called, then force a new line.
+void MessageStream::setErrorType(MessageSerivce::ErrorType errorType){
+
+  if (_errorType != errorType && _endlCalled == false){
+    endLine();
   }
 
+  _errorType = errorType;
+
+}
+
+///Start a new line with the header of the current message type
+///
+void MessageStream::startLine(){
+
+  MessageSerivce& messageService = MessageSerivce::getMessageService();
+
+  _line << messageService._outputHeaders[_errorType];
+  if (_errorType == MessageSerivce::ERROR) messageService._errorCount++;
+  _endlCalled = false;
+
 }
 
+///Finish the current line, and pass it to the MessageSerivce
+///
+void MessageStream::endLine(){
+
+  _line << "\033[0m" << '\n';
+
+  MessageSerivce::getMessageService().write( _line.str(), _errorType == MessageSerivce::ERROR );
+
+  _line.str("");
+  _endlCalled = true;
+
+}
+
+///destuctor - passes on anything that hasn't been 
+///finished with an endl
+MessageStream::~MessageStream(){
+  if (_endlCalled == false) endLine();
+}
 
@@ -0,0 +1,181 @@
+#include "RenderPool.h"
+
+// Root includes
+#include "TROOT.h"
+
+// std includes
+#include <atomic>
+#include <thread>
+#include <new>
+#include <cerrno>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#define RENDERPOOL_HAS_FORK 1
+#else
+#define RENDERPOOL_HAS_FORK 0
+#endif
+
+
+int RenderPool::s_numWorkers = 1;
+
+///Constructor - if numWorkers isn't given, s_numWorkers is used
+///(one by default), and if that's zero, there's one worker per core
+RenderPool::RenderPool(int numWorkers) :
+  _numWorkers(numWorkers)
+{
+  if (_numWorkers < 0) _numWorkers = s_numWorkers;
+  if (_numWorkers < 1) _numWorkers = std::thread::hardware_concurrency();
+  if (_numWorkers < 1) _numWorkers = 1;
+
+  WELCOME_LOG << "Good day from the RenderPool() Constructor";
+}
+
+///Draw plots 0 to nJobs - 1 of the RenderJob. Returns the
+///number that were drawn successfully.
+int RenderPool::run(int nJobs, RenderJob& job){
+
+  if (nJobs <= 0) return 0;
+
+  if (RENDERPOOL_HAS_FORK == 0 || _numWorkers == 1 || nJobs == 1) return runSerial(nJobs, job);
+
+  if (gROOT->IsBatch() == false){
+    VERBOSE_LOG << "RenderPool::run - ROOT isn't in batch mode, so drawing the plots in this process" << std::endl;
+    return runSerial(nJobs, job);
+  }
+
+  if (job.canFork() == false){
+    INFO_LOG << "RenderPool::run - these plots read from open files, so drawing them in this process" << std::endl;
+    return runSerial(nJobs, job);
+  }
+
+  return runParallel(nJobs, job);
+
+}
+
+///Draw the plots one after another in this process
+///
+int RenderPool::runSerial(int nJobs, RenderJob& job){
+
+  for (int i = 0; i < nJobs; i++) job.render(i);
+  return nJobs;
+
+}
+
+///Fork the workers, and wait for them to draw every plot. The next
+///job to draw, and whether each job is finished, are kept in memory
+///shared by all the processes.
+int RenderPool::runParallel(int nJobs, RenderJob& job){
+
+#if RENDERPOOL_HAS_FORK
+
+  enum Status{WAITING, STARTED, DONE};
+
+  int nWorkers = _numWorkers < nJobs ? _numWorkers : nJobs;
+
+  size_t nBytes = sizeof(std::atomic<int>)*(nJobs + 1);
+  void* shared = mmap(0, nBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+  if (shared == MAP_FAILED){
+    ERROR_LOG << "RenderPool::run - could not allocate shared memory, drawing the plots in this process" << std::endl;
+    return runSerial(nJobs, job);
+  }
+
+  std::atomic<int>* nextJob = new (shared) std::atomic<int>(0);
+  std::atomic<int>* status  = nextJob + 1;
+  for (int i = 0; i < nJobs; i++) new (status + i) std::atomic<int>(WAITING);
+
+  //the workers get a copy of anything left in the message buffer,
+  //and don't get the writer thread, so write everything out first
+  MessageSerivce& messageService = MessageSerivce::getMessageService();
+  bool asynchronous = messageService.isAsynchronous();
+  messageService.setAsynchronous(false);
+  messageService.flush();
+
+  std::vector<pid_t> workers;
+
+  for (int w = 0; w < nWorkers; w++){
+
+    pid_t pid = fork();
+
+    if (pid == -1){
+      ERROR_LOG << "RenderPool::run - could only fork " << w << " of " << nWorkers << " workers" << std::endl;
+      break;
+    }
+
+    if (pid == 0){
+
+      //worker process - draw plots until there are none left
+
+      int exitCode = 0;
+
+      try{
+        while (true){
+          int i = nextJob->fetch_add(1);
+          if (i >= nJobs) break;
+          status[i].store(STARTED);
+          job.render(i);
+          status[i].store(DONE);
+        }
+      }
+      catch(...){
+        exitCode = 1;
+      }
+
+      //skip the exit handlers and destructors, which belong to the parent
+      messageService.flush();
+      _exit(exitCode);
+    }
+
+    workers.push_back(pid);
+  }
+
+  //if no workers could be made, the parent draws everything
+
+  if (workers.size() == 0){
+    while (true){
+      int i = nextJob->fetch_add(1);
+      if (i >= nJobs) break;
+      job.render(i);
+      status[i].store(DONE);
+    }
+  }
+
+  for (unsigned w = 0; w < workers.size(); w++){
+    int workerStatus = 0;
+    while (waitpid(workers.at(w), &workerStatus, 0) == -1 && errno == EINTR) {}
+    if (WIFEXITED(workerStatus) == false || WEXITSTATUS(workerStatus) != 0){
+      ERROR_LOG << "RenderPool::run - worker " << w << " didn't finish properly" << std::endl;
+    }
+  }
+
+  int nDone = 0;
+
+  for (int i = 0; i < nJobs; i++){
+    if (status[i].load() == DONE) nDone++;
+    else ERROR_LOG << "RenderPool::run - plot " << i << " was not drawn" << std::endl;
+  }
+
+  munmap(shared, nBytes);
+
+  messageService.setAsynchronous(asynchronous);
+
+  VERBOSE_LOG << "RenderPool::run - " << workers.size() << " workers drew " << nDone << " of " << nJobs << " plots" << std::endl;
+
+  return nDone;
+
+#else
+
+  return runSerial(nJobs, job);
+
+#endif
+
+}
+
+///Destructor
+///
+RenderPool::~RenderPool(){
+  GOODBYE_LOG << "Goodbye from the RenderPool() Destructor";
+}
@@ -0,0 +1,137 @@
+#include "TreeEntryReader.h"
+
+///Constructor for a reader that has nothing to read.
+///
+TreeEntryReader::TreeEntryReader() :
+  _file      (0),
+  _branch    (0),
+  _value     (0),
+  _numEntries(0),
+  _numReads  (0),
+  _failed    (false)
+{
+  WELCOME_LOG << "Hello from the TreeEntryReader() Constructor";
+}
+
+///Constructor that takes the file, tree and branch to read.
+///Nothing is opened until the first entry is read.
+TreeEntryReader::TreeEntryReader(TString filename, TString treeName, TString branchName) :
+  _filename  (filename),
+  _treeName  (treeName),
+  _branchName(branchName),
+  _file      (0),
+  _branch    (0),
+  _value     (0),
+  _numEntries(0),
+  _numReads  (0),
+  _failed    (false)
+{
+  WELCOME_LOG << "Hello from the TreeEntryReader() Constructor";
+}
+
+///Copy constructor. The copy opens its own copy of the file
+///when it's first needed.
+TreeEntryReader::TreeEntryReader(const TreeEntryReader& other) :
+  _filename  (other._filename  ),
+  _treeName  (other._treeName  ),
+  _branchName(other._branchName),
+  _file      (0),
+  _branch    (0),
+  _value     (0),
+  _numEntries(0),
+  _numReads  (other._numReads  ),
+  _failed    (other._failed    )
+{
+}
+
+///Assignment operator. Closes the current file, and opens
+///its own copy of the new one when it's first needed.
+TreeEntryReader& TreeEntryReader::operator=(const TreeEntryReader& other){
+
+  if (this == &other) return *this;
+
+  close();
+
+  _filename   = other._filename;
+  _treeName   = other._treeName;
+  _branchName = other._branchName;
+  _numReads   = other._numReads;
+  _failed     = other._failed;
+
+  return *this;
+
+}
+
+///Open the file and find the branch. Returns false (and won't
+///try again) if either can't be found.
+bool TreeEntryReader::openFile(){
+
+  _file = new TFile(_filename, "READ");
+
+  if (_file == 0 || _file->IsZombie()){
+    ERROR_LOG << "TreeEntryReader - cannot open file at " << _filename << std::endl;
+    close();
+    _failed = true;
+    return false;
+  }
+
+  TTree* tree = dynamic_cast<TTree*>( _file->Get(_treeName) );
+  if (tree != 0) _branch = tree->GetBranch(_branchName);
+
+  if (_branch == 0){
+    ERROR_LOG << "TreeEntryReader - cannot find the branch " << _treeName << "/" << _branchName << " in " << _filename << std::endl;
+    close();
+    _failed = true;
+    return false;
+  }
+
+  _numEntries = tree->GetEntries();
+  _branch->SetAddress(&_value);
+
+  return true;
+
+}
+
+///Read one entry of the branch into value. Returns false if the
+///branch can't be read, or the entry is out of range.
+bool TreeEntryReader::read(Long64_t entry, int& value){
+
+  if (isSet() == false) return false;
+
+  if (_branch == 0 && openFile() == false) return false;
+
+  if (entry < 0 || entry >= _numEntries){
+    ERROR_LOG << "TreeEntryReader::read - entry " << entry << " of " << _treeName << " is out of range" << std::endl;
+    return false;
+  }
+
+  if (_branch->GetEntry(entry) <= 0) return false;
+
+  _numReads++;
+  value = _value;
+
+  return true;
+
+}
+
+///Close the file. It is opened again if another entry is read.
+///
+void TreeEntryReader::close(){
+
+  if (_branch != 0) _branch->SetAddress(0);
+  _branch = 0;
+
+  if (_file != 0){
+    _file->Close();
+    delete _file;
+    _file = 0;
+  }
+
+}
+
+///Destructor
+///
+TreeEntryReader::~TreeEntryReader(){
+  GOODBYE_LOG << "Goodbye from the TreeEntryReader() Constructor";
+  close();
+}
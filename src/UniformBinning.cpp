@@ -157,7 +157,7 @@ int UniformBinning::getLocalBinNumber(int dim, double val) const{
   double nbins  = _nLocalBins            .at(dim);
   double width = (high - low)/nbins; 
   
-  return floor( val - low )/width; 
+  return floor( (val - low)/width );
 
 }
 